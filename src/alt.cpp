@@ -0,0 +1,141 @@
+#include "alt.h"
+#include "mapped_file.h"
+
+#include <cstring>
+#include <type_traits>
+
+namespace chc {
+	namespace {
+		char const MAGIC[8] = {'C', 'H', 'C', 'L', 'M', 'A', 'R', 'K'};
+		uint32_t const VERSION = 1;
+		uint32_t const BYTE_ORDER_CHECK = 0x01020304;
+
+		struct Header
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t byte_order_check;
+			uint64_t nr_of_nodes;
+			uint64_t nr_of_landmarks;
+		};
+
+		static_assert(std::is_trivially_copyable<Header>::value && sizeof(Header) == 32, "unexpected header layout");
+		static_assert(sizeof(uint) == sizeof(uint32_t), "landmark tables store uint as uint32_t");
+
+		[[noreturn]] void invalidFile(std::string const& filename, char const* reason)
+		{
+			std::cerr << "FATAL_ERROR: Invalid landmark file \'" <<
+				filename << "\' (" << reason << "). Exiting." << std::endl;
+			std::abort();
+		}
+	}
+
+	uint LandmarkTable::_lowerBound(uint const* node_dists, uint const* tgt_dists) const
+	{
+		uint bound(0);
+		for (size_t i(0); i < _landmarks.size() * 2; i += 2) {
+			/* d(L, t) - d(L, v) */
+			uint const from_node(node_dists[i]);
+			uint const from_tgt(tgt_dists[i]);
+			if (from_node != c::NO_DIST) {
+				if (from_tgt == c::NO_DIST) return c::NO_DIST;
+				if (from_tgt > from_node) bound = std::max(bound, from_tgt - from_node);
+			}
+
+			/* d(v, L) - d(t, L) */
+			uint const to_node(node_dists[i + 1]);
+			uint const to_tgt(tgt_dists[i + 1]);
+			if (to_tgt != c::NO_DIST) {
+				if (to_node == c::NO_DIST) return c::NO_DIST;
+				if (to_node > to_tgt) bound = std::max(bound, to_node - to_tgt);
+			}
+		}
+		return bound;
+	}
+
+	uint LandmarkTable::lowerBound(NodeID node, NodeID tgt) const
+	{
+		if (_landmarks.empty()) return 0;
+		return _lowerBound(&_dists[_index(node, 0, EdgeType::OUT)], &_dists[_index(tgt, 0, EdgeType::OUT)]);
+	}
+
+	MemoryUsage LandmarkTable::memoryUsage() const
+	{
+		MemoryUsage usage;
+		usage.add("landmarks", chc::memoryUsage(_landmarks));
+		usage.add("dists", chc::memoryUsage(_dists));
+		return usage;
+	}
+
+	void LandmarkTable::write(std::ostream& os) const
+	{
+		Header header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.byte_order_check = BYTE_ORDER_CHECK;
+		header.nr_of_nodes = _nr_of_nodes;
+		header.nr_of_landmarks = _landmarks.size();
+
+		os.write(reinterpret_cast<char const*>(&header), sizeof(header));
+		os.write(reinterpret_cast<char const*>(_landmarks.data()), _landmarks.size() * sizeof(NodeID));
+		os.write(reinterpret_cast<char const*>(_dists.data()), _dists.size() * sizeof(uint));
+	}
+
+	LandmarkTable LandmarkTable::read(std::string const& filename)
+	{
+		MappedFile file(filename);
+
+		Header header;
+		if (file.size() < sizeof(header)) invalidFile(filename, "too small");
+		std::memcpy(&header, file.data(), sizeof(header));
+		if (0 != std::memcmp(header.magic, MAGIC, sizeof(MAGIC))) invalidFile(filename, "wrong magic");
+		if (header.version != VERSION) invalidFile(filename, "unsupported version");
+		if (header.byte_order_check != BYTE_ORDER_CHECK) invalidFile(filename, "wrong byte order");
+
+		uint64_t const landmarks_size(header.nr_of_landmarks * sizeof(NodeID));
+		uint64_t const dists_size(header.nr_of_nodes * header.nr_of_landmarks * 2 * sizeof(uint));
+		if (file.size() != sizeof(header) + landmarks_size + dists_size) invalidFile(filename, "wrong size");
+
+		LandmarkTable table(header.nr_of_nodes);
+		char const* pos(file.data() + sizeof(header));
+		table._landmarks.resize(header.nr_of_landmarks);
+		std::memcpy(table._landmarks.data(), pos, landmarks_size);
+		pos += landmarks_size;
+		table._dists.resize(header.nr_of_nodes * header.nr_of_landmarks * 2);
+		std::memcpy(table._dists.data(), pos, dists_size);
+
+		for (NodeID landmark: table._landmarks) {
+			if (landmark >= table._nr_of_nodes) invalidFile(filename, "landmark out of range");
+		}
+		return table;
+	}
+
+	LandmarkSelection toLandmarkSelection(std::string const& selection)
+	{
+		if (selection == "FARTHEST") {
+			return LandmarkSelection::FARTHEST;
+		}
+		else if (selection == "AVOID") {
+			return LandmarkSelection::AVOID;
+		}
+		else {
+			std::cerr << "Unknown landmark selection: " << selection << "\n";
+		}
+
+		return LandmarkSelection::AVOID;
+	}
+
+	std::string to_string(LandmarkSelection selection)
+	{
+		switch (selection) {
+		case LandmarkSelection::FARTHEST:
+			return "FARTHEST";
+		case LandmarkSelection::AVOID:
+			return "AVOID";
+		}
+
+		std::cerr << "Unknown landmark selection: " << static_cast<int>(selection) << "\n";
+		return "AVOID";
+	}
+}
@@ -0,0 +1,385 @@
+#pragma once
+
+#include "defs.h"
+#include "nodes_and_edges.h"
+#include "graph.h"
+#include "dijkstra.h"
+#include "memory_usage.h"
+
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <queue>
+#include <algorithm>
+
+namespace chc
+{
+
+namespace unit_tests
+{
+	void testALT();
+}
+
+/*
+ * ALT: A* with landmarks and the triangle inequality. For a landmark L the
+ * distances d(L, v) and d(v, L) of all nodes give the lower bounds
+ *
+ *   d(v, t) >= d(L, t) - d(L, v)   and   d(v, t) >= d(v, L) - d(t, L)
+ *
+ * which are consistent, so unlike AStar no node is settled twice. Needs no
+ * contraction, only 2 one-to-all searches per landmark.
+ */
+
+/*
+ * Distances from and to every landmark. The distances of a node are stored
+ * next to each other ({from, to} per landmark), so computing a bound reads
+ * one or two cache lines. c::NO_DIST marks nodes which can't reach (or can't
+ * be reached by) a landmark.
+ */
+class LandmarkTable
+{
+	private:
+		uint _nr_of_nodes = 0;
+		std::vector<NodeID> _landmarks;
+		std::vector<uint> _dists;
+
+		size_t _index(NodeID node, size_t landmark, EdgeType direction) const
+		{
+			return (size_t(node) * _landmarks.size() + landmark) * 2 + from_enum(direction);
+		}
+
+		/* lower bound from the distances of node and tgt (2 per landmark) */
+		uint _lowerBound(uint const* node_dists, uint const* tgt_dists) const;
+
+		template <typename Node, typename Edge>
+		friend class ALT;
+	public:
+		LandmarkTable() { }
+		explicit LandmarkTable(uint nr_of_nodes) : _nr_of_nodes(nr_of_nodes) { }
+
+		/*
+		 * Computes the distances from and to the new landmarks (one search
+		 * per landmark and direction, in parallel) and appends them.
+		 */
+		template <typename Node, typename Edge>
+		void addLandmarks(Graph<Node, Edge> const& g, std::vector<NodeID> const& landmarks);
+
+		uint getNrOfNodes() const { return _nr_of_nodes; }
+		std::vector<NodeID> const& getLandmarks() const { return _landmarks; }
+
+		/* d(landmark, node) for OUT, d(node, landmark) for IN */
+		uint dist(size_t landmark, NodeID node, EdgeType direction) const
+		{
+			return _dists[_index(node, landmark, direction)];
+		}
+
+		/* lower bound of the distance from node to tgt; c::NO_DIST if the
+		 * landmarks prove there is no path */
+		uint lowerBound(NodeID node, NodeID tgt) const;
+
+		MemoryUsage memoryUsage() const;
+
+		/*
+		 * Binary format: a header (magic, version, byte order check, number
+		 * of nodes and landmarks) followed by the landmarks and the distance
+		 * table as uint32_t in native byte order.
+		 */
+		void write(std::ostream& os) const;
+		/* aborts if the file is no valid landmark table */
+		static LandmarkTable read(std::string const& filename);
+};
+
+enum class LandmarkSelection { FARTHEST = 0, AVOID };
+static constexpr LandmarkSelection LastLandmarkSelection = LandmarkSelection::AVOID;
+
+LandmarkSelection toLandmarkSelection(std::string const& selection);
+std::string to_string(LandmarkSelection selection);
+
+/*
+ * Selects up to nr_of_landmarks landmarks and computes their table. The first
+ * landmark is the node farthest from a random root; then
+ *  FARTHEST adds the node farthest from the chosen landmarks,
+ *  AVOID (Goldberg & Werneck) builds the shortest path tree of a random root,
+ *    weights each node by how much its distance is underestimated by the
+ *    current bounds and walks down to a leaf along the heaviest subtrees
+ *    without a landmark, so it covers the regions with the worst bounds.
+ * Nodes not reached from the first landmark are never chosen, so small
+ * components of the graph don't use up landmarks.
+ */
+template <typename Node, typename Edge>
+LandmarkTable selectLandmarks(Graph<Node, Edge> const& g, size_t nr_of_landmarks,
+		LandmarkSelection selection, uint seed = 0);
+
+/*
+ * A* with the bounds of a LandmarkTable (for the same graph) as heuristic.
+ */
+template <typename Node, typename Edge>
+class ALT
+{
+	private:
+		struct PQElement;
+		typedef std::priority_queue<
+			PQElement, std::vector<PQElement>, std::greater<PQElement> > PQ;
+
+		Graph<Node, Edge> const& _g;
+		LandmarkTable const& _table;
+
+		SearchState _state;
+		SearchStats _stats;
+		/* distances of the current target in the table */
+		std::vector<uint> _tgt_dists;
+
+		uint _heuristic(NodeID node) const;
+		void _reset();
+	public:
+		ALT(Graph<Node, Edge> const& g, LandmarkTable const& table);
+
+		/* like Dijkstra::calcShopa */
+		uint calcShopa(NodeID src, NodeID tgt,
+				std::vector<EdgeID>& path);
+
+		SearchStats const& getStats() const { return _stats; }
+};
+
+template <typename Node, typename Edge>
+void LandmarkTable::addLandmarks(Graph<Node, Edge> const& g, std::vector<NodeID> const& landmarks)
+{
+	if (_landmarks.empty()) {
+		_nr_of_nodes = g.getNrOfNodes();
+	}
+	else if (_nr_of_nodes != g.getNrOfNodes()) {
+		std::cerr << "FATAL_ERROR: Landmark table has " << _nr_of_nodes << " nodes, the graph "
+			<< g.getNrOfNodes() << ". Exiting." << std::endl;
+		std::abort();
+	}
+
+	/* the searches write landmark-major columns, one per search, so threads
+	 * don't share cache lines; the columns are transposed afterwards */
+	size_t const nr_of_searches(landmarks.size() * 2);
+	std::vector<uint> columns(nr_of_searches * _nr_of_nodes, c::NO_DIST);
+	#pragma omp parallel
+	{
+		Dijkstra<Node, Edge> dijkstra(g);
+		#pragma omp for schedule(dynamic)
+		for (size_t i = 0; i < nr_of_searches; i++) {
+			uint* column(columns.data() + i * _nr_of_nodes);
+			EdgeType const direction(i % 2 ? EdgeType::IN : EdgeType::OUT);
+			dijkstra.run(landmarks[i / 2], [column](NodeID node, uint dist) {
+				column[node] = dist;
+			}, direction);
+		}
+	}
+
+	/* new node-major layout: the old distances of a node, then the new ones */
+	size_t const old_size(_landmarks.size());
+	std::vector<uint> old_dists(std::move(_dists));
+	_landmarks.insert(_landmarks.end(), landmarks.begin(), landmarks.end());
+	_dists.resize(size_t(_nr_of_nodes) * _landmarks.size() * 2);
+	#pragma omp parallel for schedule(static)
+	for (NodeID node = 0; node < _nr_of_nodes; node++) {
+		uint* row(_dists.data() + _index(node, 0, EdgeType::OUT));
+		row = std::copy_n(old_dists.begin() + size_t(node) * old_size * 2, old_size * 2, row);
+		for (size_t i(0); i < nr_of_searches; i++) {
+			row[i] = columns[i * _nr_of_nodes + node];
+		}
+	}
+}
+
+template <typename Node, typename Edge>
+LandmarkTable selectLandmarks(Graph<Node, Edge> const& g, size_t nr_of_landmarks,
+		LandmarkSelection selection, uint seed)
+{
+	uint const nr_of_nodes(g.getNrOfNodes());
+	LandmarkTable table(nr_of_nodes);
+	nr_of_landmarks = std::min<size_t>(nr_of_landmarks, nr_of_nodes);
+	if (nr_of_landmarks == 0) return table;
+
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<NodeID> random_node(0, nr_of_nodes - 1);
+	Dijkstra<Node, Edge> dijkstra(g);
+
+	/* first landmark: farthest from a random root; try some roots to not
+	 * start in a small component */
+	NodeID first(c::NO_NID);
+	size_t first_reach(0);
+	for (uint i(0); i < 8 && first_reach <= nr_of_nodes / 2; i++) {
+		size_t reach(0);
+		NodeID farthest(c::NO_NID);
+		dijkstra.run(random_node(gen), [&](NodeID node, uint) {
+			reach++;
+			farthest = node;
+		});
+		if (reach > first_reach) {
+			first = farthest;
+			first_reach = reach;
+		}
+	}
+	table.addLandmarks(g, {first});
+
+	/* nodes which may become landmarks */
+	std::vector<NodeID> candidates;
+	std::vector<bool> is_landmark(nr_of_nodes, false);
+	is_landmark[first] = true;
+	for (NodeID node(0); node < nr_of_nodes; node++) {
+		if (table.dist(0, node, EdgeType::OUT) != c::NO_DIST) candidates.push_back(node);
+	}
+	std::uniform_int_distribution<size_t> random_candidate(0, candidates.size() - 1);
+
+	/* for AVOID: shortest path tree of the root */
+	std::vector<NodeID> order;
+	std::vector<uint> tree_dists(nr_of_nodes);
+	std::vector<uint64_t> sizes(nr_of_nodes);
+	std::vector<NodeID> best_child(nr_of_nodes);
+	std::vector<bool> has_landmark(nr_of_nodes);
+
+	while (table.getLandmarks().size() < nr_of_landmarks) {
+		NodeID next(c::NO_NID);
+
+		for (uint i(0); selection == LandmarkSelection::AVOID && i < 8 && next == c::NO_NID; i++) {
+			NodeID const root(candidates[random_candidate(gen)]);
+			order.clear();
+			dijkstra.run(root, [&](NodeID node, uint dist) {
+				order.push_back(node);
+				tree_dists[node] = dist;
+				sizes[node] = dist - table.lowerBound(root, node);
+				best_child[node] = c::NO_NID;
+				has_landmark[node] = is_landmark[node];
+			});
+
+			/* bottom up; sizes of subtrees with a landmark don't count */
+			for (size_t j(order.size() - 1); j > 0; j--) {
+				NodeID const node(order[j]);
+				NodeID const parent(g.getEdge(dijkstra.foundBy(node)).src);
+				if (has_landmark[node]) {
+					has_landmark[parent] = true;
+					continue;
+				}
+				sizes[parent] += sizes[node];
+				if (best_child[parent] == c::NO_NID || sizes[node] > sizes[best_child[parent]]) {
+					best_child[parent] = node;
+				}
+			}
+
+			NodeID node(root);
+			while (best_child[node] != c::NO_NID) node = best_child[node];
+			if (!is_landmark[node]) next = node;
+		}
+
+		/* FARTHEST, or AVOID found no leaf */
+		if (next == c::NO_NID) {
+			uint max_dist(0);
+			for (NodeID node: candidates) {
+				uint min_dist(c::NO_DIST);
+				for (size_t l(0); l < table.getLandmarks().size(); l++) {
+					min_dist = std::min(min_dist, table.dist(l, node, EdgeType::OUT));
+				}
+				if (min_dist != c::NO_DIST && min_dist > max_dist && !is_landmark[node]) {
+					max_dist = min_dist;
+					next = node;
+				}
+			}
+		}
+
+		if (next == c::NO_NID) break;
+		is_landmark[next] = true;
+		table.addLandmarks(g, {next});
+	}
+
+	return table;
+}
+
+template <typename Node, typename Edge>
+struct ALT<Node, Edge>::PQElement
+{
+	NodeID node;
+	uint dist;
+	uint _key; /* dist + heuristic */
+
+	PQElement(NodeID node, uint dist, uint key)
+		: node(node), dist(dist), _key(key) {}
+
+	bool operator>(PQElement const& other) const
+	{
+		return _key > other._key;
+	}
+};
+
+template <typename Node, typename Edge>
+ALT<Node,Edge>::ALT(Graph<Node, Edge> const& g, LandmarkTable const& table)
+	: _g(g), _table(table), _tgt_dists(table.getLandmarks().size() * 2)
+{
+	if (table.getNrOfNodes() != g.getNrOfNodes()) {
+		std::cerr << "FATAL_ERROR: Landmark table has " << table.getNrOfNodes() << " nodes, the graph "
+			<< g.getNrOfNodes() << ". Exiting." << std::endl;
+		std::abort();
+	}
+	_state.init(g.getNrOfNodes());
+}
+
+template <typename Node, typename Edge>
+uint ALT<Node,Edge>::_heuristic(NodeID node) const
+{
+	return _table._lowerBound(&_table._dists[_table._index(node, 0, EdgeType::OUT)], _tgt_dists.data());
+}
+
+template <typename Node, typename Edge>
+uint ALT<Node,Edge>::calcShopa(NodeID src, NodeID tgt,
+		std::vector<EdgeID>& path)
+{
+	_reset();
+	path.clear();
+
+	std::copy_n(_table._dists.begin() + _table._index(tgt, 0, EdgeType::OUT), _tgt_dists.size(),
+			_tgt_dists.begin());
+
+	PQ pq;
+	uint const src_key(_heuristic(src));
+	if (src_key != c::NO_DIST) {
+		pq.push(PQElement(src, 0, src_key));
+		_state.improve(src, 0, c::NO_EID);
+	}
+
+	while (!pq.empty() && pq.top().node != tgt) {
+		PQElement top(pq.top());
+		pq.pop();
+
+		if (_state._dists[top.node] != top.dist) continue;
+
+		_stats.settled_nodes++;
+		for (auto const& edge: _g.nodeEdges(top.node, EdgeType::OUT)) {
+			_stats.relaxed_edges++;
+			uint new_dist(top.dist + edge.distance());
+			if (new_dist >= _state._dists[edge.tgt]) continue;
+
+			/* nodes which can't reach tgt are never queued */
+			uint const h(_heuristic(edge.tgt));
+			if (h != c::NO_DIST) {
+				_state.improve(edge.tgt, new_dist, edge.id);
+				pq.push(PQElement(edge.tgt, new_dist, new_dist + h));
+			}
+		}
+	}
+
+	if (pq.empty()) {
+		Print("No path found from " << src << " to " << tgt << ".");
+		return c::NO_DIST;
+	}
+	_stats.settled_nodes++; /* tgt */
+
+	// Path backtracking.
+	_state.backtrack(_g, tgt, src, EdgeType::OUT, path);
+	std::reverse(path.begin(), path.end());
+
+	return pq.top().dist;
+}
+
+template <typename Node, typename Edge>
+void ALT<Node,Edge>::_reset()
+{
+	_state.reset();
+	_stats = SearchStats();
+}
+
+}
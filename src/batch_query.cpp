@@ -0,0 +1,36 @@
+#include "batch_query.h"
+
+namespace chc
+{
+	std::ostream& operator<<(std::ostream& os, BatchQueryResult const& result)
+	{
+		os << result.dists.size() << " queries in " << result.seconds << " seconds ("
+			<< result.queries_per_second << " queries/s), latency [us]: avg "
+			<< result.avg_latency << ", p50 " << result.p50_latency << ", p99 "
+			<< result.p99_latency << ", max " << result.max_latency;
+		return os;
+	}
+
+	std::vector<Query> readQueries(std::string const& filename)
+	{
+		std::ifstream is(filename);
+		if (!is.is_open()) {
+			std::cerr << "FATAL_ERROR: Couldn't open query file \'" <<
+				filename << "\'. Exiting." << std::endl;
+			std::abort();
+		}
+
+		std::vector<Query> queries;
+		Query query;
+		while (is >> query.src >> query.tgt) {
+			queries.push_back(query);
+		}
+		if (!is.eof()) {
+			std::cerr << "FATAL_ERROR: Invalid query at line " << queries.size() + 1 << " of \'"
+				<< filename << "\'. Exiting." << std::endl;
+			std::abort();
+		}
+
+		return queries;
+	}
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "defs.h"
+#include "nodes_and_edges.h"
+#include "chgraph.h"
+#include "dijkstra.h"
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <omp.h>
+
+namespace chc
+{
+
+namespace unit_tests
+{
+	void testBatchQuery();
+}
+
+struct Query
+{
+	NodeID src;
+	NodeID tgt;
+};
+
+struct BatchQueryResult
+{
+	/* dists[i] is the distance of queries[i] (c::NO_DIST if there is no path) */
+	std::vector<uint> dists;
+
+	double seconds = 0;
+	double queries_per_second = 0;
+	/* latencies of single queries in microseconds */
+	double avg_latency = 0;
+	double p50_latency = 0;
+	double p99_latency = 0;
+	double max_latency = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, BatchQueryResult const& result);
+
+/* reads a query file: one "src tgt" pair per line */
+std::vector<Query> readQueries(std::string const& filename);
+
+/*
+ * Answers many point-to-point queries on one shared, read-only CH.
+ *
+ * Every thread has its own CHDijkstra (i.e. its own search state); the queries
+ * are distributed dynamically in small chunks, so threads that got easy
+ * queries take over the remaining work.
+ */
+template <typename NodeT, typename EdgeT>
+class CHBatchQuery
+{
+	private:
+		/* queries handed out to a thread at once */
+		static constexpr uint CHUNK_SIZE = 64;
+
+		CHGraph<NodeT, EdgeT> const& _g;
+		uint _num_threads;
+		std::vector<CHDijkstra<NodeT, EdgeT>> _search_states;
+
+		static double _percentile(std::vector<double>& values, double p);
+	public:
+		CHBatchQuery(CHGraph<NodeT, EdgeT> const& g, uint num_threads = 1);
+
+		BatchQueryResult run(std::vector<Query> const& queries);
+
+		friend void unit_tests::testBatchQuery();
+};
+
+template <typename NodeT, typename EdgeT>
+constexpr uint CHBatchQuery<NodeT, EdgeT>::CHUNK_SIZE;
+
+template <typename NodeT, typename EdgeT>
+CHBatchQuery<NodeT, EdgeT>::CHBatchQuery(CHGraph<NodeT, EdgeT> const& g, uint num_threads)
+	: _g(g), _num_threads(num_threads ? num_threads : 1)
+{
+	_search_states.reserve(_num_threads);
+	for (uint i(0); i < _num_threads; i++) {
+		_search_states.emplace_back(_g);
+	}
+}
+
+template <typename NodeT, typename EdgeT>
+double CHBatchQuery<NodeT, EdgeT>::_percentile(std::vector<double>& values, double p)
+{
+	if (values.empty()) return 0;
+
+	size_t n(std::min(values.size() - 1, size_t(p * values.size())));
+	std::nth_element(values.begin(), values.begin() + n, values.end());
+	return values[n];
+}
+
+template <typename NodeT, typename EdgeT>
+BatchQueryResult CHBatchQuery<NodeT, EdgeT>::run(std::vector<Query> const& queries)
+{
+	using namespace std::chrono;
+
+	BatchQueryResult result;
+	result.dists.resize(queries.size());
+	std::vector<double> latencies(queries.size());
+
+	steady_clock::time_point t1 = steady_clock::now();
+
+	uint size(queries.size());
+	#pragma omp parallel num_threads(_num_threads)
+	{
+		auto& chdij(_search_states[omp_get_thread_num()]);
+		std::vector<EdgeID> path;
+
+		#pragma omp for schedule(dynamic, CHUNK_SIZE)
+		for (uint i = 0; i < size; i++) {
+			steady_clock::time_point q1 = steady_clock::now();
+			result.dists[i] = chdij.calcShopa(queries[i].src, queries[i].tgt, path);
+			latencies[i] = duration_cast<duration<double, std::micro>>(steady_clock::now() - q1).count();
+		}
+	}
+
+	result.seconds = duration_cast<duration<double>>(steady_clock::now() - t1).count();
+	if (!queries.empty()) {
+		result.queries_per_second = queries.size() / result.seconds;
+		for (double latency: latencies) {
+			result.avg_latency += latency;
+		}
+		result.avg_latency /= latencies.size();
+		result.max_latency = *std::max_element(latencies.begin(), latencies.end());
+		result.p50_latency = _percentile(latencies, 0.5);
+		result.p99_latency = _percentile(latencies, 0.99);
+	}
+
+	return result;
+}
+
+}
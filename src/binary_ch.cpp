@@ -0,0 +1,348 @@
+#include "binary_ch.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace chc {
+	namespace FormatBINARY_CH {
+		namespace {
+			char const MAGIC[8] = {'C', 'H', 'C', 'B', 'I', 'N', 'C', 'H'};
+
+			uint64_t align(uint64_t offset)
+			{
+				return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+			}
+
+			class SectionWriter
+			{
+				private:
+					std::ostream& _os;
+					uint64_t _pos = 0;
+				public:
+					explicit SectionWriter(std::ostream& os) : _os(os) { }
+
+					void write(void const* data, uint64_t size)
+					{
+						_os.write(static_cast<char const*>(data), size);
+						_pos += size;
+					}
+
+					template<typename T>
+					void write(std::vector<T> const& data)
+					{
+						write(data.data(), data.size() * sizeof(T));
+					}
+
+					void pad(uint64_t offset)
+					{
+						static char const zeros[ALIGNMENT] = { };
+						assert(_pos <= offset && offset - _pos < ALIGNMENT);
+						write(zeros, offset - _pos);
+					}
+			};
+
+			[[noreturn]] void invalidFile(std::string const& filename, char const* reason)
+			{
+				std::cerr << "FATAL_ERROR: Invalid binary CH file \'" <<
+					filename << "\' (" << reason << "). Exiting." << std::endl;
+				std::abort();
+			}
+		}
+
+		Node toBinary(node_type const& node)
+		{
+			Node result;
+			result.lat = node.lat;
+			result.lon = node.lon;
+			result.osm_id = node.osm_id;
+			result.elev = node.elev;
+			result.padding = 0;
+			return result;
+		}
+
+		Edge toBinary(edge_type const& edge)
+		{
+			Edge result;
+			result.id = edge.id;
+			result.src = edge.src;
+			result.tgt = edge.tgt;
+			result.dist = edge.dist;
+			result.type = edge.type;
+			result.speed = edge.speed;
+			result.child_edge1 = edge.child_edge1;
+			result.child_edge2 = edge.child_edge2;
+			return result;
+		}
+
+		node_type fromBinary(Node const& node, NodeID node_id, uint lvl)
+		{
+			OSMNode result;
+			result.id = node_id;
+			result.osm_id = node.osm_id;
+			result.lat = node.lat;
+			result.lon = node.lon;
+			result.elev = node.elev;
+			return node_type(result, lvl);
+		}
+
+		edge_type fromBinary(Edge const& edge, EdgeID edge_id)
+		{
+			return edge_type(OSMEdge(edge_id, edge.src, edge.tgt, edge.dist, edge.type, edge.speed),
+					edge.child_edge1, edge.child_edge2, c::NO_NID);
+		}
+
+		void writeCHGraph(std::ostream& os, std::vector<Node> const& nodes,
+				std::vector<uint> const& node_levels, std::vector<Edge> const& edges,
+				Metadata const& meta_data)
+		{
+			uint64_t nr_of_nodes(nodes.size());
+			uint64_t nr_of_edges(edges.size());
+
+			if (node_levels.size() != nr_of_nodes) {
+				std::cerr << "FATAL_ERROR: number of node levels doesn't match number of nodes. Exiting.\n";
+				std::abort();
+			}
+			for (EdgeID i(0); i < nr_of_edges; i++) {
+				if (edges[i].src >= nr_of_nodes || edges[i].tgt >= nr_of_nodes ||
+						(i > 0 && edges[i-1].src > edges[i].src)) {
+					std::cerr << "FATAL_ERROR: edges have to be valid and sorted by source (@" << i << "). Exiting.\n";
+					std::abort();
+				}
+			}
+
+			/* CSR offsets */
+			std::vector<uint32_t> out_offsets(nr_of_nodes + 1, 0);
+			std::vector<uint32_t> in_offsets(nr_of_nodes + 1, 0);
+			for (auto const& edge: edges) {
+				++out_offsets[edge.src + 1];
+				++in_offsets[edge.tgt + 1];
+			}
+			std::partial_sum(out_offsets.begin(), out_offsets.end(), out_offsets.begin());
+			std::partial_sum(in_offsets.begin(), in_offsets.end(), in_offsets.begin());
+
+			/* the out edges are sorted by source, so a stable sort keeps the
+			 * in edges of a node sorted by source */
+			std::vector<Edge> in_edges(edges);
+			std::stable_sort(in_edges.begin(), in_edges.end(), [](Edge const& e1, Edge const& e2) {
+				return e1.tgt < e2.tgt;
+			});
+			std::vector<uint32_t> levels(node_levels.begin(), node_levels.end());
+
+			std::string meta;
+			for (auto const& meta_datum: meta_data) {
+				meta += meta_datum.first;
+				meta.push_back('\0');
+				meta += meta_datum.second;
+				meta.push_back('\0');
+			}
+
+			Header header;
+			std::memset(&header, 0, sizeof(header));
+			std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+			header.version = VERSION;
+			header.byte_order_check = BYTE_ORDER_CHECK;
+			header.nr_of_nodes = nr_of_nodes;
+			header.nr_of_edges = nr_of_edges;
+			header.nodes_offset = align(sizeof(Header));
+			header.levels_offset = align(header.nodes_offset + nr_of_nodes * sizeof(Node));
+			header.out_offsets_offset = align(header.levels_offset + nr_of_nodes * sizeof(uint32_t));
+			header.out_edges_offset = align(header.out_offsets_offset + (nr_of_nodes + 1) * sizeof(uint32_t));
+			header.in_offsets_offset = align(header.out_edges_offset + nr_of_edges * sizeof(Edge));
+			header.in_edges_offset = align(header.in_offsets_offset + (nr_of_nodes + 1) * sizeof(uint32_t));
+			header.meta_data_offset = align(header.in_edges_offset + nr_of_edges * sizeof(Edge));
+			header.meta_data_size = meta.size();
+			header.file_size = header.meta_data_offset + meta.size();
+
+			SectionWriter writer(os);
+			writer.write(&header, sizeof(header));
+			writer.pad(header.nodes_offset);
+			writer.write(nodes);
+			writer.pad(header.levels_offset);
+			writer.write(levels);
+			writer.pad(header.out_offsets_offset);
+			writer.write(out_offsets);
+			writer.pad(header.out_edges_offset);
+			writer.write(edges);
+			writer.pad(header.in_offsets_offset);
+			writer.write(in_offsets);
+			writer.pad(header.in_edges_offset);
+			writer.write(in_edges);
+			writer.pad(header.meta_data_offset);
+			writer.write(meta.data(), meta.size());
+
+			if (!os) {
+				std::cerr << "FATAL_ERROR: Couldn't write binary CH. Exiting.\n";
+				std::abort();
+			}
+		}
+
+		MappedCH::MappedCH(std::string const& filename)
+			: _file(filename), _header(reinterpret_cast<Header const*>(_file.data()))
+		{
+			if (_file.size() < sizeof(Header)) invalidFile(filename, "too small");
+			if (0 != std::memcmp(_header->magic, MAGIC, sizeof(MAGIC))) invalidFile(filename, "wrong magic");
+			if (_header->version != VERSION) invalidFile(filename, "unsupported version");
+			if (_header->byte_order_check != BYTE_ORDER_CHECK) invalidFile(filename, "wrong byte order");
+			if (_header->file_size != _file.size()) invalidFile(filename, "wrong file size");
+			if (_header->nr_of_nodes >= c::NO_NID || _header->nr_of_edges >= c::NO_EID) invalidFile(filename, "too many nodes or edges");
+
+			uint64_t const n(_header->nr_of_nodes), m(_header->nr_of_edges);
+			struct Section { uint64_t offset, size; };
+			Section const sections[] = {
+				{ _header->nodes_offset, n * sizeof(Node) },
+				{ _header->levels_offset, n * sizeof(uint32_t) },
+				{ _header->out_offsets_offset, (n + 1) * sizeof(uint32_t) },
+				{ _header->out_edges_offset, m * sizeof(Edge) },
+				{ _header->in_offsets_offset, (n + 1) * sizeof(uint32_t) },
+				{ _header->in_edges_offset, m * sizeof(Edge) },
+				{ _header->meta_data_offset, _header->meta_data_size },
+			};
+			for (auto const& section: sections) {
+				if (section.offset % ALIGNMENT != 0 || section.offset > _file.size() ||
+						section.size > _file.size() - section.offset) {
+					invalidFile(filename, "section out of bounds");
+				}
+			}
+
+			_validateEdges(filename, EdgeType::OUT);
+			_validateEdges(filename, EdgeType::IN);
+
+			/* the center node of a shortcut is below its ends, so unpacking a
+			 * child lowers the minimal level of the ends and terminates */
+			auto const all_edges(edges().begin());
+			auto const node_levels(levels().begin());
+			for (EdgeID edge_id(0); edge_id < m; edge_id++) {
+				Edge const& edge(all_edges[edge_id]);
+				if (edge.id != edge_id) invalidFile(filename, "edge id isn't its position");
+				/* every edge leads up in one direction (isUp) */
+				if (node_levels[edge.src] == node_levels[edge.tgt]) invalidFile(filename, "edge between nodes of the same level");
+				if (c::NO_EID == edge.child_edge1 && c::NO_EID == edge.child_edge2) continue;
+				if (edge.child_edge1 >= m || edge.child_edge2 >= m) invalidFile(filename, "child edge out of range");
+
+				Edge const& child1(all_edges[edge.child_edge1]);
+				Edge const& child2(all_edges[edge.child_edge2]);
+				NodeID const center(child1.tgt);
+				if (child1.src != edge.src || child2.src != center || child2.tgt != edge.tgt ||
+						node_levels[center] >= std::min(node_levels[edge.src], node_levels[edge.tgt])) {
+					invalidFile(filename, "invalid shortcut");
+				}
+			}
+		}
+
+		void MappedCH::_validateEdges(std::string const& filename, EdgeType type) const
+		{
+			uint64_t const n(_header->nr_of_nodes), m(_header->nr_of_edges);
+			auto const offsets(_section<uint32_t>(type == EdgeType::OUT ?
+						_header->out_offsets_offset : _header->in_offsets_offset));
+			if (offsets[0] != 0 || offsets[n] != m) invalidFile(filename, "inconsistent edge offsets");
+			for (NodeID node_id(0); node_id < n; node_id++) {
+				if (offsets[node_id] > offsets[node_id + 1]) invalidFile(filename, "decreasing edge offsets");
+			}
+
+			/* sections are in bounds and offsets increasing now */
+			for (NodeID node_id(0); node_id < n; node_id++) {
+				for (auto const& edge: nodeEdges(node_id, type)) {
+					if (edge.src >= n || edge.tgt >= n || edge.id >= m) invalidFile(filename, "edge out of range");
+					if (otherNode(edge, !type) != node_id) invalidFile(filename, "edge in the wrong node's list");
+				}
+			}
+		}
+
+		range<Node const*> MappedCH::nodes() const
+		{
+			auto first(_section<Node>(_header->nodes_offset));
+			return range<Node const*>(first, first + _header->nr_of_nodes);
+		}
+
+		range<uint32_t const*> MappedCH::levels() const
+		{
+			auto first(_section<uint32_t>(_header->levels_offset));
+			return range<uint32_t const*>(first, first + _header->nr_of_nodes);
+		}
+
+		range<Edge const*> MappedCH::edges() const
+		{
+			auto first(_section<Edge>(_header->out_edges_offset));
+			return range<Edge const*>(first, first + _header->nr_of_edges);
+		}
+
+		range<Edge const*> MappedCH::nodeEdges(NodeID node_id, EdgeType type) const
+		{
+			assert(node_id < _header->nr_of_nodes);
+			uint32_t const* offsets;
+			Edge const* edges;
+			switch (type) {
+			case EdgeType::OUT:
+				offsets = _section<uint32_t>(_header->out_offsets_offset);
+				edges = _section<Edge>(_header->out_edges_offset);
+				break;
+			case EdgeType::IN:
+			default:
+				offsets = _section<uint32_t>(_header->in_offsets_offset);
+				edges = _section<Edge>(_header->in_edges_offset);
+				break;
+			}
+			return range<Edge const*>(edges + offsets[node_id], edges + offsets[node_id + 1]);
+		}
+
+		Metadata MappedCH::metaData() const
+		{
+			Metadata result;
+			char const* pos(_section<char>(_header->meta_data_offset));
+			char const* end(pos + _header->meta_data_size);
+			while (pos < end) {
+				char const* key_end(std::find(pos, end, '\0'));
+				char const* value(std::min(key_end + 1, end));
+				char const* value_end(std::find(value, end, '\0'));
+				result[std::string(pos, key_end)] = std::string(value, value_end);
+				pos = value_end + 1;
+			}
+			return result;
+		}
+
+		node_type MappedCH::getNode(NodeID node_id) const
+		{
+			assert(node_id < _header->nr_of_nodes);
+			return fromBinary(nodes().begin()[node_id], node_id, levels().begin()[node_id]);
+		}
+
+		edge_type MappedCH::getEdge(EdgeID edge_id) const
+		{
+			assert(edge_id < _header->nr_of_edges);
+			auto all_edges(edges());
+			auto result(fromBinary(all_edges.begin()[edge_id], edge_id));
+			if (c::NO_EID != result.child_edge1) {
+				result.center_node = all_edges.begin()[result.child_edge1].tgt;
+			}
+			return result;
+		}
+
+		bool MappedCH::isUp(Edge const& edge, EdgeType direction) const
+		{
+			auto const node_levels(levels().begin());
+			uint32_t const src_lvl(node_levels[edge.src]);
+			uint32_t const tgt_lvl(node_levels[edge.tgt]);
+			assert(src_lvl != tgt_lvl);
+			return direction == EdgeType::OUT ? src_lvl < tgt_lvl : src_lvl > tgt_lvl;
+		}
+
+		void MappedCH::unpackEdge(EdgeID edge_id, std::vector<EdgeID>& path) const
+		{
+			/* like CHGraph::unpackEdge, first child on top of the stack */
+			auto const all_edges(edges().begin());
+			std::vector<EdgeID> stack(1, edge_id);
+			while (!stack.empty()) {
+				Edge const& edge(all_edges[stack.back()]);
+				stack.pop_back();
+
+				if (c::NO_EID == edge.child_edge1) {
+					path.push_back(edge.id);
+				}
+				else {
+					stack.push_back(edge.child_edge2);
+					stack.push_back(edge.child_edge1);
+				}
+			}
+		}
+	}
+}
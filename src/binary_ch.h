@@ -0,0 +1,233 @@
+#pragma once
+
+#include "defs.h"
+#include "nodes_and_edges.h"
+#include "indexed_container.h"
+#include "file_formats_helper.h"
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+namespace chc {
+	namespace unit_tests
+	{
+		void testBinaryCH();
+	}
+
+	/*
+	 * Binary CH format, meant to be memory mapped: a versioned header
+	 * followed by 64 byte aligned sections
+	 *
+	 *   nodes      Node[nr_of_nodes]
+	 *   levels     uint32_t[nr_of_nodes]
+	 *   out_offsets, out_edges:  CSR of the edges sorted by (src, tgt); the
+	 *              position of an edge in out_edges is its id
+	 *   in_offsets, in_edges:    CSR of the same edges sorted by (tgt, src)
+	 *   meta data  "key\0value\0" pairs
+	 *
+	 * All numbers are stored in native byte order; the header contains a
+	 * check value to reject files from machines with different endianness.
+	 */
+	namespace FormatBINARY_CH
+	{
+		typedef CHNode<OSMNode> node_type;
+		typedef CHEdge<OSMEdge> edge_type;
+
+		uint32_t const VERSION = 1;
+		uint32_t const BYTE_ORDER_CHECK = 0x01020304;
+		size_t const ALIGNMENT = 64;
+
+		struct Header
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t byte_order_check;
+			uint64_t nr_of_nodes;
+			uint64_t nr_of_edges;
+			uint64_t nodes_offset;
+			uint64_t levels_offset;
+			uint64_t out_offsets_offset;
+			uint64_t out_edges_offset;
+			uint64_t in_offsets_offset;
+			uint64_t in_edges_offset;
+			uint64_t meta_data_offset;
+			uint64_t meta_data_size;
+			uint64_t file_size;
+		};
+
+		struct Node
+		{
+			double lat;
+			double lon;
+			uint64_t osm_id;
+			int32_t elev;
+			uint32_t padding;
+		};
+
+		struct Edge
+		{
+			uint32_t id;
+			uint32_t src;
+			uint32_t tgt;
+			uint32_t dist;
+			uint32_t type;
+			int32_t speed;
+			uint32_t child_edge1;
+			uint32_t child_edge2;
+
+			uint distance() const { return dist; }
+		};
+
+		static_assert(std::is_trivially_copyable<Header>::value && sizeof(Header) == 104, "unexpected header layout");
+		static_assert(std::is_trivially_copyable<Node>::value && sizeof(Node) == 32, "unexpected node layout");
+		static_assert(std::is_trivially_copyable<Edge>::value && sizeof(Edge) == 32, "unexpected edge layout");
+
+		Node toBinary(node_type const& node);
+		Edge toBinary(edge_type const& edge);
+		node_type fromBinary(Node const& node, NodeID node_id, uint lvl);
+		edge_type fromBinary(Edge const& edge, EdgeID edge_id);
+
+		/* edges have to be sorted by source; their position is their id */
+		void writeCHGraph(std::ostream& os, std::vector<Node> const& nodes,
+				std::vector<uint> const& node_levels, std::vector<Edge> const& edges,
+				Metadata const& meta_data);
+
+		/*
+		 * Zero-copy view of a memory mapped binary CH file. Has the query
+		 * interface of CHGraph (nodeEdges, isUp, getEdge, unpackEdge), so
+		 * CHDijkstra and ShortcutUnpacker answer directly from the mapping.
+		 */
+		class MappedCH
+		{
+			private:
+				MappedFile _file;
+				Header const* _header;
+
+				template<typename T>
+				T const* _section(uint64_t offset) const
+				{
+					return reinterpret_cast<T const*>(_file.data() + offset);
+				}
+
+				void _validateEdges(std::string const& filename, EdgeType type) const;
+			public:
+				/*
+				 * Validates the header, the section bounds, the offsets and all
+				 * node and edge ids (including the children of shortcuts, which
+				 * have to be unpackable); aborts on errors.
+				 */
+				explicit MappedCH(std::string const& filename);
+
+				uint getNrOfNodes() const { return _header->nr_of_nodes; }
+				uint getNrOfEdges() const { return _header->nr_of_edges; }
+
+				range<Node const*> nodes() const;
+				range<uint32_t const*> levels() const;
+				/* indexed by edge id */
+				range<Edge const*> edges() const;
+				range<Edge const*> nodeEdges(NodeID node_id, EdgeType type) const;
+				Metadata metaData() const;
+
+				node_type getNode(NodeID node_id) const;
+				edge_type getEdge(EdgeID edge_id) const;
+
+				/* like CHGraph::isUp */
+				bool isUp(Edge const& edge, EdgeType direction) const;
+				/* like CHGraph::unpackEdge */
+				void unpackEdge(EdgeID edge_id, std::vector<EdgeID>& path) const;
+		};
+
+		struct Reader
+		{
+			typedef FormatBINARY_CH::node_type node_type;
+			typedef FormatBINARY_CH::edge_type edge_type;
+
+			template<typename NodeT = node_type, typename EdgeT = edge_type>
+			struct can_read
+			{
+				typedef is_static_castable_t<node_type, NodeT> support_node;
+				typedef is_static_castable_t<edge_type, EdgeT> support_edge;
+
+				static constexpr bool value = support_node::value && support_edge::value;
+			};
+
+			template<typename NodeT = node_type, typename EdgeT = edge_type, typename std::enable_if<!can_read<NodeT, EdgeT>::value>::type* = nullptr>
+			static GraphInData<NodeT, EdgeT> readGraph(std::string const&)
+			{
+				Print("Can't read nodes / edges in this format");
+				std::abort();
+			}
+
+			/* copies the nodes and edges; use MappedCH for zero-copy access */
+			template<typename NodeT = node_type, typename EdgeT = edge_type, typename std::enable_if<can_read<NodeT, EdgeT>::value>::type* = nullptr>
+			static GraphInData<NodeT, EdgeT> readGraph(std::string const& filename)
+			{
+				MappedCH ch(filename);
+				GraphInData<NodeT, EdgeT> result;
+				result.meta_data = ch.metaData();
+
+				Print("Number of nodes: " << ch.getNrOfNodes());
+				Print("Number of edges: " << ch.getNrOfEdges());
+
+				result.nodes.reserve(ch.getNrOfNodes());
+				for (NodeID i = 0; i < ch.getNrOfNodes(); ++i) {
+					result.nodes.push_back(static_cast<NodeT>(ch.getNode(i)));
+				}
+				result.edges.reserve(ch.getNrOfEdges());
+				for (EdgeID i = 0; i < ch.getNrOfEdges(); ++i) {
+					result.edges.push_back(static_cast<EdgeT>(ch.getEdge(i)));
+				}
+
+				return result;
+			}
+		};
+
+		struct Writer
+		{
+			typedef FormatBINARY_CH::node_type node_type;
+			typedef FormatBINARY_CH::edge_type edge_type;
+
+			template<typename NodeT, typename EdgeT>
+			using can_write = writer_can_write<Writer, NodeT, EdgeT>;
+
+			template<typename NodeT, typename EdgeT, typename std::enable_if<!can_write<NodeT, EdgeT>::value>::type* = nullptr>
+			static void writeCHGraph(std::ostream&, GraphCHOutData<NodeT, EdgeT> const&, EdgeID, std::function<void()> const&)
+			{
+				Print("Can't export nodes / edges in this format");
+				std::abort();
+			}
+
+			template<typename NodeT, typename EdgeT, typename std::enable_if<can_write<NodeT, EdgeT>::value>::type* = nullptr>
+			static void writeCHGraph(std::ostream& os, GraphCHOutData<NodeT, EdgeT> const& data,
+					EdgeID nr_of_edges, std::function<void()> const& wait_for_edges)
+			{
+				Print("Exporting " << data.nodes.size() << " nodes and " << nr_of_edges << " edges");
+
+				std::vector<Node> nodes;
+				nodes.reserve(data.nodes.size());
+				NodeID node_id = 0;
+				for (auto const& node: data.nodes) {
+					nodes.push_back(toBinary(static_cast<node_type>(makeCHNode(node, data.node_levels[node_id]))));
+					++node_id;
+				}
+
+				wait_for_edges();
+				checkNrOfEdges(data.edges.size(), nr_of_edges);
+				std::vector<Edge> edges;
+				edges.reserve(data.edges.size());
+				for (auto const& edge: data.edges) {
+					edges.push_back(toBinary(static_cast<edge_type>(edge)));
+					/* child edges reference positions */
+					edges.back().id = edges.size() - 1;
+				}
+
+				FormatBINARY_CH::writeCHGraph(os, nodes, data.node_levels, edges, data.meta_data);
+			}
+		};
+	}
+}
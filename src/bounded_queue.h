@@ -0,0 +1,78 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+namespace chc
+{
+
+/*
+ * Blocking FIFO queue with a maximal size to connect producer and consumer
+ * threads.
+ *
+ * After close() no more elements can be pushed; pop() returns the
+ * remaining elements and then false.
+ */
+template <typename T>
+class BoundedQueue
+{
+	private:
+		std::deque<T> _queue;
+		size_t _max_size;
+		bool _closed = false;
+
+		std::mutex _mutex;
+		std::condition_variable _not_empty;
+		std::condition_variable _not_full;
+	public:
+		explicit BoundedQueue(size_t max_size) : _max_size(max_size ? max_size : 1) { }
+
+		/* blocks while the queue is full; returns false if the queue was closed */
+		bool push(T element)
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_not_full.wait(lock, [this] { return _closed || _queue.size() < _max_size; });
+			if (_closed) return false;
+
+			_queue.push_back(std::move(element));
+			_not_empty.notify_one();
+			return true;
+		}
+
+		/* blocks while the queue is empty; returns false if the queue is
+		 * empty and closed */
+		bool pop(T& element)
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_not_empty.wait(lock, [this] { return _closed || !_queue.empty(); });
+			if (_queue.empty()) return false;
+
+			element = std::move(_queue.front());
+			_queue.pop_front();
+			_not_full.notify_one();
+			return true;
+		}
+
+		/* doesn't block; returns false if the queue is empty */
+		bool tryPop(T& element)
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			if (_queue.empty()) return false;
+
+			element = std::move(_queue.front());
+			_queue.pop_front();
+			_not_full.notify_one();
+			return true;
+		}
+
+		void close()
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_closed = true;
+			_not_empty.notify_all();
+			_not_full.notify_all();
+		}
+};
+
+}
@@ -0,0 +1,441 @@
+#include "cch.h"
+#include "mapped_file.h"
+
+#include <cstring>
+#include <type_traits>
+
+namespace chc {
+	namespace {
+		char const MAGIC[8] = {'C', 'H', 'C', 'C', 'C', 'H', 'T', 'P'};
+		uint32_t const VERSION = 1;
+		uint32_t const BYTE_ORDER_CHECK = 0x01020304;
+
+		struct Header
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t byte_order_check;
+			uint64_t nr_of_nodes;
+			uint64_t nr_of_input_edges;
+			uint64_t nr_of_arcs;
+		};
+
+		static_assert(std::is_trivially_copyable<Header>::value && sizeof(Header) == 40, "unexpected header layout");
+		static_assert(sizeof(uint) == sizeof(uint32_t), "topologies store uint as uint32_t");
+
+		[[noreturn]] void invalidFile(std::string const& filename, char const* reason)
+		{
+			std::cerr << "FATAL_ERROR: Invalid CCH topology file \'" <<
+				filename << "\' (" << reason << "). Exiting." << std::endl;
+			std::abort();
+		}
+
+		uint saturatingAdd(uint dist1, uint dist2)
+		{
+			if (dist1 == c::NO_DIST || dist2 == c::NO_DIST) return c::NO_DIST;
+			uint64_t const sum(uint64_t(dist1) + dist2);
+			return sum < c::NO_DIST ? sum : c::NO_DIST;
+		}
+
+		template <typename T>
+		void writeVector(std::ostream& os, std::vector<T> const& vec)
+		{
+			os.write(reinterpret_cast<char const*>(vec.data()), vec.size() * sizeof(T));
+		}
+
+		template <typename T>
+		char const* readVector(char const* pos, std::vector<T>& vec, size_t size)
+		{
+			vec.resize(size);
+			std::memcpy(vec.data(), pos, size * sizeof(T));
+			return pos + size * sizeof(T);
+		}
+	}
+
+	void CCHTopology::_buildArcs(std::vector<std::vector<uint>>& up)
+	{
+		/* chordal completion: the upward neighbours of a node become
+		 * neighbours of the lowest of them */
+		_up_offsets.assign(1, 0);
+		_up_heads.clear();
+		for (uint rank(0); rank < _nr_of_nodes; rank++) {
+			auto& heads(up[rank]);
+			std::sort(heads.begin(), heads.end());
+			heads.erase(std::unique(heads.begin(), heads.end()), heads.end());
+			if (heads.size() > 1) {
+				auto& parent_heads(up[heads.front()]);
+				parent_heads.insert(parent_heads.end(), heads.begin() + 1, heads.end());
+			}
+			_up_heads.insert(_up_heads.end(), heads.begin(), heads.end());
+			_up_offsets.push_back(_up_heads.size());
+			std::vector<uint>().swap(heads);
+		}
+
+		_buildDownArcs();
+	}
+
+	void CCHTopology::_buildDownArcs()
+	{
+		_down_offsets.assign(_nr_of_nodes + 1, 0);
+		for (auto head: _up_heads) {
+			_down_offsets[head + 1]++;
+		}
+		for (uint rank(0); rank < _nr_of_nodes; rank++) {
+			_down_offsets[rank + 1] += _down_offsets[rank];
+		}
+
+		/* by ascending tail, so every down list is sorted by tail */
+		std::vector<uint> next(_down_offsets.begin(), _down_offsets.end() - 1);
+		_down_arcs.resize(_up_heads.size());
+		for (uint tail(0); tail < _nr_of_nodes; tail++) {
+			for (uint arc(_up_offsets[tail]); arc < _up_offsets[tail + 1]; arc++) {
+				_down_arcs[next[_up_heads[arc]]++] = DownArc{tail, arc};
+			}
+		}
+	}
+
+	void CCHTopology::_buildLevels()
+	{
+		std::vector<uint> levels(_nr_of_nodes, 0);
+		uint nr_of_levels(_nr_of_nodes > 0 ? 1 : 0);
+		for (uint rank(0); rank < _nr_of_nodes; rank++) {
+			for (uint i(_down_offsets[rank]); i < _down_offsets[rank + 1]; i++) {
+				levels[rank] = std::max(levels[rank], levels[_down_arcs[i].tail] + 1);
+			}
+			nr_of_levels = std::max(nr_of_levels, levels[rank] + 1);
+		}
+
+		_level_offsets.assign(nr_of_levels + 1, 0);
+		for (auto level: levels) {
+			_level_offsets[level + 1]++;
+		}
+		for (uint level(0); level < nr_of_levels; level++) {
+			_level_offsets[level + 1] += _level_offsets[level];
+		}
+		std::vector<uint> next(_level_offsets.begin(), _level_offsets.end() - 1);
+		_level_nodes.resize(_nr_of_nodes);
+		for (uint rank(0); rank < _nr_of_nodes; rank++) {
+			_level_nodes[next[levels[rank]]++] = rank;
+		}
+	}
+
+	void CCHTopology::_mapInputEdges(std::vector<std::pair<NodeID, NodeID>> const& edges)
+	{
+		_input_arcs.assign(edges.size(), c::NO_EID);
+		for (EdgeID edge_id(0); edge_id < edges.size(); edge_id++) {
+			uint const src_rank(_rank[edges[edge_id].first]);
+			uint const tgt_rank(_rank[edges[edge_id].second]);
+			if (src_rank == tgt_rank) continue;
+
+			uint const arc(_findArc(std::min(src_rank, tgt_rank), std::max(src_rank, tgt_rank)));
+			_input_arcs[edge_id] = 2 * arc + (src_rank > tgt_rank ? 1 : 0);
+		}
+	}
+
+	uint CCHTopology::_findArc(uint tail, uint head) const
+	{
+		auto const begin(_up_heads.begin() + _up_offsets[tail]);
+		auto const end(_up_heads.begin() + _up_offsets[tail + 1]);
+		auto const it(std::lower_bound(begin, end, head));
+		assert(it != end && *it == head);
+		return it - _up_heads.begin();
+	}
+
+	uint CCHTopology::_arcTail(uint arc) const
+	{
+		return std::upper_bound(_up_offsets.begin(), _up_offsets.end(), arc) - _up_offsets.begin() - 1;
+	}
+
+	MemoryUsage CCHTopology::memoryUsage() const
+	{
+		MemoryUsage usage;
+		usage.add("ranks", chc::memoryUsage(_rank) + chc::memoryUsage(_node));
+		usage.add("up arcs", chc::memoryUsage(_up_offsets) + chc::memoryUsage(_up_heads));
+		usage.add("down arcs", chc::memoryUsage(_down_offsets) + chc::memoryUsage(_down_arcs));
+		usage.add("levels", chc::memoryUsage(_level_offsets) + chc::memoryUsage(_level_nodes));
+		usage.add("input arcs", chc::memoryUsage(_input_arcs));
+		return usage;
+	}
+
+	void CCHTopology::write(std::ostream& os) const
+	{
+		Header header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.byte_order_check = BYTE_ORDER_CHECK;
+		header.nr_of_nodes = _nr_of_nodes;
+		header.nr_of_input_edges = _input_arcs.size();
+		header.nr_of_arcs = _up_heads.size();
+
+		/* the down arcs and levels are derived on reading */
+		os.write(reinterpret_cast<char const*>(&header), sizeof(header));
+		writeVector(os, _node);
+		writeVector(os, _up_offsets);
+		writeVector(os, _up_heads);
+		writeVector(os, _input_arcs);
+	}
+
+	CCHTopology CCHTopology::read(std::string const& filename)
+	{
+		MappedFile file(filename);
+
+		Header header;
+		if (file.size() < sizeof(header)) invalidFile(filename, "too small");
+		std::memcpy(&header, file.data(), sizeof(header));
+		if (0 != std::memcmp(header.magic, MAGIC, sizeof(MAGIC))) invalidFile(filename, "wrong magic");
+		if (header.version != VERSION) invalidFile(filename, "unsupported version");
+		if (header.byte_order_check != BYTE_ORDER_CHECK) invalidFile(filename, "wrong byte order");
+		if (header.nr_of_nodes >= c::NO_NID || header.nr_of_arcs >= c::NO_EID / 2) invalidFile(filename, "too large");
+
+		uint64_t const size(sizeof(header) + sizeof(uint32_t) * (header.nr_of_nodes
+					+ header.nr_of_nodes + 1 + header.nr_of_arcs + header.nr_of_input_edges));
+		if (file.size() != size) invalidFile(filename, "wrong size");
+
+		CCHTopology topology;
+		topology._nr_of_nodes = header.nr_of_nodes;
+		char const* pos(file.data() + sizeof(header));
+		pos = readVector(pos, topology._node, header.nr_of_nodes);
+		pos = readVector(pos, topology._up_offsets, header.nr_of_nodes + 1);
+		pos = readVector(pos, topology._up_heads, header.nr_of_arcs);
+		readVector(pos, topology._input_arcs, header.nr_of_input_edges);
+
+		topology._rank.assign(topology._nr_of_nodes, c::NO_NID);
+		for (uint rank(0); rank < topology._nr_of_nodes; rank++) {
+			NodeID const node(topology._node[rank]);
+			if (node >= topology._nr_of_nodes || topology._rank[node] != c::NO_NID) invalidFile(filename, "no order");
+			topology._rank[node] = rank;
+		}
+		auto const& offsets(topology._up_offsets);
+		if (offsets.front() != 0 || offsets.back() != header.nr_of_arcs) invalidFile(filename, "wrong arc offsets");
+		for (uint rank(0); rank < topology._nr_of_nodes; rank++) {
+			if (offsets[rank] > offsets[rank + 1]) invalidFile(filename, "wrong arc offsets");
+			for (uint arc(offsets[rank]); arc < offsets[rank + 1]; arc++) {
+				uint const head(topology._up_heads[arc]);
+				if (head >= topology._nr_of_nodes || head <= rank) invalidFile(filename, "arc not upwards");
+				if (arc > offsets[rank] && head <= topology._up_heads[arc - 1]) invalidFile(filename, "arcs not sorted");
+			}
+		}
+		for (auto input_arc: topology._input_arcs) {
+			if (input_arc != c::NO_EID && input_arc / 2 >= header.nr_of_arcs) invalidFile(filename, "input edge out of range");
+		}
+
+		topology._buildDownArcs();
+		topology._buildLevels();
+		return topology;
+	}
+
+	CCHMetric::CCHMetric(CCHTopology const& topology, std::vector<uint> const& weights)
+		: _topology(&topology)
+	{
+		assert(weights.size() == topology.getNrOfInputEdges());
+
+		uint const nr_of_arcs(topology.getNrOfArcs());
+		_up.assign(nr_of_arcs, c::NO_DIST);
+		_down.assign(nr_of_arcs, c::NO_DIST);
+		_up_edges.assign(nr_of_arcs, c::NO_EID);
+		_down_edges.assign(nr_of_arcs, c::NO_EID);
+
+		for (EdgeID edge_id(0); edge_id < weights.size(); edge_id++) {
+			EdgeID const input_arc(topology._input_arcs[edge_id]);
+			if (input_arc == c::NO_EID) continue;
+
+			uint const arc(input_arc / 2);
+			auto& dists(input_arc % 2 == 0 ? _up : _down);
+			auto& edges(input_arc % 2 == 0 ? _up_edges : _down_edges);
+			if (weights[edge_id] < dists[arc]) {
+				dists[arc] = weights[edge_id];
+				edges[arc] = edge_id;
+			}
+		}
+
+		/* the arcs of a node only depend on the arcs of its downward
+		 * neighbours, which are on lower levels; the implicit barrier at the
+		 * end of each level's loop orders the levels */
+		#pragma omp parallel
+		{
+			std::vector<uint> arc_of(topology.getNrOfNodes(), c::NO_EID);
+
+			for (uint level(0); level < topology.getNrOfLevels(); level++) {
+				#pragma omp for schedule(dynamic)
+				for (uint i = topology._level_offsets[level]; i < topology._level_offsets[level + 1]; i++) {
+					uint const rank(topology._level_nodes[i]);
+					uint const up_end(topology._up_offsets[rank + 1]);
+					for (uint arc(topology._up_offsets[rank]); arc < up_end; arc++) {
+						arc_of[topology._up_heads[arc]] = arc;
+					}
+
+					/* lower triangles: v -> rank and v -> w for w above rank */
+					for (uint j(topology._down_offsets[rank]); j < topology._down_offsets[rank + 1]; j++) {
+						uint const tail(topology._down_arcs[j].tail);
+						uint const arc1(topology._down_arcs[j].arc);
+						for (uint arc2(arc1 + 1); arc2 < topology._up_offsets[tail + 1]; arc2++) {
+							uint const arc(arc_of[topology._up_heads[arc2]]);
+							assert(arc != c::NO_EID);
+
+							uint const up(saturatingAdd(_down[arc1], _up[arc2]));
+							if (up < _up[arc]) {
+								_up[arc] = up;
+								_up_edges[arc] = c::NO_EID;
+							}
+							uint const down(saturatingAdd(_down[arc2], _up[arc1]));
+							if (down < _down[arc]) {
+								_down[arc] = down;
+								_down_edges[arc] = c::NO_EID;
+							}
+						}
+					}
+
+					for (uint arc(topology._up_offsets[rank]); arc < up_end; arc++) {
+						arc_of[topology._up_heads[arc]] = c::NO_EID;
+					}
+				}
+			}
+		}
+	}
+
+	void CCHMetric::_unpack(uint arc, bool up, std::vector<EdgeID>& path) const
+	{
+		EdgeID const edge_id(up ? _up_edges[arc] : _down_edges[arc]);
+		if (edge_id != c::NO_EID) {
+			path.push_back(edge_id);
+			return;
+		}
+
+		/* find the lower triangle by merging the down arcs of both ends */
+		auto const& t(*_topology);
+		uint const low(t._arcTail(arc));
+		uint const high(t._up_heads[arc]);
+		uint const weight(up ? _up[arc] : _down[arc]);
+		uint i(t._down_offsets[low]);
+		uint j(t._down_offsets[high]);
+		while (i < t._down_offsets[low + 1] && j < t._down_offsets[high + 1]) {
+			auto const& low_arc(t._down_arcs[i]);
+			auto const& high_arc(t._down_arcs[j]);
+			if (low_arc.tail < high_arc.tail) {
+				i++;
+			}
+			else if (high_arc.tail < low_arc.tail) {
+				j++;
+			}
+			else {
+				if (up && saturatingAdd(_down[low_arc.arc], _up[high_arc.arc]) == weight) {
+					_unpack(low_arc.arc, false, path);
+					_unpack(high_arc.arc, true, path);
+					return;
+				}
+				if (!up && saturatingAdd(_down[high_arc.arc], _up[low_arc.arc]) == weight) {
+					_unpack(high_arc.arc, false, path);
+					_unpack(low_arc.arc, true, path);
+					return;
+				}
+				i++;
+				j++;
+			}
+		}
+
+		std::cerr << "FATAL_ERROR: No lower triangle for arc " << arc << ". Exiting." << std::endl;
+		std::abort();
+	}
+
+	MemoryUsage CCHMetric::memoryUsage() const
+	{
+		MemoryUsage usage;
+		usage.add("weights", chc::memoryUsage(_up) + chc::memoryUsage(_down));
+		usage.add("edges", chc::memoryUsage(_up_edges) + chc::memoryUsage(_down_edges));
+		return usage;
+	}
+
+	CCHQuery::CCHQuery(CCHTopology const& topology, CCHMetric const& metric)
+		: _topology(topology), _metric(metric)
+	{
+		for (auto direction: {EdgeType::OUT, EdgeType::IN}) {
+			_dists[direction].assign(topology.getNrOfNodes(), c::NO_DIST);
+			_found_by[direction].assign(topology.getNrOfNodes(), c::NO_EID);
+		}
+	}
+
+	void CCHQuery::_search(uint rank, EdgeType direction)
+	{
+		auto& dists(_dists[direction]);
+		auto const& weights(direction == EdgeType::OUT ? _metric._up : _metric._down);
+
+		dists[rank] = 0;
+		for (; rank != c::NO_NID; rank = _topology.parent(rank)) {
+			_stats.settled_nodes++;
+			if (dists[rank] == c::NO_DIST) continue;
+
+			for (uint arc(_topology._up_offsets[rank]); arc < _topology._up_offsets[rank + 1]; arc++) {
+				_stats.relaxed_edges++;
+				uint const head(_topology._up_heads[arc]);
+				uint const dist(saturatingAdd(dists[rank], weights[arc]));
+				if (dist < dists[head]) {
+					dists[head] = dist;
+					_found_by[direction][head] = arc;
+				}
+			}
+		}
+	}
+
+	void CCHQuery::_reset(uint rank, EdgeType direction)
+	{
+		for (; rank != c::NO_NID; rank = _topology.parent(rank)) {
+			_dists[direction][rank] = c::NO_DIST;
+			_found_by[direction][rank] = c::NO_EID;
+		}
+	}
+
+	void CCHQuery::_backtrack(uint rank, uint start, EdgeType direction, std::vector<EdgeID>& path) const
+	{
+		std::vector<uint> arcs;
+		for (; rank != start; rank = _topology._arcTail(arcs.back())) {
+			arcs.push_back(_found_by[direction][rank]);
+		}
+
+		if (direction == EdgeType::OUT) {
+			for (auto it(arcs.rbegin()); it != arcs.rend(); it++) {
+				_metric._unpack(*it, true, path);
+			}
+		}
+		else {
+			for (auto arc: arcs) {
+				_metric._unpack(arc, false, path);
+			}
+		}
+	}
+
+	uint CCHQuery::calcShopa(NodeID src, NodeID tgt,
+			std::vector<EdgeID>& path)
+	{
+		path.clear();
+		_stats = SearchStats();
+
+		uint const src_rank(_topology.getRank(src));
+		uint const tgt_rank(_topology.getRank(tgt));
+		_search(src_rank, EdgeType::OUT);
+		_search(tgt_rank, EdgeType::IN);
+
+		/* both distances are only set on the common ancestors */
+		uint best_dist(c::NO_DIST);
+		uint best_rank(c::NO_NID);
+		for (uint rank(src_rank); rank != c::NO_NID; rank = _topology.parent(rank)) {
+			uint const dist(saturatingAdd(_dists[EdgeType::OUT][rank], _dists[EdgeType::IN][rank]));
+			if (dist < best_dist) {
+				best_dist = dist;
+				best_rank = rank;
+			}
+		}
+
+		if (best_dist == c::NO_DIST) {
+			Print("No path found from " << src << " to " << tgt << ".");
+		}
+		else {
+			_backtrack(best_rank, src_rank, EdgeType::OUT, path);
+			_backtrack(best_rank, tgt_rank, EdgeType::IN, path);
+		}
+
+		_reset(src_rank, EdgeType::OUT);
+		_reset(tgt_rank, EdgeType::IN);
+		return best_dist;
+	}
+}
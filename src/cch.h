@@ -0,0 +1,293 @@
+#pragma once
+
+#include "defs.h"
+#include "nodes_and_edges.h"
+#include "graph.h"
+#include "dijkstra.h"
+#include "memory_usage.h"
+
+#include <cmath>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+namespace chc
+{
+
+namespace unit_tests
+{
+	void testCCH();
+}
+
+/*
+ * Customizable CH (Dibbelt, Strasser, Wagner): the contraction is split in
+ *
+ *  1. a metric-independent part: a node order from a nested dissection of the
+ *     graph and the shortcut topology (the undirected graph contracted in
+ *     this order without witness searches, i.e. the upward neighbours of a
+ *     node form a clique). Computed once, and stored in a binary file;
+ *  2. the customization: the weights of all arcs for a metric, computed from
+ *     the lower triangles of the arcs. Takes linear passes, in parallel over
+ *     the nodes of one level of the elimination tree;
+ *  3. queries along the elimination tree: the upward neighbours of a node are
+ *     its ancestors, so a search just walks up from src and tgt, without
+ *     priority queue.
+ *
+ * Nodes are handled by rank. An arc connects a node to one of its upward
+ * neighbours and has an up (to the higher node) and a down weight.
+ */
+class CCHTopology
+{
+	public:
+		struct DownArc
+		{
+			uint tail; /* rank of the lower node */
+			uint arc;
+		};
+
+	private:
+		uint _nr_of_nodes = 0;
+		/* node -> rank and back */
+		std::vector<uint> _rank;
+		std::vector<NodeID> _node;
+
+		/* upward arcs by the rank of their lower node, sorted by head; the
+		 * position of an arc is its id */
+		std::vector<uint> _up_offsets;
+		std::vector<uint> _up_heads;
+
+		/* the same arcs by the rank of their higher node, sorted by tail */
+		std::vector<uint> _down_offsets;
+		std::vector<DownArc> _down_arcs;
+
+		/* ranks by level of the elimination tree (1 + the maximal level of
+		 * the downward neighbours) */
+		std::vector<uint> _level_offsets;
+		std::vector<uint> _level_nodes;
+
+		/* input edge id -> 2*arc + (1 if the edge is its down direction);
+		 * c::NO_EID for loops */
+		std::vector<EdgeID> _input_arcs;
+
+		void _buildArcs(std::vector<std::vector<uint>>& up);
+		void _buildDownArcs();
+		void _buildLevels();
+		void _mapInputEdges(std::vector<std::pair<NodeID, NodeID>> const& edges);
+		uint _findArc(uint tail, uint head) const;
+		uint _arcTail(uint arc) const;
+
+		friend class CCHMetric;
+		friend class CCHQuery;
+		friend void unit_tests::testCCH();
+	public:
+		/* order: the nodes by ascending rank */
+		template <typename Node, typename Edge>
+		void init(Graph<Node, Edge> const& g, std::vector<NodeID> const& order);
+
+		uint getNrOfNodes() const { return _nr_of_nodes; }
+		uint getNrOfArcs() const { return _up_heads.size(); }
+		uint getNrOfInputEdges() const { return _input_arcs.size(); }
+		uint getNrOfLevels() const { return _level_offsets.empty() ? 0 : _level_offsets.size() - 1; }
+		uint getRank(NodeID node) const { return _rank[node]; }
+
+		/* parent in the elimination tree: the lowest upward neighbour */
+		uint parent(uint rank) const
+		{
+			return _up_offsets[rank] == _up_offsets[rank + 1] ? c::NO_NID : _up_heads[_up_offsets[rank]];
+		}
+
+		MemoryUsage memoryUsage() const;
+
+		/*
+		 * Binary format: a header (magic, version, byte order check and the
+		 * sizes) followed by the order, the up arcs and the input arcs as
+		 * uint32_t in native byte order.
+		 */
+		void write(std::ostream& os) const;
+		/* aborts if the file is no valid topology */
+		static CCHTopology read(std::string const& filename);
+};
+
+/*
+ * The weights of the arcs of a topology for one metric.
+ */
+class CCHMetric
+{
+	private:
+		CCHTopology const* _topology = nullptr;
+
+		/* by arc */
+		std::vector<uint> _up;
+		std::vector<uint> _down;
+		/* input edge of the weight, c::NO_EID if it is a shortcut */
+		std::vector<EdgeID> _up_edges;
+		std::vector<EdgeID> _down_edges;
+
+		void _unpack(uint arc, bool up, std::vector<EdgeID>& path) const;
+
+		friend class CCHQuery;
+		friend void unit_tests::testCCH();
+	public:
+		CCHMetric() { }
+
+		/* weights: by input edge id (c::NO_DIST for closed edges) */
+		CCHMetric(CCHTopology const& topology, std::vector<uint> const& weights);
+
+		/* appends the input edges of arc in path order */
+		void unpack(uint arc, bool up, std::vector<EdgeID>& path) const { _unpack(arc, up, path); }
+
+		MemoryUsage memoryUsage() const;
+};
+
+/*
+ * Shortest path queries on a customized topology; like the Dijkstras, one
+ * object per thread.
+ */
+class CCHQuery
+{
+	private:
+		CCHTopology const& _topology;
+		CCHMetric const& _metric;
+
+		enum_array<std::vector<uint>, EdgeType, 2> _dists;
+		enum_array<std::vector<uint>, EdgeType, 2> _found_by; /* arc */
+		SearchStats _stats;
+
+		void _search(uint rank, EdgeType direction);
+		void _reset(uint rank, EdgeType direction);
+		void _backtrack(uint rank, uint start, EdgeType direction, std::vector<EdgeID>& path) const;
+	public:
+		CCHQuery(CCHTopology const& topology, CCHMetric const& metric);
+
+		/* like Dijkstra::calcShopa; path consists of input edge ids */
+		uint calcShopa(NodeID src, NodeID tgt,
+				std::vector<EdgeID>& path);
+
+		SearchStats const& getStats() const { return _stats; }
+};
+
+/* the distances of the edges of g, by edge id */
+template <typename Node, typename Edge>
+std::vector<uint> edgeWeights(Graph<Node, Edge> const& g)
+{
+	std::vector<uint> weights(g.getNrOfEdges(), c::NO_DIST);
+	for (EdgeID edge_id(0); edge_id < weights.size(); edge_id++) {
+		weights[edge_id] = g.getEdge(edge_id).distance();
+	}
+	return weights;
+}
+
+/*
+ * Metric-independent order by recursive coordinate bisection: a cell is
+ * split at the median of its longer side, the smaller of the two boundaries
+ * becomes the separator and gets the highest ranks of the cell, the rest is
+ * split further. The nodes need lat and lon; returns the nodes by rank.
+ */
+template <typename Node, typename Edge>
+std::vector<NodeID> calcNestedDissectionOrder(Graph<Node, Edge> const& g)
+{
+	uint const nr_of_nodes(g.getNrOfNodes());
+	std::vector<NodeID> order(nr_of_nodes);
+	uint next_rank(nr_of_nodes);
+
+	/* cell of a node during the split; 0 for separated nodes */
+	std::vector<uint> side(nr_of_nodes, 0);
+	uint next_side(1);
+
+	auto is_boundary = [&](NodeID node, uint other_side) {
+		for (uint i(0); i<2; i++) {
+			for (auto const& edge: g.nodeEdges(node, (EdgeType) i)) {
+				if (side[otherNode(edge, (EdgeType) i)] == other_side) return true;
+			}
+		}
+		return false;
+	};
+
+	std::vector<std::vector<NodeID>> cells(1, std::vector<NodeID>(nr_of_nodes));
+	for (NodeID node(0); node < nr_of_nodes; node++) {
+		cells[0][node] = node;
+	}
+	while (!cells.empty()) {
+		std::vector<NodeID> cell(std::move(cells.back()));
+		cells.pop_back();
+		if (cell.size() <= 2) {
+			for (auto node: cell) order[--next_rank] = node;
+			continue;
+		}
+
+		/* split at the median of the longer side of the bounding box */
+		double min_lat(90), max_lat(-90), min_lon(180), max_lon(-180);
+		for (auto node: cell) {
+			Node const& n(g.getNode(node));
+			min_lat = std::min(min_lat, n.lat); max_lat = std::max(max_lat, n.lat);
+			min_lon = std::min(min_lon, n.lon); max_lon = std::max(max_lon, n.lon);
+		}
+		double const lon_scale(std::cos((min_lat + max_lat) / 2 * M_PI / 180));
+		bool const by_lat(max_lat - min_lat >= (max_lon - min_lon) * lon_scale);
+		auto const middle(cell.begin() + cell.size() / 2);
+		std::nth_element(cell.begin(), middle, cell.end(), [&](NodeID node1, NodeID node2) {
+			Node const& n1(g.getNode(node1));
+			Node const& n2(g.getNode(node2));
+			return by_lat ? n1.lat < n2.lat : n1.lon < n2.lon;
+		});
+
+		uint const left_side(next_side++);
+		uint const right_side(next_side++);
+		std::vector<NodeID> left(cell.begin(), middle);
+		std::vector<NodeID> right(middle, cell.end());
+		for (auto node: left) side[node] = left_side;
+		for (auto node: right) side[node] = right_side;
+
+		std::vector<NodeID> left_boundary, right_boundary;
+		for (auto node: left) {
+			if (is_boundary(node, right_side)) left_boundary.push_back(node);
+		}
+		for (auto node: right) {
+			if (is_boundary(node, left_side)) right_boundary.push_back(node);
+		}
+
+		auto const& separator(left_boundary.size() <= right_boundary.size() ? left_boundary : right_boundary);
+		for (auto node: separator) {
+			side[node] = 0;
+			order[--next_rank] = node;
+		}
+		for (auto part: {&left, &right}) {
+			part->erase(std::remove_if(part->begin(), part->end(),
+					[&side](NodeID node) { return side[node] == 0; }), part->end());
+			if (!part->empty()) cells.push_back(std::move(*part));
+		}
+	}
+
+	return order;
+}
+
+template <typename Node, typename Edge>
+void CCHTopology::init(Graph<Node, Edge> const& g, std::vector<NodeID> const& order)
+{
+	_nr_of_nodes = g.getNrOfNodes();
+	_node = order;
+	_rank.assign(_nr_of_nodes, c::NO_NID);
+	for (uint rank(0); rank < _nr_of_nodes; rank++) {
+		_rank[_node[rank]] = rank;
+	}
+
+	/* upward neighbours of the undirected graph */
+	std::vector<std::vector<uint>> up(_nr_of_nodes);
+	std::vector<std::pair<NodeID, NodeID>> edges(g.getNrOfEdges());
+	for (EdgeID edge_id(0); edge_id < edges.size(); edge_id++) {
+		auto const& edge(g.getEdge(edge_id));
+		edges[edge_id] = std::make_pair(edge.src, edge.tgt);
+		uint const src_rank(_rank[edge.src]);
+		uint const tgt_rank(_rank[edge.tgt]);
+		if (src_rank != tgt_rank) {
+			up[std::min(src_rank, tgt_rank)].push_back(std::max(src_rank, tgt_rank));
+		}
+	}
+
+	_buildArcs(up);
+	_buildLevels();
+	_mapInputEdges(edges);
+}
+
+}
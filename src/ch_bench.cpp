@@ -0,0 +1,444 @@
+#include "defs.h"
+#include "tool_helpers.h"
+#include "file_formats.h"
+#include "chgraph.h"
+#include "ch_constructor.h"
+#include "graph_generator.h"
+
+#include <getopt.h>
+#include <omp.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+
+using namespace chc;
+
+void printHelp()
+{
+	std::cout
+		<< "Usage: ./ch_bench [ARGUMENTS]\n"
+		<< "Times the phases of the CH construction (reading, init, quick contraction,\n"
+		<< "contraction split into choosing the independent set, witness searches and\n"
+		<< "restructuring, export, writing) over repeated runs and reports min / median.\n"
+		<< "Without -i and -G the graphs in test_data and a generated 100x100 grid are used.\n"
+		<< "Optional arguments are:\n"
+		<< "  -i, --infile <path>        Benchmark the graph in <path> (can be given several times)\n"
+		<< "  -f, --informat <format>    Format of the following infiles (STD, SIMPLE, FMI, FMI_DIST, FMI_EUCL - default FMI)\n"
+		<< "  -G, --grid <w>x<h>         Benchmark a generated <w> x <h> grid graph (can be given several times)\n"
+		<< "  -r, --repeats <number>     Number of runs per graph (default: 5)\n"
+		<< "  -t, --threads <number>     Number of threads to use in the calculations (default: 1)\n"
+		<< "  -o, --outfile <path>       Write the CH graphs to <path> (FMI_CH; default: ch_bench.out, removed afterwards)\n"
+		<< "  -j, --json <path>          Also write the results as JSON to <path> ('-' for stdout)\n"
+		<< "  -R, --readers              Compare the stream based text readers (std::istream >>) with the\n"
+		<< "                             scanning readers (memory mapped file) on the infiles instead\n";
+}
+
+/* run times of repeated runs in seconds */
+struct Samples
+{
+	std::vector<double> seconds;
+
+	double min() const { return *std::min_element(seconds.begin(), seconds.end()); }
+	double median() const
+	{
+		std::vector<double> sorted(seconds);
+		std::sort(sorted.begin(), sorted.end());
+		return sorted[sorted.size() / 2];
+	}
+};
+
+template<typename Callable>
+Samples measure(uint repeats, Callable&& callable)
+{
+	using namespace std::chrono;
+
+	Samples samples;
+	for (uint i(0); i < repeats; i++) {
+		steady_clock::time_point t1 = steady_clock::now();
+		callable();
+		samples.seconds.push_back(duration_cast<duration<double>>(steady_clock::now() - t1).count());
+	}
+	return samples;
+}
+
+template<typename StreamReader, typename Reader>
+void benchReaders(std::string const& infile, uint repeats)
+{
+	typedef typename Reader::node_type NodeT;
+	typedef typename Reader::chedge_type EdgeT;
+
+	size_t nr_of_nodes(0), nr_of_edges(0);
+	Samples stream_samples(measure(repeats, [&] {
+		auto data(StreamReader::template readGraph<NodeT, EdgeT>(infile));
+		nr_of_nodes = data.nodes.size();
+		nr_of_edges = data.edges.size();
+	}));
+	Samples scan_samples(measure(repeats, [&] {
+		auto data(Reader::template readGraph<NodeT, EdgeT>(infile));
+		if (data.nodes.size() != nr_of_nodes || data.edges.size() != nr_of_edges) {
+			std::cerr << "FATAL_ERROR: readers disagree on the number of nodes / edges. Exiting.\n";
+			std::abort();
+		}
+	}));
+
+	std::cout << "Read " << nr_of_nodes << " nodes and " << nr_of_edges << " edges from " << infile << "\n";
+	std::cout << "stream reader: min " << stream_samples.min() << " s, median " << stream_samples.median() << " s\n";
+	std::cout << "scan reader:   min " << scan_samples.min() << " s, median " << scan_samples.median() << " s\n";
+	std::cout << "speedup (median): " << stream_samples.median() / scan_samples.median() << "\n";
+}
+
+bool benchReaders(FileFormat informat, std::string const& infile, uint repeats)
+{
+	switch (informat) {
+	case FileFormat::STD:
+		benchReaders<FormatSTD::StreamReader, FormatSTD::Reader>(infile, repeats);
+		return true;
+	case FileFormat::SIMPLE:
+		benchReaders<FormatSimple::StreamReader, FormatSimple::Reader>(infile, repeats);
+		return true;
+	case FileFormat::FMI:
+		benchReaders<FormatFMI::StreamReader, FormatFMI::Reader>(infile, repeats);
+		return true;
+	case FileFormat::FMI_DIST:
+		benchReaders<FormatFMI_DIST::StreamReader, FormatFMI_DIST::Reader>(infile, repeats);
+		return true;
+	case FileFormat::FMI_EUCL:
+		benchReaders<FormatFMI_EUCL::StreamReader, FormatFMI_EUCL::Reader>(infile, repeats);
+		return true;
+	case FileFormat::FMI_CH:
+		benchReaders<FormatFMI_CH::StreamReader, FormatFMI_CH::Reader>(infile, repeats);
+		return true;
+	case FileFormat::FMI_EUCL_CH:
+	case FileFormat::STEFAN_CH:
+	case FileFormat::BINARY_CH:
+		break;
+	}
+	std::cerr << "No text reader for format " << to_string(informat) << "\n";
+	return false;
+}
+
+typedef CHEdge<OSMEdge> Shortcut;
+typedef CHConstructor<OSMNode, OSMEdge> CHConstructorT;
+
+/* samples of named phases, in the order they were first added */
+struct Phases
+{
+	std::vector<std::string> names;
+	std::vector<Samples> samples;
+
+	void add(std::string const& name, double seconds)
+	{
+		auto it(std::find(names.begin(), names.end(), name));
+		if (it == names.end()) {
+			names.push_back(name);
+			samples.emplace_back();
+			it = names.end() - 1;
+		}
+		samples[it - names.begin()].seconds.push_back(seconds);
+	}
+};
+
+/* the rounds are the same in every run, only their times differ */
+struct RoundSamples
+{
+	CHConstructorT::RoundStats stats;
+	Samples independent_set, contraction, restructure, time;
+};
+
+struct GraphResult
+{
+	std::string name;
+	size_t nr_of_nodes = 0;
+	size_t nr_of_edges = 0;
+	size_t nr_of_ch_edges = 0;
+	Phases phases;
+	std::vector<RoundSamples> rounds;
+};
+
+/* one graph source: name, name of the phase which creates the graph and the function doing so */
+struct GraphSource
+{
+	std::string name;
+	std::string read_phase;
+	std::function<GraphInData<OSMNode, Shortcut>()> read;
+};
+
+GraphResult benchConstruction(GraphSource const& source, uint repeats, uint nr_of_threads, std::string const& outfile)
+{
+	using namespace std::chrono;
+
+	GraphResult result;
+	result.name = source.name;
+
+	for (uint repeat(0); repeat < repeats; repeat++) {
+		steady_clock::time_point t = steady_clock::now();
+		auto lap = [&t]() {
+			steady_clock::time_point now = steady_clock::now();
+			double seconds(duration_cast<duration<double>>(now - t).count());
+			t = now;
+			return seconds;
+		};
+
+		auto data(source.read());
+		result.nr_of_nodes = data.nodes.size();
+		result.nr_of_edges = data.edges.size();
+		result.phases.add(source.read_phase, lap());
+
+		/* init includes setting up the per-thread data of the CHConstructor */
+		CHGraph<OSMNode, OSMEdge> g;
+		g.init(std::move(data));
+		CHConstructorT chc(g, nr_of_threads);
+		auto all_nodes(allNodes(g));
+		result.phases.add("init", lap());
+
+		chc.quickContract(all_nodes, 4, 5);
+		result.phases.add("quick_contract", lap());
+
+		chc.contract(all_nodes);
+		result.phases.add("contract", lap());
+
+		auto export_data(g.exportData());
+		result.nr_of_ch_edges = export_data.edges.size();
+		result.phases.add("export_data", lap());
+
+		writeCHGraphFile<FormatFMI_CH::Writer>(outfile, export_data);
+		result.phases.add("writing", lap());
+
+		auto const& round_stats(chc.getRoundStats());
+		double sums[2][3] = {{0, 0, 0}, {0, 0, 0}};
+		for (auto const& stats: round_stats) {
+			sums[stats.quick][0] += stats.independent_set_time;
+			sums[stats.quick][1] += stats.contraction_time;
+			sums[stats.quick][2] += stats.restructure_time;
+		}
+		result.phases.add("quick_contract.independent_set", sums[1][0]);
+		result.phases.add("quick_contract.contraction", sums[1][1]);
+		result.phases.add("quick_contract.restructure", sums[1][2]);
+		result.phases.add("contract.independent_set", sums[0][0]);
+		result.phases.add("contract.witness_search", sums[0][1]);
+		result.phases.add("contract.restructure", sums[0][2]);
+
+		if (result.rounds.size() < round_stats.size()) result.rounds.resize(round_stats.size());
+		for (size_t i(0); i < round_stats.size(); i++) {
+			auto& round(result.rounds[i]);
+			round.stats = round_stats[i];
+			round.independent_set.seconds.push_back(round_stats[i].independent_set_time);
+			round.contraction.seconds.push_back(round_stats[i].contraction_time);
+			round.restructure.seconds.push_back(round_stats[i].restructure_time);
+			round.time.seconds.push_back(round_stats[i].time);
+		}
+	}
+
+	return result;
+}
+
+void printResult(GraphResult const& result)
+{
+	std::cout << "\n" << result.name << ": " << result.nr_of_nodes << " nodes, " << result.nr_of_edges
+		<< " edges, " << result.nr_of_ch_edges << " edges in the CH, " << result.rounds.size() << " rounds\n";
+	for (size_t i(0); i < result.phases.names.size(); i++) {
+		auto const& samples(result.phases.samples[i]);
+		std::printf("  %-32s min %10.4f s   median %10.4f s\n", result.phases.names[i].c_str(), samples.min(), samples.median());
+	}
+	std::cout.flush();
+}
+
+std::string jsonString(std::string const& str)
+{
+	std::string result("\"");
+	for (char c: str) {
+		if ('"' == c || '\\' == c) result += '\\';
+		result += c;
+	}
+	return result + "\"";
+}
+
+void writeSamples(std::ostream& os, Samples const& samples)
+{
+	os << "{\"min\": " << samples.min() << ", \"median\": " << samples.median() << ", \"samples\": [";
+	for (size_t i(0); i < samples.seconds.size(); i++) {
+		os << (i ? ", " : "") << samples.seconds[i];
+	}
+	os << "]}";
+}
+
+void writeJson(std::ostream& os, std::vector<GraphResult> const& results, uint repeats, uint nr_of_threads)
+{
+	os.precision(9);
+	os << "{\n  \"repeats\": " << repeats << ",\n  \"threads\": " << nr_of_threads << ",\n  \"graphs\": [";
+	for (size_t g(0); g < results.size(); g++) {
+		auto const& result(results[g]);
+		os << (g ? "," : "") << "\n    {\n"
+			<< "      \"name\": " << jsonString(result.name) << ",\n"
+			<< "      \"nodes\": " << result.nr_of_nodes << ",\n"
+			<< "      \"edges\": " << result.nr_of_edges << ",\n"
+			<< "      \"ch_edges\": " << result.nr_of_ch_edges << ",\n"
+			<< "      \"phases\": {";
+		for (size_t i(0); i < result.phases.names.size(); i++) {
+			os << (i ? "," : "") << "\n        " << jsonString(result.phases.names[i]) << ": ";
+			writeSamples(os, result.phases.samples[i]);
+		}
+		os << "\n      },\n      \"rounds\": [";
+		for (size_t i(0); i < result.rounds.size(); i++) {
+			auto const& round(result.rounds[i]);
+			os << (i ? "," : "") << "\n        {\"quick\": " << (round.stats.quick ? "true" : "false")
+				<< ", \"nodes\": " << round.stats.nr_of_nodes
+				<< ", \"candidates\": " << round.stats.nr_of_candidates
+				<< ", \"shortcuts\": " << round.stats.nr_of_shortcuts
+				<< ", \"removed\": " << round.stats.nr_of_removed
+				<< ", \"independent_set\": " << round.independent_set.median()
+				<< ", \"contraction\": " << round.contraction.median()
+				<< ", \"restructure\": " << round.restructure.median()
+				<< ", \"time\": " << round.time.median() << "}";
+		}
+		os << "\n      ]\n    }";
+	}
+	os << "\n  ]\n}\n";
+}
+
+bool parseGrid(std::string const& arg, uint& width, uint& height)
+{
+	auto x(arg.find('x'));
+	if (x == std::string::npos) return false;
+	std::string const w(arg.substr(0, x)), h(arg.substr(x + 1));
+	if (w.empty() || h.empty() || w.find_first_not_of("0123456789") != std::string::npos ||
+			h.find_first_not_of("0123456789") != std::string::npos) {
+		return false;
+	}
+	width = std::stoi(w);
+	height = std::stoi(h);
+	return width && height;
+}
+
+GraphSource fileSource(FileFormat format, std::string const& infile)
+{
+	return GraphSource{infile + " (" + to_string(format) + ")", "reading", [format, infile] {
+		return readGraph<OSMNode, Shortcut>(format, infile);
+	}};
+}
+
+GraphSource gridSource(uint width, uint height)
+{
+	return GraphSource{"grid " + std::to_string(width) + "x" + std::to_string(height), "generating", [width, height] {
+		auto data(generator::gridGraph(width, height));
+		return GraphInData<OSMNode, Shortcut>{std::move(data.nodes),
+			std::vector<Shortcut>(data.edges.begin(), data.edges.end()), std::move(data.meta_data)};
+	}};
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<std::pair<FileFormat, std::string>> infiles;
+	std::vector<GraphSource> sources;
+	FileFormat informat(FileFormat::FMI);
+	uint repeats(5);
+	uint nr_of_threads(1);
+	std::string outfile;
+	std::string json_file;
+	bool readers(false);
+
+	const struct option longopts[] = {
+		{"help",	no_argument,        0, 'h'},
+		{"infile",	required_argument,  0, 'i'},
+		{"informat",	required_argument,  0, 'f'},
+		{"grid",	required_argument,  0, 'G'},
+		{"repeats",	required_argument,  0, 'r'},
+		{"threads",	required_argument,  0, 't'},
+		{"outfile",	required_argument,  0, 'o'},
+		{"json",	required_argument,  0, 'j'},
+		{"readers",	no_argument,        0, 'R'},
+		{0,0,0,0},
+	};
+
+	int index(0);
+	int iarg(0);
+	opterr = 1;
+
+	while((iarg = getopt_long(argc, argv, "hi:f:G:r:t:o:j:R", longopts, &index)) != -1) {
+		uint width(0), height(0);
+		switch (iarg) {
+			case 'h':
+				printHelp();
+				return 0;
+				break;
+			case 'i':
+				infiles.emplace_back(informat, optarg);
+				sources.push_back(fileSource(informat, optarg));
+				break;
+			case 'f':
+				informat = toFileFormat(optarg);
+				break;
+			case 'G':
+				if (!parseGrid(optarg, width, height)) {
+					std::cerr << "Invalid grid size: '" << optarg << "'\n";
+					return 1;
+				}
+				sources.push_back(gridSource(width, height));
+				break;
+			case 'r':
+				repeats = parseUInt(optarg, "number of repeats");
+				if (repeats == 0) {
+					std::cerr << "Invalid number of repeats: '" << optarg << "'\n";
+					return 1;
+				}
+				break;
+			case 't':
+				nr_of_threads = parseThreads(optarg);
+				break;
+			case 'o':
+				outfile = optarg;
+				break;
+			case 'j':
+				json_file = optarg;
+				break;
+			case 'R':
+				readers = true;
+				break;
+			default:
+				printHelp();
+				return 1;
+				break;
+		}
+	}
+
+	omp_set_num_threads(nr_of_threads);
+	if (readers) {
+		if (infiles.empty()) infiles.emplace_back(FileFormat::FMI, "test_data/15kSZHK_fmi.txt");
+		for (auto const& infile: infiles) {
+			if (!benchReaders(infile.first, infile.second, repeats)) return 1;
+		}
+		return 0;
+	}
+
+	if (sources.empty()) {
+		sources.push_back(fileSource(FileFormat::STD, "test_data/15kSZHK.txt"));
+		sources.push_back(fileSource(FileFormat::FMI, "test_data/15kSZHK_fmi.txt"));
+		sources.push_back(gridSource(100, 100));
+	}
+
+	bool const remove_outfile(outfile.empty());
+	if (remove_outfile) outfile = "ch_bench.out";
+
+	std::vector<GraphResult> results;
+	for (auto const& source: sources) {
+		results.push_back(benchConstruction(source, repeats, nr_of_threads, outfile));
+		printResult(results.back());
+	}
+	if (remove_outfile) std::remove(outfile.c_str());
+
+	if (json_file == "-") {
+		writeJson(std::cout, results, repeats, nr_of_threads);
+	}
+	else if (!json_file.empty()) {
+		std::ofstream os(json_file);
+		if (!os.is_open()) {
+			std::cerr << "FATAL_ERROR: Couldn't open json file \'" << json_file << "\'. Exiting." << std::endl;
+			return 1;
+		}
+		writeJson(os, results, repeats, nr_of_threads);
+	}
+
+	return 0;
+}
@@ -0,0 +1,205 @@
+#include "defs.h"
+#include "tool_helpers.h"
+#include "cch.h"
+#include "dijkstra.h"
+#include "file_formats.h"
+#include "metrics.h"
+
+#include <getopt.h>
+#include <omp.h>
+#include <chrono>
+#include <fstream>
+#include <random>
+
+using namespace chc;
+
+void printHelp()
+{
+	std::cout
+		<< "Usage: ./ch_cch [ARGUMENTS]\n"
+		<< "Customizable CH: computes the metric-independent node order (nested dissection by\n"
+		<< "coordinates) and shortcut topology of a graph once, and customizes it for a metric\n"
+		<< "in parallel, so changed weights (e.g. traffic updates) don't need a new contraction.\n"
+		<< "Mandatory arguments are:\n"
+		<< "  -i, --infile <path>        Read graph from <path>\n"
+		<< "Optional arguments are:\n"
+		<< "  -f, --informat <format>    Expects infile in <format> (STD, SIMPLE, FMI, FMI_DIST, FMI_EUCL - default FMI_DIST)\n"
+		<< "  -o, --outfile <path>       Writes the topology to <path>\n"
+		<< "  -c, --topology <path>      Reads the topology of this graph from <path> instead of computing it\n"
+		<< "  -M, --metrics <list>       Customizes for the metrics in <list>, e.g. DIST,TIME (default: DIST).\n"
+		<< "                             TIME needs the informat FMI_DIST.\n"
+		<< "  -t, --threads <number>     Number of threads to use in the customization (default: 1)\n"
+		<< "  -n, --random <number>      Number of random queries checked against Dijkstra per metric (default: 1000)\n"
+		<< "  -r, --seed <number>        Seed for the queries (default: 0)\n"
+		<< "Exits with 1 if a distance differs from Dijkstra.\n";
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+	std::string infile("");
+	FileFormat informat(FileFormat::FMI_DIST);
+	std::string outfile("");
+	std::string topology_file("");
+	std::vector<Metric> metrics(1, Metric::DIST);
+	uint nr_of_threads(1);
+	uint nr_of_queries(1000);
+	uint seed(0);
+
+	const struct option longopts[] = {
+		{"help",	no_argument,        0, 'h'},
+		{"infile",	required_argument,  0, 'i'},
+		{"informat",	required_argument,  0, 'f'},
+		{"outfile",	required_argument,  0, 'o'},
+		{"topology",	required_argument,  0, 'c'},
+		{"metrics",	required_argument,  0, 'M'},
+		{"threads",	required_argument,  0, 't'},
+		{"random",	required_argument,  0, 'n'},
+		{"seed",	required_argument,  0, 'r'},
+		{0,0,0,0},
+	};
+
+	int index(0);
+	int iarg(0);
+	opterr = 1;
+
+	while((iarg = getopt_long(argc, argv, "hi:f:o:c:M:t:n:r:", longopts, &index)) != -1) {
+		switch (iarg) {
+			case 'h':
+				printHelp();
+				return 0;
+				break;
+			case 'i':
+				infile = optarg;
+				break;
+			case 'f':
+				informat = toFileFormat(optarg);
+				break;
+			case 'o':
+				outfile = optarg;
+				break;
+			case 'c':
+				topology_file = optarg;
+				break;
+			case 'M':
+				metrics = toMetrics(optarg);
+				break;
+			case 't':
+				nr_of_threads = parseThreads(optarg);
+				break;
+			case 'n':
+				nr_of_queries = parseUInt(optarg, "number of queries");
+				break;
+			case 'r':
+				seed = parseUInt(optarg, "seed");
+				break;
+			default:
+				printHelp();
+				return 1;
+				break;
+		}
+	}
+
+	if (infile == "") {
+		std::cerr << "No input file specified! Exiting.\n";
+		std::cerr << "Use ./ch_cch --help to print the usage.\n";
+		return 1;
+	}
+	for (auto metric: metrics) {
+		if (metric == Metric::TIME && informat != FileFormat::FMI_DIST) {
+			std::cerr << "The metric TIME needs the informat FMI_DIST! Exiting.\n";
+			return 1;
+		}
+	}
+	omp_set_num_threads(nr_of_threads);
+
+	auto data(readGraph<OSMNode, OSMEdge>(informat, infile));
+	Graph<OSMNode, OSMEdge> g;
+	g.init(GraphInData<OSMNode, OSMEdge>(data));
+
+	CCHTopology topology;
+	auto start(std::chrono::steady_clock::now());
+	if (!topology_file.empty()) {
+		topology = CCHTopology::read(topology_file);
+		if (topology.getNrOfNodes() != g.getNrOfNodes() || topology.getNrOfInputEdges() != g.getNrOfEdges()) {
+			std::cerr << "FATAL_ERROR: The topology in " << topology_file << " doesn't belong to "
+				<< infile << ". Exiting." << std::endl;
+			return 1;
+		}
+		std::cout << "Read the topology in " << secondsSince(start) << " s\n";
+	}
+	else {
+		topology.init(g, calcNestedDissectionOrder(g));
+		std::cout << "Computed the order and topology in " << secondsSince(start) << " s\n";
+	}
+	std::cout << "Graph with " << g.getNrOfNodes() << " nodes and " << g.getNrOfEdges() << " edges, topology with "
+		<< topology.getNrOfArcs() << " arcs on " << topology.getNrOfLevels() << " levels\n";
+	std::cout << "Memory of the topology: " << topology.memoryUsage().toString() << "\n";
+
+	if (!outfile.empty()) {
+		std::ofstream os(outfile, std::ios::binary);
+		topology.write(os);
+		if (!os) {
+			std::cerr << "FATAL_ERROR: Couldn't write " << outfile << ". Exiting." << std::endl;
+			return 1;
+		}
+		std::cout << "Wrote the topology to " << outfile << "\n";
+	}
+
+	bool mismatch(false);
+	for (auto metric: metrics) {
+		/* the graph with the weights of the metric, for Dijkstra */
+		auto metric_data(data);
+		if (metric == Metric::TIME) {
+			for (auto& edge: metric_data.edges) {
+				edge.dist = calcTravelTime(edge);
+			}
+		}
+		Graph<OSMNode, OSMEdge> metric_g;
+		metric_g.init(std::move(metric_data));
+
+		auto weights(edgeWeights(metric_g));
+		start = std::chrono::steady_clock::now();
+		CCHMetric cch_metric(topology, weights);
+		std::cout << "Customized " << to_string(metric) << " with " << nr_of_threads << " threads in "
+			<< secondsSince(start) << " s, memory: " << cch_metric.memoryUsage().toString() << "\n";
+
+		if (g.getNrOfNodes() == 0) continue;
+
+		std::default_random_engine gen(seed);
+		std::uniform_int_distribution<uint> dist(0, g.getNrOfNodes()-1);
+		Dijkstra<OSMNode, OSMEdge> dij(metric_g);
+		CCHQuery query(topology, cch_metric);
+		std::vector<EdgeID> path;
+		double cch_seconds(0), dij_seconds(0);
+		size_t cch_settled(0), dij_settled(0);
+		for (uint i(0); i < nr_of_queries; i++) {
+			NodeID const src(dist(gen));
+			NodeID const tgt(dist(gen));
+			start = std::chrono::steady_clock::now();
+			uint const cch_dist(query.calcShopa(src, tgt, path));
+			cch_seconds += secondsSince(start);
+			cch_settled += query.getStats().settled_nodes;
+			start = std::chrono::steady_clock::now();
+			uint const dij_dist(dij.calcShopa(src, tgt, path));
+			dij_seconds += secondsSince(start);
+			dij_settled += dij.getStats().settled_nodes;
+			if (cch_dist != dij_dist) {
+				std::cerr << "Distance mismatch from " << src << " to " << tgt << ": CCH "
+					<< cch_dist << ", Dijkstra " << dij_dist << "\n";
+				mismatch = true;
+			}
+		}
+		if (nr_of_queries > 0) {
+			std::cout << nr_of_queries << " queries: CCH " << cch_seconds * 1e6 / nr_of_queries << " us, "
+				<< cch_settled / nr_of_queries << " settled; Dijkstra " << dij_seconds * 1e6 / nr_of_queries
+				<< " us, " << dij_settled / nr_of_queries << " settled\n";
+		}
+	}
+
+	return mismatch ? 1 : 0;
+}
@@ -1,11 +1,21 @@
 #include "defs.h"
+#include "tool_helpers.h"
 #include "unit_tests.h"
 #include "ch_constructor.h"
 #include "file_formats.h"
 #include "track_time.h"
+#include "trace.h"
 #include "prioritizers.h"
+#include "metrics.h"
 
 #include <getopt.h>
+#include <omp.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <memory>
 
 using namespace chc;
 using namespace std::chrono;
@@ -22,9 +32,118 @@ void printHelp()
 		<< "  -g, --outformat <format>   Writes outfile in <format> (" << getAllFileFormatsString() << " - default FMI_CH)\n"
 		<< "  -t, --threads <number>     Number of threads to use in the calculations (default: 1)\n"
 		<< "  -p, --prioritizer <type>   Uses prioritizer <type> for the CH construction. (default: NONE)\n"
+		<< "  -c, --cache-input <dir>    Reuse a binary snapshot of the preprocessed input from <dir>,\n"
+		<< "                             or store one there if there is none for this input yet\n"
+		<< "  -s, --stats                Print the work of the contraction per round and thread\n"
+		<< "                             (needs a build with cmake -DCHC_STATS=ON)\n"
+		<< "  -m, --memory               Print the memory of the data structures and the peak RSS\n"
+		<< "                             after each phase and round\n"
+		<< "  -T, --timings <path>       Write the times of the phases, contraction rounds and their steps\n"
+		<< "                             as JSON to <path> ('-' for stdout)\n"
+		<< "  -j, --progress <path>      Write one JSON line per contraction round with the remaining nodes,\n"
+		<< "                             edges, shortcuts, times and an ETA to <path> ('-' for stdout,\n"
+		<< "                             /dev/fd/<n> for a file descriptor)\n"
+		<< "  -r, --trace <path>         Write a timeline of the contraction rounds and the nodes contracted\n"
+		<< "                             by each thread to <path> (Chrome trace-event JSON)\n"
+		<< "  -P, --perf-counters        Add the cycles, instructions, LLC and dTLB misses to the timings\n"
+		<< "                             (Linux perf_event_open; see /proc/sys/kernel/perf_event_paranoid)\n"
+		<< "  -M, --metrics <list>       Build one CH per metric in <list> (DIST, TIME, e.g. DIST,TIME) from one\n"
+		<< "                             read of the input (needs FMI_DIST) and write each to <outfile>.<metric>\n"
+		<< "                             (the trace to <path>.<metric>)\n"
+		<< "  -O, --share-order          With --metrics, contract the graphs of the further metrics in the\n"
+		<< "                             order of the first one instead of choosing an order for each\n"
 		<< "Note: not all formats are available as input / ouput format, and not all combinations are possible.\n";
 }
 
+#ifdef CHC_STATS
+void printCounters(ContractionCounters const& counters)
+{
+	std::printf("%12zu %12zu %14zu %14zu %12zu %10.3f", counters.contracted_nodes, counters.searches,
+			counters.settled_nodes, counters.pushes, counters.shortcuts, counters.time);
+}
+
+template<typename NodeT, typename EdgeT>
+void printStats(CHConstructor<NodeT, EdgeT> const& chc)
+{
+	char const* header = "%12s %12s %14s %14s %12s %10s";
+
+	std::cout << "\nContraction statistics per round:\n";
+	std::printf("%6s %6s ", "round", "quick");
+	std::printf(header, "contracted", "searches", "settled", "pushes", "shortcuts", "time [s]");
+	std::printf(" %10s\n", "imbalance");
+	auto const& rounds(chc.getRoundStats());
+	for (size_t r(0); r < rounds.size(); r++) {
+		ContractionCounters sum;
+		double max_time(0);
+		for (auto const& counters: rounds[r].threads) {
+			sum += counters;
+			max_time = std::max(max_time, counters.time);
+		}
+		/* slowest thread compared to the average */
+		double imbalance(sum.time > 0 ? max_time * rounds[r].threads.size() / sum.time : 1);
+		std::printf("%6zu %6s ", r + 1, rounds[r].quick ? "yes" : "no");
+		printCounters(sum);
+		std::printf(" %10.2f\n", imbalance);
+	}
+
+	auto const stats(chc.getStats());
+	std::cout << "\nContraction statistics per thread:\n";
+	std::printf("%13s ", "thread");
+	std::printf(header, "contracted", "searches", "settled", "pushes", "shortcuts", "time [s]");
+	std::printf("\n");
+	for (size_t t(0); t < stats.threads.size(); t++) {
+		std::printf("%13zu ", t);
+		printCounters(stats.threads[t]);
+		std::printf("\n");
+	}
+	std::printf("%13s ", "total");
+	printCounters(stats.total());
+	std::printf("\n");
+}
+#endif
+
+void printMemory(char const* phase, MemoryUsage const& usage)
+{
+	std::cout << "Memory after " << phase << ": " << usage.toString()
+		<< ", peak RSS " << MemoryUsage::formatBytes(peakRSS()) << "\n";
+}
+
+template<typename NodeT, typename EdgeT>
+void printRoundMemory(CHConstructor<NodeT, EdgeT> const& chc)
+{
+	std::cout << "\nMemory at the end of the rounds:\n";
+	std::printf("%6s %6s %12s %12s %12s\n", "round", "quick", "graph", "constructor", "peak RSS");
+	auto const& rounds(chc.getRoundStats());
+	for (size_t r(0); r < rounds.size(); r++) {
+		std::printf("%6zu %6s %12s %12s %12s\n", r + 1, rounds[r].quick ? "yes" : "no",
+				MemoryUsage::formatBytes(rounds[r].graph_memory).c_str(),
+				MemoryUsage::formatBytes(rounds[r].constructor_memory).c_str(),
+				MemoryUsage::formatBytes(rounds[r].peak_rss).c_str());
+	}
+	std::cout << "\n";
+}
+
+void writeTrace(Tracer const& tracer, std::string const& trace_file)
+{
+	std::ofstream os(trace_file);
+	if (!os.is_open()) {
+		std::cerr << "FATAL_ERROR: Couldn't open trace file \'" << trace_file << "\'." << std::endl;
+		std::abort();
+	}
+	tracer.writeJson(os);
+	if (tracer.dropped()) {
+		std::cerr << "WARNING: The trace lacks the " << tracer.dropped() << " oldest events.\n";
+	}
+}
+
+/* ".<metric in lower case>", appended to the output and trace files of a metric */
+std::string metricSuffix(Metric metric)
+{
+	std::string name(to_string(metric));
+	std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+	return "." + name;
+}
+
 struct BuildAndStoreCHGraph {
 	FileFormat outformat;
 	std::string outfile;
@@ -32,42 +151,147 @@ struct BuildAndStoreCHGraph {
 	TrackTime tt;
 
 	PrioritizerType prioritizer_type;
+	std::string timings_file;
+	bool print_stats;
+	bool print_memory;
+	std::string trace_file;
+	std::string progress_file;
+
+	std::vector<Metric> metrics;
+	bool share_order;
+
+	/* shared by the CHs of all metrics */
+	std::unique_ptr<std::ofstream> progress;
 
 	template<typename NodeT, typename EdgeT>
 	void operator()(GraphInData<NodeT, CHEdge<EdgeT>>&& data) {
 		tt.track("reading input");
+		if (print_memory) printInputMemory(data);
+
+		buildAndStore(std::move(data));
+		finish();
+	}
+
+	/* one CH per metric from one read */
+	template<typename NodeT>
+	void operator()(GraphInData<NodeT, OSMMetricEdge>&& data) {
+		tt.track("reading input");
+		if (print_memory) printInputMemory(data);
+
+		std::vector<uint> order;
+		for (auto metric: metrics) {
+			std::string const title("metric " + to_string(metric));
+			auto scope(tt.scope(title.c_str()));
+			Print("\nBuilding the CH for metric " << to_string(metric) << ".");
+			auto levels(buildAndStore(selectMetric<NodeT>(data, metric), metricSuffix(metric),
+					share_order && !order.empty() ? &order : nullptr));
+			if (order.empty()) order = std::move(levels);
+		}
+		finish();
+	}
 
-		/* Read graph */
+	template<typename NodeT, typename EdgeT>
+	void printInputMemory(GraphInData<NodeT, EdgeT> const& data) {
+		MemoryUsage usage;
+		usage.add("nodes", memoryUsage(data.nodes));
+		usage.add("edges", memoryUsage(data.edges));
+		printMemory("reading input", usage);
+	}
+
+	std::ostream* progressStream() {
+		if (progress_file == "-") return &std::cout;
+		if (progress_file.empty()) return nullptr;
+		if (!progress) {
+			progress.reset(new std::ofstream(progress_file));
+			if (!progress->is_open()) {
+				std::cerr << "FATAL_ERROR: Couldn't open progress file \'" << progress_file << "\'." << std::endl;
+				std::abort();
+			}
+		}
+		return progress.get();
+	}
+
+	/*
+	 * Contracts the graph (in the order of the levels of order if given) and
+	 * writes it to outfile + file_suffix; returns the node levels.
+	 */
+	template<typename NodeT, typename EdgeT>
+	std::vector<uint> buildAndStore(GraphInData<NodeT, CHEdge<EdgeT>>&& data, std::string const& file_suffix = "",
+			std::vector<uint> const* order = nullptr) {
+		/* Build the CSR: the parsers of the text formats sorted the edges
+		 * while reading (readGraphDataParallel), so only the in edges and
+		 * the offsets are left */
 		CHGraph<NodeT, EdgeT> g;
 		g.init(std::move(data));
 		tt.track("loading graph");
+		if (print_memory) printMemory("loading graph", g.memoryUsage());
 
 		/* Build CH */
-		CHConstructor<NodeT, EdgeT> chc(g, nr_of_threads);
-		std::vector<NodeID> all_nodes(g.getNrOfNodes());
-		for (NodeID i(0); i<all_nodes.size(); i++) {
-			all_nodes[i] = i;
-		}
+		{
+			auto scope(tt.scope("contracting graph"));
+			CHConstructor<NodeT, EdgeT> chc(g, nr_of_threads);
+			chc.setTrackTime(&tt);
+			chc.setProgressStream(progressStream());
+			std::unique_ptr<Tracer> tracer;
+			if (!trace_file.empty()) {
+				tracer.reset(new Tracer(nr_of_threads));
+				chc.setTracer(tracer.get());
+			}
+			if (order) {
+				LevelPrioritizer<CHGraph<NodeT, EdgeT>, CHConstructor<NodeT, EdgeT>> prioritizer(g, chc, *order);
+				auto all_nodes(allNodes(g));
+				chc.contract(all_nodes, prioritizer);
+			}
+			else {
+				contractAll(chc, g, prioritizer_type);
+			}
 
-		if (prioritizer_type == PrioritizerType::NONE) {
-			chc.quickContract(all_nodes, 4, 5);
-			chc.contract(all_nodes);
-		}
-		else {
-			auto prioritizer(createPrioritizer(prioritizer_type, g, chc));
-			chc.contract(all_nodes, *prioritizer);
+#ifdef CHC_STATS
+			if (print_stats) printStats(chc);
+#endif
+			if (tracer) writeTrace(*tracer, trace_file + file_suffix);
+			if (print_memory) {
+				printRoundMemory(chc);
+				MemoryUsage usage;
+				usage.add("graph", g.memoryUsage());
+				usage.add("constructor", chc.memoryUsage());
+				printMemory("contracting graph", usage);
+			}
 		}
 
-		tt.track("contracting graph");
-
-		auto exportData = g.exportData();
-		tt.track("rebuliding graph");
-
-		/* Export */
-		writeCHGraphFile(outformat, outfile, std::move(exportData));
+		/* Export: a second thread sorts and renumbers the edges while the
+		 * header and the nodes, which exportData doesn't change, are written */
+		auto const export_data(g.getExportData());
+		EdgeID const nr_of_edges(g.getNrOfExportEdges());
+		std::promise<void> edges_exported;
+		std::shared_future<void> edges_ready(edges_exported.get_future());
+		std::thread exporter([&g, &edges_exported] {
+			g.exportData();
+			edges_exported.set_value();
+		});
+		writeCHGraphFile(outformat, outfile + file_suffix, export_data, nr_of_edges,
+				[&edges_ready] { edges_ready.wait(); });
+		exporter.join();
 		tt.track("exporting graph", false);
+		if (print_memory) printMemory("exporting graph", g.memoryUsage());
 
+		return export_data.node_levels;
+	}
+
+	void finish() {
 		tt.summary();
+
+		if (timings_file == "-") {
+			tt.writeJson(std::cout);
+		}
+		else if (!timings_file.empty()) {
+			std::ofstream os(timings_file);
+			if (!os.is_open()) {
+				std::cerr << "FATAL_ERROR: Couldn't open timings file \'" << timings_file << "\'." << std::endl;
+				std::abort();
+			}
+			tt.writeJson(os);
+		}
 	}
 };
 
@@ -83,6 +307,15 @@ int main(int argc, char* argv[])
 	FileFormat outformat(FileFormat::FMI_CH);
 	uint nr_of_threads(1);
 	PrioritizerType prioritizer_type(PrioritizerType::NONE);
+	std::string cache_dir("");
+	std::string timings_file("");
+	bool print_stats(false);
+	bool perf_counters(false);
+	bool print_memory(false);
+	std::string trace_file("");
+	std::string progress_file("");
+	std::vector<Metric> metrics;
+	bool share_order(false);
 
 	/*
 	 * Getopt argument parsing.
@@ -96,6 +329,15 @@ int main(int argc, char* argv[])
 		{"outformat",   required_argument,  0, 'g'},
 		{"threads",	required_argument,  0, 't'},
 		{"prioritizer",	required_argument,  0, 'p'},
+		{"cache-input",	required_argument,  0, 'c'},
+		{"stats",	no_argument,        0, 's'},
+		{"memory",	no_argument,        0, 'm'},
+		{"timings",	required_argument,  0, 'T'},
+		{"progress",	required_argument,  0, 'j'},
+		{"trace",	required_argument,  0, 'r'},
+		{"perf-counters",	no_argument,        0, 'P'},
+		{"metrics",	required_argument,  0, 'M'},
+		{"share-order",	no_argument,        0, 'O'},
 		{0,0,0,0},
 	};
 
@@ -103,7 +345,7 @@ int main(int argc, char* argv[])
 	int iarg(0);
 	opterr = 1;
 
-	while((iarg = getopt_long(argc, argv, "hi:f:o:g:t:p:", longopts, &index)) != -1) {
+	while((iarg = getopt_long(argc, argv, "hi:f:o:g:t:p:c:smT:j:r:PM:O", longopts, &index)) != -1) {
 		switch (iarg) {
 			case 'h':
 				printHelp();
@@ -122,18 +364,42 @@ int main(int argc, char* argv[])
 				outformat = toFileFormat(optarg);
 				break;
 			case 't':
-				{
-					size_t idx = 0; // index of first "non digit"
-					nr_of_threads = std::stoi(optarg, &idx);
-					if ('\0' != optarg[idx] || nr_of_threads <= 0) {
-						std::cerr << "Invalid thread count: '" << optarg << "'\n";
-						return 1;
-					}
-				}
+				nr_of_threads = parseThreads(optarg);
 				break;
 			case 'p':
 				prioritizer_type = toPrioritizerType(optarg);
 				break;
+			case 'c':
+				cache_dir = optarg;
+				break;
+			case 's':
+#ifndef CHC_STATS
+				std::cerr << "--stats needs a build with statistics (cmake -DCHC_STATS=ON).\n";
+				return 1;
+#endif
+				print_stats = true;
+				break;
+			case 'm':
+				print_memory = true;
+				break;
+			case 'T':
+				timings_file = optarg;
+				break;
+			case 'j':
+				progress_file = optarg;
+				break;
+			case 'r':
+				trace_file = optarg;
+				break;
+			case 'P':
+				perf_counters = true;
+				break;
+			case 'M':
+				metrics = toMetrics(optarg);
+				break;
+			case 'O':
+				share_order = true;
+				break;
 			default:
 				printHelp();
 				return 1;
@@ -148,9 +414,33 @@ int main(int argc, char* argv[])
 	}
 
 	Print("Using " << nr_of_threads << " threads.");
+	/* also for reading, sorting and writing the graph */
+	omp_set_num_threads(nr_of_threads);
+
+	/* before any threads are started, so they inherit the counters */
+	std::unique_ptr<PerfCounters> perf;
+	TrackTime tt(VerboseTrackTime());
+	if (perf_counters) {
+		perf.reset(new PerfCounters());
+		if (perf->empty()) {
+			std::cerr << "WARNING: Couldn't open any hardware performance counters.\n";
+		}
+		tt.attach(perf.get());
+	}
 
-	readGraphForWriteFormat(outformat, informat, infile,
-		BuildAndStoreCHGraph { outformat, outfile, nr_of_threads, VerboseTrackTime(), prioritizer_type });
+	BuildAndStoreCHGraph build { outformat, outfile, nr_of_threads, tt, prioritizer_type, timings_file, print_stats,
+		print_memory, trace_file, progress_file, metrics, share_order, nullptr };
+	if (metrics.empty()) {
+		readGraphForWriteFormat(outformat, informat, infile, build, cache_dir);
+	}
+	else {
+		/* the other formats only keep one metric as edge distance */
+		if (informat != FileFormat::FMI_DIST) {
+			std::cerr << "--metrics needs the input format FMI_DIST.\n";
+			return 1;
+		}
+		build(calcMetrics(readGraph<OSMNode, OSMEdge>(informat, infile, cache_dir)));
+	}
 
 	return 0;
 }
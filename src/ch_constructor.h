@@ -5,6 +5,8 @@
 #include "graph.h"
 #include "chgraph.h"
 #include "prioritizer.h"
+#include "track_time.h"
+#include "trace.h"
 
 #include <chrono>
 #include <queue>
@@ -24,8 +26,32 @@ namespace unit_tests
 namespace
 {
 	uint MAX_UINT(std::numeric_limits<uint>::max());
+	/* nodes per traced event of the contraction loops */
+	size_t const TRACE_BATCH_SIZE(64);
 }
 
+/* work of the contraction (only counted if compiled with CHC_STATS) */
+struct ContractionCounters
+{
+	size_t searches = 0; /* witness searches */
+	size_t settled_nodes = 0;
+	size_t pushes = 0; /* into the priority queue */
+	size_t contracted_nodes = 0;
+	size_t shortcuts = 0;
+	double time = 0; /* seconds spent contracting nodes */
+
+	ContractionCounters& operator+=(ContractionCounters const& other)
+	{
+		searches += other.searches;
+		settled_nodes += other.settled_nodes;
+		pushes += other.pushes;
+		contracted_nodes += other.contracted_nodes;
+		shortcuts += other.shortcuts;
+		time += other.time;
+		return *this;
+	}
+};
+
 template <typename NodeT, typename EdgeT>
 class CHConstructor{
 	private:
@@ -35,8 +61,13 @@ class CHConstructor{
 
 		struct CompInOutProduct;
 		struct PQElement;
-		typedef std::priority_queue<
-				PQElement, std::vector<PQElement>, std::greater<PQElement> > PQ;
+		/* keeps its heap when cleared, so the searches of a thread reuse it */
+		struct PQ : std::priority_queue<
+				PQElement, std::vector<PQElement>, std::greater<PQElement> >
+		{
+			void clear() { this->c.clear(); }
+			size_t memoryUsage() const { return chc::memoryUsage(this->c); }
+		};
 
 		CHGraphT& _base_graph;
 
@@ -44,6 +75,11 @@ class CHConstructor{
 			PQ pq;
 			std::vector<uint> dists;
 			std::vector<uint> reset_dists;
+#ifdef CHC_STATS
+			ContractionCounters counters; /* of the current round */
+			/* keeps the counters of the threads on different cache lines */
+			char padding[64];
+#endif
 		};
 		std::vector<ThreadData> _thread_data;
 
@@ -70,9 +106,58 @@ class CHConstructor{
 
 		void _markNeighbours(NodeID node, std::vector<bool>& marked) const;
 
+		/* seconds since t; resets t to now */
+		static double _lap(std::chrono::steady_clock::time_point& t);
+
 		void _chooseRemoveNodes(std::vector<NodeID> const& independent_set);
 		void _chooseAllForRemove(std::vector<NodeID> const& independent_set);
 		void _removeNodes(std::vector<NodeID>& nodes);
+	public:
+		/* what happened in one round of quickContract / contract (times in seconds) */
+		struct RoundStats
+		{
+			bool quick = false;
+			size_t nr_of_nodes = 0; /* remaining nodes at the start of the round */
+			size_t nr_of_candidates = 0; /* independent set / nodes from the prioritizer */
+			size_t nr_of_shortcuts = 0; /* (possible) new shortcuts */
+			size_t nr_of_removed = 0;
+			double independent_set_time = 0; /* choosing the nodes to contract */
+			double contraction_time = 0; /* calculating the shortcuts (witness searches) */
+			double restructure_time = 0;
+			double time = 0;
+#ifdef CHC_STATS
+			std::vector<ContractionCounters> threads;
+#endif
+			/* at the end of the round, in bytes */
+			size_t graph_memory = 0;
+			size_t constructor_memory = 0;
+			size_t peak_rss = 0;
+		};
+#ifdef CHC_STATS
+		/* counters of all rounds */
+		struct Stats
+		{
+			std::vector<ContractionCounters> threads;
+
+			ContractionCounters total() const
+			{
+				ContractionCounters sum;
+				for (auto const& counters: threads) sum += counters;
+				return sum;
+			}
+		};
+#endif
+	private:
+		std::vector<RoundStats> _round_stats;
+		TrackTime* _tt = nullptr;
+		Tracer* _tracer = nullptr;
+		std::ostream* _progress = nullptr;
+		double _seconds_per_node = 0; /* smoothed over the rounds, for the ETA */
+
+		/* moves the counters of the threads into stats (with CHC_STATS),
+		 * records the memory */
+		void _finishRound(RoundStats& stats);
+		void _reportProgress(RoundStats const& stats);
 	public:
 		CHConstructor(CHGraphT& base_graph, uint num_threads = 1);
 
@@ -83,6 +168,27 @@ class CHConstructor{
 		void contract(std::vector<NodeID>& nodes, Prioritizer& prioritizer);
 		void rebuildCompleteGraph();
 
+		/* one entry per round of all quickContract / contract calls */
+		std::vector<RoundStats> const& getRoundStats() const { return _round_stats; }
+#ifdef CHC_STATS
+		/* the counters of all rounds per thread */
+		Stats getStats() const;
+#endif
+
+		/* per-thread search state and shortcut buffers (without the graph) */
+		MemoryUsage memoryUsage() const;
+
+		/* times the contraction in scopes "quick_contract"/"contract" -> "round"
+		 * -> step below the open scope of tt (nullptr: don't) */
+		void setTrackTime(TrackTime* tt) { _tt = tt; }
+		/* records the rounds, their steps and batches of contracted nodes
+		 * per thread into tracer (nullptr: don't) */
+		void setTracer(Tracer* tracer) { _tracer = tracer; }
+		/* writes one JSON line per round to os (nullptr: don't), e.g.
+		 * {"round": 7, "quick": false, "remaining_nodes": 1234, ..., "eta": 2.5};
+		 * see _reportProgress for all fields */
+		void setProgressStream(std::ostream* os) { _progress = os; }
+
 		/* const functions that use algorithms from the CHConstructor */
 		std::vector<NodeID> calcIndependentSet(std::vector<NodeID> const& nodes,
 				uint max_degree = MAX_UINT) const;
@@ -155,7 +261,11 @@ template <typename NodeT, typename EdgeT>
 void CHConstructor<NodeT, EdgeT>::_contract(NodeID node)
 {
 	ThreadData& td(_myThreadData());
+	Count(auto start = std::chrono::steady_clock::now());
 	auto shortcuts(_contract(node, td));
+	Count(td.counters.time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	Count(td.counters.contracted_nodes++);
+	Count(td.counters.shortcuts += shortcuts.size());
 
 	_edge_diffs[node] = int(shortcuts.size()) - int(_base_graph.getNrOfEdges(node));
 
@@ -188,7 +298,12 @@ auto CHConstructor<NodeT, EdgeT>::_contract(NodeID node, ThreadData& td) const -
 template <typename NodeT, typename EdgeT>
 void CHConstructor<NodeT, EdgeT>::_quickContract(NodeID node)
 {
+	Count(ThreadData& td(_myThreadData()));
+	Count(auto start = std::chrono::steady_clock::now());
 	auto shortcuts(getShortcutsOfQuickContracting(node));
+	Count(td.counters.time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	Count(td.counters.contracted_nodes++);
+	Count(td.counters.shortcuts += shortcuts.size());
 
 	std::unique_lock<std::mutex> lock(_new_shortcuts_mutex);
 	_new_shortcuts.insert(_new_shortcuts.end(), shortcuts.begin(), shortcuts.end());
@@ -244,14 +359,17 @@ void CHConstructor<NodeT, EdgeT>::_calcShortestDists(ThreadData& td, NodeID star
 	/* calculates all shortest paths within radius distance from start_node */
 
 	/* clear thread data first */
-	td.pq = PQ();
+	td.pq.clear();
 	for (auto node_id: td.reset_dists) {
 		td.dists[node_id] = c::NO_DIST;
 	}
 	td.reset_dists.clear();
 
+	Count(td.counters.searches++);
+
 	/* now initialize with start node */
 	td.pq.push(PQElement(start_node, 0));
+	Count(td.counters.pushes++);
 	td.dists[start_node] = 0;
 	td.reset_dists.push_back(start_node);
 
@@ -259,6 +377,7 @@ void CHConstructor<NodeT, EdgeT>::_calcShortestDists(ThreadData& td, NodeID star
 		auto top = td.pq.top();
 		td.pq.pop();
 		if (td.dists[top.node] != top.distance()) continue;
+		Count(td.counters.settled_nodes++);
 
 		for (auto const& edge: _base_graph.nodeEdges(top.node, direction)) {
 			NodeID tgt_node(otherNode(edge, direction));
@@ -270,6 +389,7 @@ void CHConstructor<NodeT, EdgeT>::_calcShortestDists(ThreadData& td, NodeID star
 				}
 				td.dists[tgt_node] = new_dist;
 				td.pq.push(PQElement(tgt_node, new_dist));
+				Count(td.counters.pushes++);
 			}
 		}
 	}
@@ -304,6 +424,62 @@ void CHConstructor<NodeT, EdgeT>::_markNeighbours(NodeID node, std::vector<bool>
 	}
 }
 
+template <typename NodeT, typename EdgeT>
+void CHConstructor<NodeT, EdgeT>::_finishRound(RoundStats& stats)
+{
+#ifdef CHC_STATS
+	for (auto& td: _thread_data) {
+		stats.threads.push_back(td.counters);
+		td.counters = ContractionCounters();
+	}
+#endif
+	stats.graph_memory = _base_graph.memoryUsage().total();
+	stats.constructor_memory = memoryUsage().total();
+	stats.peak_rss = peakRSS();
+	Print("Memory: graph " << MemoryUsage::formatBytes(stats.graph_memory)
+			<< ", constructor " << MemoryUsage::formatBytes(stats.constructor_memory)
+			<< ", peak RSS " << MemoryUsage::formatBytes(stats.peak_rss));
+	_reportProgress(stats);
+}
+
+template <typename NodeT, typename EdgeT>
+void CHConstructor<NodeT, EdgeT>::_reportProgress(RoundStats const& stats)
+{
+	if (stats.nr_of_removed) {
+		/* later rounds contract fewer nodes with more edges, so weight the
+		 * recent rounds more */
+		double seconds_per_node(stats.time / stats.nr_of_removed);
+		_seconds_per_node = _round_stats.empty() ? seconds_per_node : (_seconds_per_node + seconds_per_node) / 2;
+	}
+	if (!_progress) return;
+
+	double elapsed(stats.time);
+	for (auto const& round: _round_stats) elapsed += round.time;
+	size_t const remaining_nodes(stats.nr_of_nodes - stats.nr_of_removed);
+
+	(*_progress) << "{\"round\": " << _round_stats.size() + 1
+		<< ", \"quick\": " << (stats.quick ? "true" : "false")
+		<< ", \"remaining_nodes\": " << remaining_nodes
+		<< ", \"contracted_nodes\": " << stats.nr_of_removed
+		<< ", \"active_edges\": " << _base_graph.getNrOfEdges()
+		<< ", \"shortcuts\": " << stats.nr_of_shortcuts
+		<< ", \"round_time\": " << stats.time
+		<< ", \"elapsed\": " << elapsed
+		<< ", \"eta\": " << remaining_nodes * _seconds_per_node
+		<< ", \"peak_rss\": " << stats.peak_rss << "}" << std::endl;
+}
+
+template <typename NodeT, typename EdgeT>
+double CHConstructor<NodeT, EdgeT>::_lap(std::chrono::steady_clock::time_point& t)
+{
+	using namespace std::chrono;
+
+	steady_clock::time_point now = steady_clock::now();
+	double seconds(duration_cast<duration<double>>(now - t).count());
+	t = now;
+	return seconds;
+}
+
 template <typename NodeT, typename EdgeT>
 void CHConstructor<NodeT, EdgeT>::_chooseRemoveNodes(std::vector<NodeID> const& independent_set)
 {
@@ -385,9 +561,19 @@ void CHConstructor<NodeT, EdgeT>::quickContract(std::vector<NodeID>& nodes, uint
 	using namespace std::chrono;
 
 	Print("\nStarting the quick_contraction of nodes with degree smaller than " << max_degree << ".\n");
+	auto phase(TrackTime::scope(_tt, "quick_contract"));
+	Tracer::Span trace_phase(_tracer, "quick_contract");
 
 	for (uint round(1); round <= max_rounds; ++round) {
 		steady_clock::time_point t1 = steady_clock::now();
+		steady_clock::time_point t2 = t1;
+		RoundStats stats;
+		auto round_scope(TrackTime::scope(_tt, "round"));
+		auto step(TrackTime::scope(_tt, "independent_set"));
+		Tracer::Span trace_round(_tracer, "round");
+		Tracer::Span trace_step(_tracer, "independent_set");
+		stats.quick = true;
+		stats.nr_of_nodes = nodes.size();
 		Print("Starting round " << round);
 		Debug("Initializing the vectors for a new round.");
 		_initVectors();
@@ -398,32 +584,50 @@ void CHConstructor<NodeT, EdgeT>::quickContract(std::vector<NodeID>& nodes, uint
 		Debug("Constructing the independent set.");
 		auto independent_set = calcIndependentSet(nodes, max_degree);
 		Print("The independent set has size " << independent_set.size() << ".");
+		stats.nr_of_candidates = independent_set.size();
+		stats.independent_set_time = _lap(t2);
 
 		if (independent_set.empty()) break;
+		step.next("contraction");
+		trace_step.next("contraction");
 
 		Debug("Quick-contracting all the nodes in the independent set.");
 		uint size(independent_set.size());
-		#pragma omp parallel for num_threads(_num_threads) schedule(dynamic)
-		for (uint i = 0; i < size; i++) {
-			uint node(independent_set[i]);
-			_quickContract(node);
+		#pragma omp parallel num_threads(_num_threads)
+		{
+			Tracer::Batches batches(_tracer, "contract_nodes", TRACE_BATCH_SIZE);
+			#pragma omp for schedule(dynamic) nowait
+			for (uint i = 0; i < size; i++) {
+				uint node(independent_set[i]);
+				_quickContract(node);
+				batches.tick();
+			}
 		}
 		Print("Number of possible new Shortcuts: " << _new_shortcuts.size());
+		stats.nr_of_shortcuts = _new_shortcuts.size();
+		stats.contraction_time = _lap(t2);
+		step.next("restructure");
+		trace_step.next("restructure");
 
 		Debug("Remove the nodes with low edge difference.");
 		_chooseAllForRemove(independent_set);
 		_removeNodes(nodes);
 		Print("Removed " << _remove.size() << " nodes with low edge difference.");
+		stats.nr_of_removed = _remove.size();
 
 		Debug("Restructuring the graph.");
 		_base_graph.restructure(_remove, _to_remove, _new_shortcuts);
+		stats.restructure_time = _lap(t2);
+		step.close();
+		trace_step.close();
 
 		Print("Graph info:");
 		_base_graph.printInfo(nodes);
 
-		duration<double> time_span = duration_cast<duration<double>>(steady_clock::now() - t1);
-		Print("Round took " << time_span.count() << " seconds.\n");
-		Unused(time_span);
+		stats.time = _lap(t1);
+		_finishRound(stats);
+		_round_stats.push_back(stats);
+		Print("Round took " << stats.time << " seconds.\n");
 	}
 }
 
@@ -433,9 +637,18 @@ void CHConstructor<NodeT, EdgeT>::contract(std::vector<NodeID>& nodes)
 	using namespace std::chrono;
 
 	Print("\nStarting the contraction of " << nodes.size() << " nodes.\n");
+	auto phase(TrackTime::scope(_tt, "contract"));
+	Tracer::Span trace_phase(_tracer, "contract");
 
 	for (uint round(1); !nodes.empty(); ++round) {
 		steady_clock::time_point t1 = steady_clock::now();
+		steady_clock::time_point t2 = t1;
+		RoundStats stats;
+		auto round_scope(TrackTime::scope(_tt, "round"));
+		auto step(TrackTime::scope(_tt, "independent_set"));
+		Tracer::Span trace_round(_tracer, "round");
+		Tracer::Span trace_step(_tracer, "independent_set");
+		stats.nr_of_nodes = nodes.size();
 		Print("Starting round " << round);
 		Debug("Initializing the vectors for a new round.");
 		_initVectors();
@@ -446,30 +659,48 @@ void CHConstructor<NodeT, EdgeT>::contract(std::vector<NodeID>& nodes)
 		Debug("Constructing the independent set.");
 		auto independent_set = calcIndependentSet(nodes);
 		Print("The independent set has size " << independent_set.size() << ".");
+		stats.nr_of_candidates = independent_set.size();
+		stats.independent_set_time = _lap(t2);
+		step.next("contraction");
+		trace_step.next("contraction");
 
 		Debug("Contracting all the nodes in the independent set.");
 		uint size(independent_set.size());
-		#pragma omp parallel for num_threads(_num_threads) schedule(dynamic)
-		for (uint i = 0; i < size; i++) {
-			uint node(independent_set[i]);
-			_contract(node);
+		#pragma omp parallel num_threads(_num_threads)
+		{
+			Tracer::Batches batches(_tracer, "contract_nodes", TRACE_BATCH_SIZE);
+			#pragma omp for schedule(dynamic) nowait
+			for (uint i = 0; i < size; i++) {
+				uint node(independent_set[i]);
+				_contract(node);
+				batches.tick();
+			}
 		}
 		Print("Number of possible new Shortcuts: " << _new_shortcuts.size());
+		stats.nr_of_shortcuts = _new_shortcuts.size();
+		stats.contraction_time = _lap(t2);
+		step.next("restructure");
+		trace_step.next("restructure");
 
 		Debug("Remove the nodes with low edge difference.");
 		_chooseRemoveNodes(independent_set);
 		_removeNodes(nodes);
 		Print("Removed " << _remove.size() << " nodes with low edge difference.");
+		stats.nr_of_removed = _remove.size();
 
 		Debug("Restructuring the graph.");
 		_base_graph.restructure(_remove, _to_remove, _new_shortcuts);
+		stats.restructure_time = _lap(t2);
+		step.close();
+		trace_step.close();
 
 		Print("Graph info:");
 		_base_graph.printInfo(nodes);
 
-		duration<double> time_span = duration_cast<duration<double>>(steady_clock::now() - t1);
-		Print("Round took " << time_span.count() << " seconds.\n");
-		Unused(time_span);
+		stats.time = _lap(t1);
+		_finishRound(stats);
+		_round_stats.push_back(stats);
+		Print("Round took " << stats.time << " seconds.\n");
 	}
 }
 
@@ -479,12 +710,22 @@ void CHConstructor<NodeT, EdgeT>::contract(std::vector<NodeID>& nodes, Prioritiz
 	using namespace std::chrono;
 
 	Print("\nStarting the contraction of " << nodes.size() << " nodes.\n");
+	auto phase(TrackTime::scope(_tt, "contract"));
+	Tracer::Span trace_phase(_tracer, "contract");
 
 	prioritizer.init(nodes);
 
 	uint round(1);
+	size_t remaining_nodes(nodes.size());
 	while (prioritizer.hasNodesLeft()) {
 		steady_clock::time_point t1 = steady_clock::now();
+		steady_clock::time_point t2 = t1;
+		RoundStats stats;
+		auto round_scope(TrackTime::scope(_tt, "round"));
+		auto step(TrackTime::scope(_tt, "independent_set"));
+		Tracer::Span trace_round(_tracer, "round");
+		Tracer::Span trace_step(_tracer, "independent_set");
+		stats.nr_of_nodes = remaining_nodes;
 		Print("Starting round " << round);
 		Debug("Initializing the vectors for a new round.");
 		_initVectors();
@@ -492,29 +733,48 @@ void CHConstructor<NodeT, EdgeT>::contract(std::vector<NodeID>& nodes, Prioritiz
 		Debug("Calculating list of nodes to be contracted next.");
 		auto next_nodes(prioritizer.extractNextNodes());
 		Print("There are " << next_nodes.size() << " nodes to be contracted in this round.");
+		stats.nr_of_candidates = next_nodes.size();
+		stats.independent_set_time = _lap(t2);
+		step.next("contraction");
+		trace_step.next("contraction");
 
 		Debug("Contracting all the nodes in the independent set.");
 		uint size(next_nodes.size());
-		#pragma omp parallel for num_threads(_num_threads) schedule(dynamic)
-		for (uint i = 0; i < size; i++) {
-			uint node(next_nodes[i]);
-			_contract(node);
+		#pragma omp parallel num_threads(_num_threads)
+		{
+			Tracer::Batches batches(_tracer, "contract_nodes", TRACE_BATCH_SIZE);
+			#pragma omp for schedule(dynamic) nowait
+			for (uint i = 0; i < size; i++) {
+				uint node(next_nodes[i]);
+				_contract(node);
+				batches.tick();
+			}
 		}
 		Print("Number of new Shortcuts: " << _new_shortcuts.size());
+		stats.nr_of_shortcuts = _new_shortcuts.size();
+		stats.contraction_time = _lap(t2);
+		step.next("restructure");
+		trace_step.next("restructure");
 
 		Debug("Mark nodes for removal from graph.");
 		_chooseAllForRemove(next_nodes);
 		Print("Marked " << _remove.size() << " nodes.");
+		stats.nr_of_removed = _remove.size();
+		remaining_nodes -= _remove.size();
 
 		Debug("Restructuring the graph.");
 		_base_graph.restructure(_remove, _to_remove, _new_shortcuts);
+		stats.restructure_time = _lap(t2);
+		step.close();
+		trace_step.close();
 
 		Print("Graph info:");
 		_base_graph.printInfo();
 
-		duration<double> time_span = duration_cast<duration<double>>(steady_clock::now() - t1);
-		Print("Round took " << time_span.count() << " seconds.\n");
-		Unused(time_span);
+		stats.time = _lap(t1);
+		_finishRound(stats);
+		_round_stats.push_back(stats);
+		Print("Round took " << stats.time << " seconds.\n");
 
 		round++;
 	}
@@ -528,6 +788,39 @@ void CHConstructor<NodeT, EdgeT>::rebuildCompleteGraph()
 	_base_graph.rebuildCompleteGraph();
 }
 
+template <typename NodeT, typename EdgeT>
+MemoryUsage CHConstructor<NodeT, EdgeT>::memoryUsage() const
+{
+	size_t thread_data(0);
+	for (auto const& td: _thread_data) {
+		/* the queue is only cleared, so this is its largest size so far */
+		thread_data += sizeof(ThreadData) + td.pq.memoryUsage()
+			+ chc::memoryUsage(td.dists) + chc::memoryUsage(td.reset_dists);
+	}
+
+	MemoryUsage usage;
+	usage.add("thread_data", thread_data);
+	usage.add("new_shortcuts", chc::memoryUsage(_new_shortcuts));
+	usage.add("edge_diffs", chc::memoryUsage(_edge_diffs));
+	usage.add("remove", chc::memoryUsage(_remove) + chc::memoryUsage(_to_remove));
+	return usage;
+}
+
+#ifdef CHC_STATS
+template <typename NodeT, typename EdgeT>
+auto CHConstructor<NodeT, EdgeT>::getStats() const -> Stats
+{
+	Stats stats;
+	stats.threads.resize(_num_threads);
+	for (auto const& round: _round_stats) {
+		for (size_t i(0); i < round.threads.size(); i++) {
+			stats.threads[i] += round.threads[i];
+		}
+	}
+	return stats;
+}
+#endif
+
 template <typename NodeT, typename EdgeT>
 std::vector<NodeID> CHConstructor<NodeT, EdgeT>::calcIndependentSet(std::vector<NodeID> const& nodes,
 		uint max_degree) const
@@ -0,0 +1,129 @@
+#include "defs.h"
+#include "tool_helpers.h"
+#include "file_formats.h"
+#include "graph_generator.h"
+
+#include <getopt.h>
+#include <cmath>
+
+using namespace chc;
+
+void printHelp()
+{
+	std::cout
+		<< "Usage: ./ch_graphgen [ARGUMENTS]\n"
+		<< "Generates a synthetic road-like graph (see graph_generator.h).\n"
+		<< "Mandatory arguments are:\n"
+		<< "  -o, --outfile <path>       Write graph to <path>\n"
+		<< "Optional arguments are:\n"
+		<< "  -g, --outformat <format>   Writes outfile in <format> (STD, FMI - default FMI)\n"
+		<< "  -k, --kind <kind>          grid or geometric (random points connected to their nearest neighbours; default: grid)\n"
+		<< "  -n, --nodes <number>       Number of nodes; grids are made square (default: 10000)\n"
+		<< "  -l, --highways <levels>    Add <levels> levels of highways on top (default: 0)\n"
+		<< "  -d, --hub-spacing <meters> Distance of the level 1 highway hubs (default: 2000)\n"
+		<< "  -s, --seed <number>        Seed of the random numbers (default: 0)\n"
+		<< "Note: the graph is built in memory (about 60 bytes per node and edge) and\n"
+		<< "written with all threads (OMP_NUM_THREADS).\n";
+}
+
+int main(int argc, char* argv[])
+{
+	std::string outfile;
+	FileFormat outformat(FileFormat::FMI);
+	std::string kind("grid");
+	uint nr_of_nodes(10000);
+	uint nr_of_levels(0);
+	double hub_spacing(2000);
+	uint seed(0);
+
+	const struct option longopts[] = {
+		{"help",	no_argument,        0, 'h'},
+		{"outfile",	required_argument,  0, 'o'},
+		{"outformat",	required_argument,  0, 'g'},
+		{"kind",	required_argument,  0, 'k'},
+		{"nodes",	required_argument,  0, 'n'},
+		{"highways",	required_argument,  0, 'l'},
+		{"hub-spacing",	required_argument,  0, 'd'},
+		{"seed",	required_argument,  0, 's'},
+		{0,0,0,0},
+	};
+
+	int index(0);
+	int iarg(0);
+	opterr = 1;
+
+	while((iarg = getopt_long(argc, argv, "ho:g:k:n:l:d:s:", longopts, &index)) != -1) {
+		switch (iarg) {
+			case 'h':
+				printHelp();
+				return 0;
+				break;
+			case 'o':
+				outfile = optarg;
+				break;
+			case 'g':
+				outformat = toFileFormat(optarg);
+				if (outformat != FileFormat::STD && outformat != FileFormat::FMI) {
+					std::cerr << "Can only write STD or FMI, not " << optarg << "\n";
+					return 1;
+				}
+				break;
+			case 'k':
+				kind = optarg;
+				if (kind != "grid" && kind != "geometric") {
+					std::cerr << "Unknown kind of graph: '" << optarg << "'\n";
+					return 1;
+				}
+				break;
+			case 'n':
+				nr_of_nodes = parseUInt(optarg, "number of nodes");
+				break;
+			case 'l':
+				nr_of_levels = parseUInt(optarg, "number of highway levels");
+				break;
+			case 'd':
+				hub_spacing = parseUInt(optarg, "hub spacing");
+				if (hub_spacing == 0) {
+					std::cerr << "Invalid hub spacing: '" << optarg << "'\n";
+					return 1;
+				}
+				break;
+			case 's':
+				seed = parseUInt(optarg, "seed");
+				break;
+			default:
+				printHelp();
+				return 1;
+				break;
+		}
+	}
+
+	if (outfile.empty()) {
+		printHelp();
+		return 1;
+	}
+
+	GraphInData<OSMNode, OSMEdge> data;
+	std::string description;
+	if (kind == "grid") {
+		uint const width(std::ceil(std::sqrt(double(nr_of_nodes))));
+		uint const height(width ? (nr_of_nodes + width - 1) / width : 0);
+		data = generator::gridGraph(width, height, seed);
+		description = "grid_" + std::to_string(width) + "x" + std::to_string(height);
+	}
+	else {
+		data = generator::randomGeometricGraph(nr_of_nodes, seed);
+		description = "geometric_" + std::to_string(nr_of_nodes);
+	}
+	if (nr_of_levels) {
+		generator::addHighways(data, nr_of_levels, seed, hub_spacing);
+		description += "_highways" + std::to_string(nr_of_levels);
+	}
+	data.meta_data["Generator"] = description + "_seed" + std::to_string(seed);
+
+	std::cout << "Generated " << data.nodes.size() << " nodes and " << data.edges.size() << " edges.\n";
+
+	writeGraphFile(outformat, outfile, GraphOutData<OSMNode, OSMEdge>{data.nodes, data.edges, data.meta_data});
+
+	return 0;
+}
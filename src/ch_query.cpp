@@ -0,0 +1,150 @@
+#include "defs.h"
+#include "tool_helpers.h"
+#include "ch_constructor.h"
+#include "batch_query.h"
+#include "file_formats.h"
+#include "track_time.h"
+
+#include <getopt.h>
+#include <omp.h>
+#include <random>
+
+using namespace chc;
+
+void printHelp()
+{
+	std::cout
+		<< "Usage: ./ch_query [ARGUMENTS]\n"
+		<< "Builds a CH for the input graph and answers a batch of point-to-point\n"
+		<< "queries in parallel, reporting throughput and latencies.\n"
+		<< "Mandatory arguments are:\n"
+		<< "  -i, --infile <path>        Read graph from <path>\n"
+		<< "Optional arguments are:\n"
+		<< "  -f, --informat <format>    Expects infile in <format> (" << getAllFileFormatsString() << " - default FMI_DIST)\n"
+		<< "  -q, --queries <path>       Read queries (one \"src tgt\" pair per line) from <path>\n"
+		<< "  -n, --random <number>      Number of random queries if no query file is given (default: 100000)\n"
+		<< "  -r, --seed <number>        Seed for the random queries (default: 0)\n"
+		<< "  -o, --outfile <path>       Write the distances (one per line, -1 if there is no path) to <path>\n"
+		<< "  -t, --threads <number>     Number of threads to use in the calculations (default: 1)\n";
+}
+
+int main(int argc, char* argv[])
+{
+	std::string infile("");
+	FileFormat informat(FileFormat::FMI_DIST);
+	std::string queryfile("");
+	std::string outfile("");
+	uint nr_of_threads(1);
+	uint nr_of_queries(100000);
+	uint seed(0);
+
+	const struct option longopts[] = {
+		{"help",	no_argument,        0, 'h'},
+		{"infile",	required_argument,  0, 'i'},
+		{"informat",	required_argument,  0, 'f'},
+		{"queries",	required_argument,  0, 'q'},
+		{"random",	required_argument,  0, 'n'},
+		{"seed",	required_argument,  0, 'r'},
+		{"outfile",     required_argument,  0, 'o'},
+		{"threads",	required_argument,  0, 't'},
+		{0,0,0,0},
+	};
+
+	int index(0);
+	int iarg(0);
+	opterr = 1;
+
+	while((iarg = getopt_long(argc, argv, "hi:f:q:n:r:o:t:", longopts, &index)) != -1) {
+		switch (iarg) {
+			case 'h':
+				printHelp();
+				return 0;
+				break;
+			case 'i':
+				infile = optarg;
+				break;
+			case 'f':
+				informat = toFileFormat(optarg);
+				break;
+			case 'q':
+				queryfile = optarg;
+				break;
+			case 'n':
+				nr_of_queries = parseUInt(optarg, "number of queries");
+				break;
+			case 'r':
+				seed = parseUInt(optarg, "seed");
+				break;
+			case 'o':
+				outfile = optarg;
+				break;
+			case 't':
+				nr_of_threads = parseThreads(optarg);
+				break;
+			default:
+				printHelp();
+				return 1;
+				break;
+		}
+	}
+
+	if (infile == "") {
+		std::cerr << "No input file specified! Exiting.\n";
+		std::cerr << "Use ./ch_query --help to print the usage.\n";
+		return 1;
+	}
+	omp_set_num_threads(nr_of_threads);
+
+	TrackTime tt(std::cout);
+
+	CHGraph<OSMNode, OSMEdge> g;
+	g.init(readGraph<OSMNode, CHEdge<OSMEdge>>(informat, infile));
+	tt.track("reading input");
+
+	buildCH(g, nr_of_threads);
+	tt.track("contracting graph");
+
+	std::vector<Query> queries;
+	if (queryfile != "") {
+		queries = readQueries(queryfile);
+		for (auto const& query: queries) {
+			if (query.src >= g.getNrOfNodes() || query.tgt >= g.getNrOfNodes()) {
+				std::cerr << "Invalid query from " << query.src << " to " << query.tgt << "\n";
+				return 1;
+			}
+		}
+	}
+	else {
+		std::mt19937 gen(seed);
+		std::uniform_int_distribution<NodeID> rand_node(0, g.getNrOfNodes() - 1);
+		queries.resize(nr_of_queries);
+		for (auto& query: queries) {
+			query.src = rand_node(gen);
+			query.tgt = rand_node(gen);
+		}
+	}
+	tt.track("preparing " + std::to_string(queries.size()) + " queries");
+
+	CHBatchQuery<OSMNode, OSMEdge> batch(g, nr_of_threads);
+	auto result(batch.run(queries));
+	tt.track("answering queries");
+	std::cout << result << "\n";
+
+	if (outfile != "") {
+		std::ofstream os(outfile);
+		if (!os.is_open()) {
+			std::cerr << "FATAL_ERROR: Couldn't open result file \'" <<
+				outfile << "\'. Exiting." << std::endl;
+			return 1;
+		}
+		for (uint dist: result.dists) {
+			if (c::NO_DIST == dist) os << "-1\n";
+			else os << dist << "\n";
+		}
+		tt.track("writing distances");
+	}
+
+	tt.summary();
+
+	return 0;
+}
@@ -0,0 +1,362 @@
+#include "defs.h"
+#include "tool_helpers.h"
+#include "ch_constructor.h"
+#include "dijkstra.h"
+#include "file_formats.h"
+#include "alt.h"
+
+#include <getopt.h>
+#include <omp.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+using namespace chc;
+
+void printHelp()
+{
+	std::cout
+		<< "Usage: ./ch_query_bench [ARGUMENTS]\n"
+		<< "Builds the CH of a graph and compares Dijkstra, bidirectional Dijkstra, A* (with\n"
+		<< "the great-circle distance as heuristic), ALT (A* with landmarks) and CHDijkstra\n"
+		<< "on random queries\n"
+		<< "and on queries by Dijkstra rank (the target is the 2^r-th node settled by a\n"
+		<< "Dijkstra from the source). Checks that the distances agree and reports latencies,\n"
+		<< "settled nodes and relaxed edges.\n"
+		<< "Mandatory arguments are:\n"
+		<< "  -i, --infile <path>        Read graph from <path>\n"
+		<< "Optional arguments are:\n"
+		<< "  -f, --informat <format>    Expects infile in <format> (STD, SIMPLE, FMI, FMI_DIST, FMI_EUCL - default FMI_DIST)\n"
+		<< "  -p, --prioritizer <type>   Uses prioritizer <type> for the CH construction. (default: NONE)\n"
+		<< "  -t, --threads <number>     Number of threads to use in the CH construction (default: 1)\n"
+		<< "  -n, --random <number>      Number of random queries (default: 1000)\n"
+		<< "  -s, --sources <number>     Number of sources for the rank queries (default: 100)\n"
+		<< "  -r, --seed <number>        Seed for the queries (default: 0)\n"
+		<< "  -j, --json <path>          Also write the results as JSON to <path> ('-' for stdout)\n"
+		<< "  -l, --landmarks <number>   Number of landmarks for ALT (default: 16)\n"
+		<< "  -a, --landmark-selection <type>  FARTHEST or AVOID (default: AVOID)\n"
+		<< "  -L, --landmark-file <path> Reads the landmarks of this graph from <path> if it exists,\n"
+		<< "                             otherwise computes them and writes them to <path>\n"
+		<< "Exits with 1 if a distance of another engine differs from Dijkstra.\n";
+}
+
+/* latencies, settled nodes and relaxed edges of the queries of one engine */
+struct QueryStats
+{
+	std::vector<double> micros;
+	size_t settled_nodes = 0;
+	size_t relaxed_edges = 0;
+
+	void add(double seconds, SearchStats const& stats)
+	{
+		micros.push_back(seconds * 1e6);
+		settled_nodes += stats.settled_nodes;
+		relaxed_edges += stats.relaxed_edges;
+	}
+
+	size_t size() const { return micros.size(); }
+	double avgSettled() const { return micros.empty() ? 0 : double(settled_nodes) / micros.size(); }
+	double avgRelaxed() const { return micros.empty() ? 0 : double(relaxed_edges) / micros.size(); }
+
+	/* q in [0, 1]; the latencies have to be sorted */
+	double quantile(double q) const
+	{
+		if (micros.empty()) return 0;
+		return micros[std::min(micros.size() - 1, size_t(q * micros.size()))];
+	}
+	void sort() { std::sort(micros.begin(), micros.end()); }
+};
+
+/* the compared engines; Dijkstra is the reference for the distances */
+enum Engine { DIJKSTRA, BIDIRECTIONAL, ASTAR, ALT_ASTAR, CH, NR_OF_ENGINES };
+char const* const ENGINE_NAMES[NR_OF_ENGINES] = { "Dijkstra", "BiDijkstra", "A*", "ALT", "CH" };
+char const* const ENGINE_KEYS[NR_OF_ENGINES] = { "dijkstra", "bidirectional", "astar", "alt", "ch" };
+
+struct QueryResults
+{
+	std::array<QueryStats, NR_OF_ENGINES> engines;
+};
+
+template <typename Node, typename Edge>
+class QueryBench
+{
+	private:
+		Dijkstra<Node, Edge> _dijkstra;
+		BidirectionalDijkstra<Node, Edge> _bidirectional;
+		AStar<Node, Edge> _astar;
+		ALT<Node, Edge> _alt;
+		CHDijkstra<Node, Edge> _ch_dijkstra;
+		std::vector<EdgeID> _path;
+		size_t _mismatches = 0;
+
+		template <typename Engine>
+		uint _run(Engine& engine, NodeID src, NodeID tgt, QueryStats& stats)
+		{
+			using namespace std::chrono;
+
+			steady_clock::time_point t1 = steady_clock::now();
+			uint dist(engine.calcShopa(src, tgt, _path));
+			stats.add(duration_cast<duration<double>>(steady_clock::now() - t1).count(), engine.getStats());
+			return dist;
+		}
+	public:
+		QueryBench(Graph<Node, Edge> const& g, CHGraph<Node, Edge> const& ch_g, LandmarkTable const& landmarks)
+			: _dijkstra(g), _bidirectional(g), _astar(g), _alt(g, landmarks), _ch_dijkstra(ch_g) { }
+
+		void query(NodeID src, NodeID tgt, QueryResults& results)
+		{
+			std::array<uint, NR_OF_ENGINES> dists;
+			dists[DIJKSTRA] = _run(_dijkstra, src, tgt, results.engines[DIJKSTRA]);
+			dists[BIDIRECTIONAL] = _run(_bidirectional, src, tgt, results.engines[BIDIRECTIONAL]);
+			dists[ASTAR] = _run(_astar, src, tgt, results.engines[ASTAR]);
+			dists[ALT_ASTAR] = _run(_alt, src, tgt, results.engines[ALT_ASTAR]);
+			dists[CH] = _run(_ch_dijkstra, src, tgt, results.engines[CH]);
+			for (size_t e(1); e < NR_OF_ENGINES; e++) {
+				if (dists[e] != dists[DIJKSTRA]) {
+					std::cerr << "ERROR: distance from " << src << " to " << tgt << " is " << dists[DIJKSTRA]
+						<< " with Dijkstra, but " << dists[e] << " with " << ENGINE_NAMES[e] << "\n";
+					_mismatches++;
+				}
+			}
+		}
+
+		/* targets of the rank queries from src: targets[r] has Dijkstra rank 2^r */
+		std::vector<NodeID> rankTargets(NodeID src)
+		{
+			std::vector<NodeID> targets;
+			size_t rank(0);
+			_dijkstra.run(src, [&](NodeID node, uint) {
+				if (rank++ == (size_t(1) << targets.size())) targets.push_back(node);
+			});
+			return targets;
+		}
+
+		size_t mismatches() const { return _mismatches; }
+};
+
+void printStats(std::string const& name, QueryStats const& stats)
+{
+	std::printf("  %-10s %8zu %10.1f %10.1f %10.1f %10.1f %10.1f %12.1f %12.1f\n", name.c_str(), stats.size(),
+			stats.quantile(0), stats.quantile(0.5), stats.quantile(0.9), stats.quantile(0.99), stats.quantile(1),
+			stats.avgSettled(), stats.avgRelaxed());
+}
+
+void printHeader(std::string const& title)
+{
+	std::cout << "\n" << title << "\n";
+	std::printf("  %-10s %8s %10s %10s %10s %10s %10s %12s %12s\n", "", "queries", "min [us]", "median", "p90", "p99", "max",
+			"settled", "relaxed");
+}
+
+void writeStats(std::ostream& os, QueryStats const& stats)
+{
+	os << "{\"queries\": " << stats.size()
+		<< ", \"latency_us\": {\"min\": " << stats.quantile(0) << ", \"median\": " << stats.quantile(0.5)
+		<< ", \"p90\": " << stats.quantile(0.9) << ", \"p99\": " << stats.quantile(0.99) << ", \"max\": " << stats.quantile(1) << "}"
+		<< ", \"settled_nodes\": " << stats.avgSettled() << ", \"relaxed_edges\": " << stats.avgRelaxed() << "}";
+}
+
+void writeEngines(std::ostream& os, QueryResults const& results)
+{
+	for (size_t e(0); e < NR_OF_ENGINES; e++) {
+		os << (e ? ", " : "") << "\"" << ENGINE_KEYS[e] << "\": ";
+		writeStats(os, results.engines[e]);
+	}
+}
+
+void printEngines(QueryResults const& results)
+{
+	for (size_t e(0); e < NR_OF_ENGINES; e++) {
+		printStats(ENGINE_NAMES[e], results.engines[e]);
+	}
+}
+
+void writeJson(std::ostream& os, std::string const& infile, PrioritizerType prioritizer_type, QueryResults const& random,
+		std::vector<QueryResults> const& ranks, size_t mismatches)
+{
+	os << "{\n  \"graph\": \"" << infile << "\",\n  \"prioritizer\": \"" << to_string(prioritizer_type) << "\",\n"
+		<< "  \"mismatches\": " << mismatches << ",\n  \"random\": {";
+	writeEngines(os, random);
+	os << "},\n  \"ranks\": [";
+	for (size_t r(0); r < ranks.size(); r++) {
+		os << (r ? "," : "") << "\n    {\"rank\": " << r << ", ";
+		writeEngines(os, ranks[r]);
+		os << "}";
+	}
+	os << "\n  ]\n}\n";
+}
+
+int main(int argc, char* argv[])
+{
+	std::string infile("");
+	FileFormat informat(FileFormat::FMI_DIST);
+	PrioritizerType prioritizer_type(PrioritizerType::NONE);
+	uint nr_of_threads(1);
+	uint nr_of_queries(1000);
+	uint nr_of_sources(100);
+	uint seed(0);
+	std::string json_file("");
+	uint nr_of_landmarks(16);
+	LandmarkSelection landmark_selection(LandmarkSelection::AVOID);
+	std::string landmark_file("");
+
+	const struct option longopts[] = {
+		{"help",	no_argument,        0, 'h'},
+		{"infile",	required_argument,  0, 'i'},
+		{"informat",	required_argument,  0, 'f'},
+		{"prioritizer",	required_argument,  0, 'p'},
+		{"threads",	required_argument,  0, 't'},
+		{"random",	required_argument,  0, 'n'},
+		{"sources",	required_argument,  0, 's'},
+		{"seed",	required_argument,  0, 'r'},
+		{"json",	required_argument,  0, 'j'},
+		{"landmarks",	required_argument,  0, 'l'},
+		{"landmark-selection",	required_argument,  0, 'a'},
+		{"landmark-file",	required_argument,  0, 'L'},
+		{0,0,0,0},
+	};
+
+	int index(0);
+	int iarg(0);
+	opterr = 1;
+
+	while((iarg = getopt_long(argc, argv, "hi:f:p:t:n:s:r:j:l:a:L:", longopts, &index)) != -1) {
+		switch (iarg) {
+			case 'h':
+				printHelp();
+				return 0;
+				break;
+			case 'i':
+				infile = optarg;
+				break;
+			case 'f':
+				informat = toFileFormat(optarg);
+				break;
+			case 'p':
+				prioritizer_type = toPrioritizerType(optarg);
+				break;
+			case 't':
+				nr_of_threads = parseThreads(optarg);
+				break;
+			case 'n':
+				nr_of_queries = parseUInt(optarg, "number of queries");
+				break;
+			case 's':
+				nr_of_sources = parseUInt(optarg, "number of sources");
+				break;
+			case 'r':
+				seed = parseUInt(optarg, "seed");
+				break;
+			case 'j':
+				json_file = optarg;
+				break;
+			case 'l':
+				nr_of_landmarks = parseUInt(optarg, "number of landmarks");
+				break;
+			case 'a':
+				landmark_selection = toLandmarkSelection(optarg);
+				break;
+			case 'L':
+				landmark_file = optarg;
+				break;
+			default:
+				printHelp();
+				return 1;
+				break;
+		}
+	}
+
+	if (infile == "") {
+		std::cerr << "No input file specified! Exiting.\n";
+		std::cerr << "Use ./ch_query_bench --help to print the usage.\n";
+		return 1;
+	}
+	omp_set_num_threads(nr_of_threads);
+
+	auto data(readGraph<OSMNode, CHEdge<OSMEdge>>(informat, infile));
+	Graph<OSMNode, OSMEdge> g;
+	g.init(GraphInData<OSMNode, OSMEdge>{data.nodes,
+		std::vector<OSMEdge>(data.edges.begin(), data.edges.end()), data.meta_data});
+
+	CHGraph<OSMNode, OSMEdge> ch_g;
+	ch_g.init(std::move(data));
+	buildCH(ch_g, nr_of_threads, prioritizer_type);
+	std::cout << "Graph with " << g.getNrOfNodes() << " nodes and " << g.getNrOfEdges() << " edges, CH ("
+		<< to_string(prioritizer_type) << ") with " << ch_g.getNrOfEdges() << " edges\n";
+
+	if (g.getNrOfNodes() == 0) return 0;
+
+	LandmarkTable landmarks;
+	if (!landmark_file.empty() && std::ifstream(landmark_file).is_open()) {
+		landmarks = LandmarkTable::read(landmark_file);
+		std::cout << "Read " << landmarks.getLandmarks().size() << " landmarks from " << landmark_file << "\n";
+	}
+	else {
+		using namespace std::chrono;
+		steady_clock::time_point t1 = steady_clock::now();
+		landmarks = selectLandmarks(g, nr_of_landmarks, landmark_selection, seed);
+		std::cout << "Selected " << landmarks.getLandmarks().size() << " landmarks (" << to_string(landmark_selection)
+			<< ") in " << duration_cast<duration<double>>(steady_clock::now() - t1).count() << " seconds, "
+			<< MemoryUsage::formatBytes(landmarks.memoryUsage().total()) << "\n";
+		if (!landmark_file.empty()) {
+			std::ofstream os(landmark_file, std::ios::binary);
+			if (!os.is_open()) {
+				std::cerr << "FATAL_ERROR: Couldn't open landmark file \'" << landmark_file << "\'. Exiting." << std::endl;
+				return 1;
+			}
+			landmarks.write(os);
+		}
+	}
+
+	QueryBench<OSMNode, OSMEdge> bench(g, ch_g, landmarks);
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<NodeID> random_node(0, g.getNrOfNodes() - 1);
+
+	QueryResults random;
+	for (uint i(0); i < nr_of_queries; i++) {
+		NodeID const src(random_node(gen));
+		NodeID const tgt(random_node(gen));
+		bench.query(src, tgt, random);
+	}
+
+	std::vector<QueryResults> ranks;
+	for (uint i(0); i < nr_of_sources; i++) {
+		NodeID const src(random_node(gen));
+		auto const targets(bench.rankTargets(src));
+		if (ranks.size() < targets.size()) ranks.resize(targets.size());
+		for (size_t r(0); r < targets.size(); r++) {
+			bench.query(src, targets[r], ranks[r]);
+		}
+	}
+
+	for (auto& stats: random.engines) stats.sort();
+	printHeader("Random queries:");
+	printEngines(random);
+
+	for (auto& rank: ranks) {
+		for (auto& stats: rank.engines) stats.sort();
+	}
+	for (size_t r(0); r < ranks.size(); r++) {
+		printHeader("Dijkstra rank 2^" + std::to_string(r) + ":");
+		printEngines(ranks[r]);
+	}
+
+	std::cout << "\n" << (bench.mismatches() ? std::to_string(bench.mismatches()) : "No") << " distance mismatches.\n";
+
+	if (json_file == "-") {
+		writeJson(std::cout, infile, prioritizer_type, random, ranks, bench.mismatches());
+	}
+	else if (!json_file.empty()) {
+		std::ofstream os(json_file);
+		if (!os.is_open()) {
+			std::cerr << "FATAL_ERROR: Couldn't open json file \'" << json_file << "\'. Exiting." << std::endl;
+			return 1;
+		}
+		writeJson(os, infile, prioritizer_type, random, ranks, bench.mismatches());
+	}
+
+	return bench.mismatches() ? 1 : 0;
+}
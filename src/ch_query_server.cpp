@@ -0,0 +1,460 @@
+#include "defs.h"
+#include "tool_helpers.h"
+#include "chgraph.h"
+#include "dijkstra.h"
+#include "shortcut_unpacker.h"
+#include "binary_ch.h"
+#include "bounded_queue.h"
+#include "file_formats.h"
+#include "track_time.h"
+
+#include <getopt.h>
+#include <omp.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace chc;
+
+namespace
+{
+	/* max number of requests waiting for a worker */
+	size_t const QUEUE_SIZE(1024);
+	/* max number of answers of a client waiting for an earlier one */
+	size_t const MAX_PENDING(1024);
+	/* longer request lines are answered with an error */
+	size_t const MAX_REQUEST_LENGTH(1024);
+	/* seconds a client may not read before its connection is given up */
+	time_t const SEND_TIMEOUT(10);
+
+	char const* socket_path(nullptr);
+
+	void removeSocketAndExit(int)
+	{
+		if (socket_path) unlink(socket_path);
+		_exit(0);
+	}
+}
+
+void printHelp()
+{
+	std::cout
+		<< "Usage: ./ch_query_server [ARGUMENTS]\n"
+		<< "Loads a CH once and answers distance and path requests with a fixed pool of\n"
+		<< "worker threads, either from stdin (answers in request order on stdout) or\n"
+		<< "from the connections to a Unix domain socket.\n"
+		<< "Mandatory arguments are:\n"
+		<< "  -i, --infile <path>        Read CH from <path>\n"
+		<< "Optional arguments are:\n"
+		<< "  -f, --informat <format>    Expects infile in <format> (FMI_CH, BINARY_CH - default FMI_CH)\n"
+		<< "                             BINARY_CH is searched in place (memory mapped), without copying\n"
+		<< "  -s, --socket <path>        Listen on the Unix domain socket <path> instead of stdin\n"
+		<< "  -t, --threads <number>     Number of worker threads (default: 1)\n"
+		<< "  -c, --cache <number>       Number of unpacked shortcuts cached per worker (default: 1024)\n"
+		<< "Requests (one per line):\n"
+		<< "  dist <src> <tgt>           Answer: <dist>\n"
+		<< "  path <src> <tgt>           Answer: <dist> <node id>...\n"
+		<< "  coords <src> <tgt>         Answer: <dist> <lat> <lon>...\n"
+		<< "<dist> is -1 if there is no path; invalid requests are answered with: error <message>\n"
+		<< "Requests are limited to 1024 characters.\n";
+}
+
+/*
+ * Search state of one worker thread. CHGraphT is a CHGraph (FMI_CH) or the
+ * memory mapped file itself (BINARY_CH).
+ */
+template <typename CHGraphT>
+class Worker
+{
+	private:
+		CHGraphT const& _g;
+		CHDijkstra<OSMNode, OSMEdge, CHGraphT> _chdij;
+		ShortcutUnpacker<OSMNode, OSMEdge, CHGraphT> _unpacker;
+		std::vector<EdgeID> _path;
+	public:
+		Worker(CHGraphT const& g, size_t cache_size)
+			: _g(g), _chdij(g), _unpacker(g, cache_size) { }
+
+		std::string answer(std::string const& request);
+};
+
+template <typename CHGraphT>
+std::string Worker<CHGraphT>::answer(std::string const& request)
+{
+	std::istringstream is(request);
+	std::string command;
+	NodeID src, tgt;
+	if (!(is >> command >> src >> tgt) || !(is >> std::ws).eof()) {
+		return "error invalid request";
+	}
+	if (src >= _g.getNrOfNodes() || tgt >= _g.getNrOfNodes()) {
+		return "error invalid node id";
+	}
+
+	bool const with_path(command == "path" || command == "coords");
+	if (!with_path && command != "dist") {
+		return "error unknown command";
+	}
+
+	uint dist(_chdij.calcShopa(src, tgt, _path));
+
+	std::ostringstream os;
+	if (c::NO_DIST == dist) {
+		os << "-1";
+		return os.str();
+	}
+	os << dist;
+
+	if (command == "path") {
+		for (NodeID node: _unpacker.unpackPathNodeIDs(src, _path)) {
+			os << " " << node;
+		}
+	}
+	else if (command == "coords") {
+		os.precision(7);
+		os << std::fixed;
+		for (auto const& node: _unpacker.unpackPathNodes(src, _path)) {
+			os << " " << node.lat << " " << node.lon;
+		}
+	}
+	return os.str();
+}
+
+/*
+ * A client (stdin/stdout or one socket connection). Its requests are answered
+ * in parallel, but the answers are written in request order. At most
+ * MAX_PENDING answers wait for an earlier one, so a slow request doesn't let
+ * them pile up: workers with later answers wait until it is done.
+ */
+class Client
+{
+	private:
+		int _fd; /* -1: stdout */
+		bool _broken = false; /* the connection failed, drop the answers */
+
+		std::mutex _mutex;
+		std::condition_variable _window;
+		std::map<size_t, std::string> _pending;
+		size_t _next = 0;
+
+		void _write(std::string const& answer);
+	public:
+		/* requests read so far; only used by the thread reading them */
+		size_t nr_of_requests = 0;
+
+		explicit Client(int fd = -1) : _fd(fd) { }
+		~Client() { if (_fd >= 0) close(_fd); }
+
+		void put(size_t seq, std::string&& answer);
+};
+
+bool sendAll(int fd, std::string const& data)
+{
+	size_t sent(0);
+	while (sent < data.size()) {
+		ssize_t r(send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL));
+		if (r < 0) {
+			if (EINTR == errno) continue;
+			return false;
+		}
+		sent += r;
+	}
+	return true;
+}
+
+void Client::_write(std::string const& answer)
+{
+	if (_fd < 0) {
+		std::fwrite(answer.data(), 1, answer.size(), stdout);
+		std::fputc('\n', stdout);
+	}
+	else if (!_broken) {
+		/* fails after SEND_TIMEOUT if the client doesn't read */
+		_broken = !sendAll(_fd, answer + "\n");
+	}
+}
+
+void Client::put(size_t seq, std::string&& answer)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_window.wait(lock, [this, seq] { return seq < _next + MAX_PENDING; });
+	_pending.emplace(seq, std::move(answer));
+	if (_pending.begin()->first != _next) return;
+
+	while (!_pending.empty() && _pending.begin()->first == _next) {
+		_write(_pending.begin()->second);
+		_pending.erase(_pending.begin());
+		++_next;
+	}
+	if (_fd < 0) std::fflush(stdout);
+	_window.notify_all();
+}
+
+struct Request
+{
+	std::shared_ptr<Client> client;
+	size_t seq;
+	std::string line;
+};
+
+/* the workers answer the requests of all clients from one queue */
+template <typename CHGraphT>
+std::vector<std::thread> startWorkers(CHGraphT const& g, uint nr_of_threads, size_t cache_size,
+		BoundedQueue<Request>& requests)
+{
+	std::vector<std::thread> workers;
+	for (uint i(0); i < nr_of_threads; i++) {
+		workers.emplace_back([&g, cache_size, &requests] {
+			Worker<CHGraphT> worker(g, cache_size);
+			Request request;
+			while (requests.pop(request)) {
+				request.client->put(request.seq, worker.answer(request.line));
+				request.client.reset();
+			}
+		});
+	}
+	return workers;
+}
+
+template <typename CHGraphT>
+void servePipe(CHGraphT const& g, uint nr_of_threads, size_t cache_size)
+{
+	BoundedQueue<Request> requests(QUEUE_SIZE);
+	auto workers(startWorkers(g, nr_of_threads, cache_size, requests));
+
+	std::shared_ptr<Client> client(std::make_shared<Client>());
+	std::string line;
+	while (std::getline(std::cin, line)) {
+		requests.push(Request{client, client->nr_of_requests++, std::move(line)});
+	}
+	requests.close();
+
+	for (auto& worker: workers) {
+		worker.join();
+	}
+}
+
+/* a socket connection with its unfinished request line */
+struct Connection
+{
+	std::shared_ptr<Client> client;
+	std::string buffer;
+	bool skip_line = false; /* the rest of a too long line */
+};
+
+/*
+ * Reads the available data of a connection and queues its complete lines;
+ * lines longer than MAX_REQUEST_LENGTH are answered with an error right away.
+ * Returns false if the connection is closed.
+ */
+bool readRequests(int fd, Connection& connection, BoundedQueue<Request>& requests)
+{
+	char chunk[4096];
+	ssize_t r(recv(fd, chunk, sizeof(chunk), 0));
+	if (r < 0 && EINTR == errno) return true;
+	if (r <= 0) return false;
+	connection.buffer.append(chunk, r);
+
+	auto& client(connection.client);
+	size_t start(0), end;
+	while (std::string::npos != (end = connection.buffer.find('\n', start))) {
+		if (connection.skip_line) {
+			connection.skip_line = false;
+		}
+		else if (end - start > MAX_REQUEST_LENGTH) {
+			client->put(client->nr_of_requests++, "error request too long");
+		}
+		else {
+			requests.push(Request{client, client->nr_of_requests++, connection.buffer.substr(start, end - start)});
+		}
+		start = end + 1;
+	}
+	connection.buffer.erase(0, start);
+
+	if (connection.buffer.size() > MAX_REQUEST_LENGTH) {
+		if (!connection.skip_line) client->put(client->nr_of_requests++, "error request too long");
+		connection.skip_line = true;
+		connection.buffer.clear();
+	}
+	return true;
+}
+
+template <typename CHGraphT>
+int serveSocket(CHGraphT const& g, uint nr_of_threads, size_t cache_size)
+{
+	int listen_fd(socket(AF_UNIX, SOCK_STREAM, 0));
+	if (listen_fd < 0) {
+		std::perror("socket");
+		return 1;
+	}
+
+	sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (std::strlen(socket_path) >= sizeof(addr.sun_path)) {
+		std::cerr << "Socket path too long: '" << socket_path << "'\n";
+		return 1;
+	}
+	std::strcpy(addr.sun_path, socket_path);
+
+	unlink(socket_path); /* remove stale socket */
+	if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listen_fd, SOMAXCONN) < 0) {
+		std::perror("bind/listen");
+		return 1;
+	}
+	signal(SIGINT, removeSocketAndExit);
+	signal(SIGTERM, removeSocketAndExit);
+	std::cerr << "Listening on " << socket_path << "\n";
+
+	/* this thread accepts connections and reads their requests; the
+	 * workers answer them, so idle connections don't occupy a worker */
+	BoundedQueue<Request> requests(QUEUE_SIZE);
+	auto workers(startWorkers(g, nr_of_threads, cache_size, requests));
+
+	std::map<int, Connection> connections;
+	std::vector<pollfd> fds;
+	while (true) {
+		fds.assign(1, pollfd{listen_fd, POLLIN, 0});
+		for (auto const& connection: connections) {
+			fds.push_back(pollfd{connection.first, POLLIN, 0});
+		}
+		if (poll(fds.data(), fds.size(), -1) < 0) {
+			if (EINTR == errno) continue;
+			std::perror("poll");
+			break;
+		}
+
+		for (size_t i(1); i < fds.size(); i++) {
+			if (!fds[i].revents) continue;
+			int const fd(fds[i].fd);
+			if (!readRequests(fd, connections[fd], requests)) {
+				/* the socket is closed after the last answer (~Client) */
+				shutdown(fd, SHUT_RD);
+				connections.erase(fd);
+			}
+		}
+
+		if (fds[0].revents) {
+			int fd(accept(listen_fd, nullptr, nullptr));
+			if (fd < 0) {
+				if (EINTR == errno || ECONNABORTED == errno) continue;
+				std::perror("accept");
+				break;
+			}
+			timeval timeout{SEND_TIMEOUT, 0};
+			setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+			connections[fd].client = std::make_shared<Client>(fd);
+		}
+	}
+
+	connections.clear();
+	requests.close();
+	for (auto& worker: workers) {
+		worker.join();
+	}
+	close(listen_fd);
+	unlink(socket_path);
+	return 1;
+}
+
+template <typename CHGraphT>
+int serve(CHGraphT const& g, uint nr_of_threads, size_t cache_size)
+{
+	if (socket_path) return serveSocket(g, nr_of_threads, cache_size);
+
+	servePipe(g, nr_of_threads, cache_size);
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string infile("");
+	FileFormat informat(FileFormat::FMI_CH);
+	std::string socket_file("");
+	uint nr_of_threads(1);
+	size_t cache_size(1024);
+
+	const struct option longopts[] = {
+		{"help",	no_argument,        0, 'h'},
+		{"infile",	required_argument,  0, 'i'},
+		{"informat",	required_argument,  0, 'f'},
+		{"socket",	required_argument,  0, 's'},
+		{"threads",	required_argument,  0, 't'},
+		{"cache",	required_argument,  0, 'c'},
+		{0,0,0,0},
+	};
+
+	int index(0);
+	int iarg(0);
+	opterr = 1;
+
+	while((iarg = getopt_long(argc, argv, "hi:f:s:t:c:", longopts, &index)) != -1) {
+		switch (iarg) {
+			case 'h':
+				printHelp();
+				return 0;
+				break;
+			case 'i':
+				infile = optarg;
+				break;
+			case 'f':
+				informat = toFileFormat(optarg);
+				break;
+			case 's':
+				socket_file = optarg;
+				break;
+			case 't':
+				nr_of_threads = parseThreads(optarg);
+				break;
+			case 'c':
+				cache_size = parseUInt(optarg, "cache size");
+				break;
+			default:
+				printHelp();
+				return 1;
+				break;
+		}
+	}
+
+	if (infile == "") {
+		std::cerr << "No input file specified! Exiting.\n";
+		std::cerr << "Use ./ch_query_server --help to print the usage.\n";
+		return 1;
+	}
+	if (informat != FileFormat::FMI_CH && informat != FileFormat::BINARY_CH) {
+		std::cerr << "Unsupported CH format: " << to_string(informat) << "\n";
+		return 1;
+	}
+
+	/* stdout only carries answers; all logging goes to stderr */
+	std::cout.rdbuf(std::cerr.rdbuf());
+
+	if (socket_file != "") socket_path = socket_file.c_str();
+	/* the FMI_CH reader uses as many threads as there are workers */
+	omp_set_num_threads(nr_of_threads);
+
+	TrackTime tt(std::cerr);
+	if (informat == FileFormat::BINARY_CH) {
+		/* no copy: the workers search the mapped file */
+		FormatBINARY_CH::MappedCH g(infile);
+		tt.track("mapping CH");
+		return serve(g, nr_of_threads, cache_size);
+	}
+
+	CHGraph<OSMNode, OSMEdge> g;
+	g.initCH(readGraph<CHNode<OSMNode>, CHEdge<OSMEdge>>(informat, infile));
+	tt.track("loading CH");
+	return serve(g, nr_of_threads, cache_size);
+}
@@ -0,0 +1,168 @@
+#include "defs.h"
+#include "tool_helpers.h"
+#include "ch_constructor.h"
+#include "dijkstra.h"
+#include "many_to_many.h"
+#include "file_formats.h"
+#include "track_time.h"
+
+#include <getopt.h>
+#include <omp.h>
+#include <random>
+
+using namespace chc;
+
+void printHelp()
+{
+	std::cout
+		<< "Usage: ./ch_table [ARGUMENTS]\n"
+		<< "Builds a CH for the input graph and computes a distance table between\n"
+		<< "random sources and targets with the bucket based many-to-many algorithm.\n"
+		<< "Mandatory arguments are:\n"
+		<< "  -i, --infile <path>        Read graph from <path>\n"
+		<< "Optional arguments are:\n"
+		<< "  -f, --informat <format>    Expects infile in <format> (" << getAllFileFormatsString() << " - default FMI_DIST)\n"
+		<< "  -o, --outfile <path>       Write the table to <path>\n"
+		<< "  -t, --threads <number>     Number of threads to use in the calculations (default: 1)\n"
+		<< "  -s, --sources <number>     Number of random sources (default: 1000)\n"
+		<< "  -d, --targets <number>     Number of random targets (default: 1000)\n"
+		<< "  -r, --seed <number>        Seed for choosing sources and targets (default: 0)\n"
+		<< "  -c, --check <number>       Compare <number> random table entries with CHDijkstra (default: 100)\n";
+}
+
+int main(int argc, char* argv[])
+{
+	std::string infile("");
+	FileFormat informat(FileFormat::FMI_DIST);
+	std::string outfile("");
+	uint nr_of_threads(1);
+	uint nr_of_sources(1000);
+	uint nr_of_targets(1000);
+	uint seed(0);
+	uint nr_of_checks(100);
+
+	const struct option longopts[] = {
+		{"help",	no_argument,        0, 'h'},
+		{"infile",	required_argument,  0, 'i'},
+		{"informat",	required_argument,  0, 'f'},
+		{"outfile",     required_argument,  0, 'o'},
+		{"threads",	required_argument,  0, 't'},
+		{"sources",	required_argument,  0, 's'},
+		{"targets",	required_argument,  0, 'd'},
+		{"seed",	required_argument,  0, 'r'},
+		{"check",	required_argument,  0, 'c'},
+		{0,0,0,0},
+	};
+
+	int index(0);
+	int iarg(0);
+	opterr = 1;
+
+	while((iarg = getopt_long(argc, argv, "hi:f:o:t:s:d:r:c:", longopts, &index)) != -1) {
+		switch (iarg) {
+			case 'h':
+				printHelp();
+				return 0;
+				break;
+			case 'i':
+				infile = optarg;
+				break;
+			case 'f':
+				informat = toFileFormat(optarg);
+				break;
+			case 'o':
+				outfile = optarg;
+				break;
+			case 't':
+				nr_of_threads = parseThreads(optarg);
+				break;
+			case 's':
+				nr_of_sources = parseUInt(optarg, "number of sources");
+				break;
+			case 'd':
+				nr_of_targets = parseUInt(optarg, "number of targets");
+				break;
+			case 'r':
+				seed = parseUInt(optarg, "seed");
+				break;
+			case 'c':
+				nr_of_checks = parseUInt(optarg, "number of checks");
+				break;
+			default:
+				printHelp();
+				return 1;
+				break;
+		}
+	}
+
+	if (infile == "") {
+		std::cerr << "No input file specified! Exiting.\n";
+		std::cerr << "Use ./ch_table --help to print the usage.\n";
+		return 1;
+	}
+	omp_set_num_threads(nr_of_threads);
+
+	TrackTime tt(std::cout);
+
+	CHGraph<OSMNode, OSMEdge> g;
+	g.init(readGraph<OSMNode, CHEdge<OSMEdge>>(informat, infile));
+	tt.track("reading input");
+
+	buildCH(g, nr_of_threads);
+	tt.track("contracting graph");
+
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<NodeID> rand_node(0, g.getNrOfNodes() - 1);
+	std::vector<NodeID> sources(nr_of_sources);
+	std::vector<NodeID> targets(nr_of_targets);
+	for (auto& node: sources) node = rand_node(gen);
+	for (auto& node: targets) node = rand_node(gen);
+
+	CHManyToMany<OSMNode, OSMEdge> m2m(g, nr_of_threads);
+	auto table(m2m.calcTable(sources, targets));
+	tt.track("calculating " + std::to_string(nr_of_sources) + "x" + std::to_string(nr_of_targets) + " table");
+
+	if (nr_of_checks && !table.empty()) {
+		CHDijkstra<OSMNode, OSMEdge> chdij(g);
+		std::uniform_int_distribution<size_t> rand_entry(0, table.size() - 1);
+		std::vector<EdgeID> path;
+		uint errors(0);
+		for (uint i(0); i < nr_of_checks; i++) {
+			size_t entry(rand_entry(gen));
+			NodeID src(sources[entry / nr_of_targets]);
+			NodeID tgt(targets[entry % nr_of_targets]);
+			if (chdij.calcShopa(src, tgt, path) != table[entry]) {
+				std::cerr << "Wrong table entry from " << src << " to " << tgt << "\n";
+				errors++;
+			}
+		}
+		tt.track("checking " + std::to_string(nr_of_checks) + " entries with CHDijkstra");
+		if (errors) {
+			std::cerr << errors << " wrong table entries.\n";
+			return 1;
+		}
+	}
+
+	if (outfile != "") {
+		std::ofstream os(outfile);
+		if (!os.is_open()) {
+			std::cerr << "FATAL_ERROR: Couldn't open table file \'" <<
+				outfile << "\'. Exiting." << std::endl;
+			return 1;
+		}
+		for (uint i(0); i < nr_of_sources; i++) {
+			for (uint j(0); j < nr_of_targets; j++) {
+				uint dist(table[size_t(i) * nr_of_targets + j]);
+				if (j) os << " ";
+				if (c::NO_DIST == dist) os << "-1";
+				else os << dist;
+			}
+			os << "\n";
+		}
+		tt.track("writing table");
+	}
+
+	tt.summary();
+
+	return 0;
+}
@@ -5,10 +5,16 @@
 
 #include <vector>
 #include <algorithm>
+#include <cstdlib>
 
 namespace chc
 {
 
+namespace unit_tests
+{
+	void testCHGraphFromFile();
+}
+
 template <typename NodeT, typename EdgeT>
 class CHGraph : public Graph<NodeT, CHEdge<EdgeT> >
 {
@@ -29,6 +35,10 @@ class CHGraph : public Graph<NodeT, CHEdge<EdgeT> >
 
 		void _addNewEdge(Shortcut& new_edge,
 				std::vector<Shortcut>& new_edge_vec);
+
+		/* checks what searching and unpacking rely on, like
+		 * FormatBINARY_CH::MappedCH does for binary files */
+		static void _validateCH(GraphInData<CHNode<NodeT>, Shortcut> const& data);
 	public:
 		template <typename Data>
 		void init(Data&& data)
@@ -37,18 +47,110 @@ class CHGraph : public Graph<NodeT, CHEdge<EdgeT> >
 			BaseGraph::init(std::forward<Data>(data));
 		}
 
+		/* Init from an already contracted graph (e.g. read from a FMI_CH file);
+		 * the levels are taken from the nodes and the graph is complete, i.e.
+		 * like after rebuildCompleteGraph(). Aborts if data is no valid CH
+		 * (see _validateCH). */
+		void initCH(GraphInData<CHNode<NodeT>, Shortcut>&& data);
+
 
 		void restructure(std::vector<NodeID> const& removed,
 				std::vector<bool> const& to_remove,
 				std::vector<Shortcut>& new_shortcuts);
 		void rebuildCompleteGraph();
 
+		/* memory of the Graph plus node_levels and edges_dump */
+		MemoryUsage memoryUsage() const
+		{
+			MemoryUsage usage(BaseGraph::memoryUsage());
+			usage.add("node_levels", chc::memoryUsage(_node_levels));
+			usage.add("edges_dump", chc::memoryUsage(_edges_dump));
+			return usage;
+		}
+
 		bool isUp(Shortcut const& edge, EdgeType direction) const;
+		uint getLevel(NodeID node_id) const { return _node_levels[node_id]; }
+
+		/* Appends the original edges <edge_id> consists of to <path> (in
+		 * path order). Requires a complete graph, i.e. after rebuildCompleteGraph(). */
+		void unpackEdge(EdgeID edge_id, std::vector<EdgeID>& path) const;
+		/* <path> has to be in path order, like the result of CHDijkstra::calcShopa */
+		std::vector<EdgeID> unpackPath(std::vector<EdgeID> const& path) const;
 
 		/* destroys internal data structures */
 		GraphCHOutData<NodeT, Shortcut> exportData();
+		/* the data exportData returns, already before it is called: exportData
+		 * doesn't change the nodes and levels, but the edges are only valid
+		 * after it; getNrOfExportEdges is the number they'll have */
+		GraphCHOutData<NodeT, Shortcut> getExportData() const;
+		uint getNrOfExportEdges() const;
+
+		friend void unit_tests::testCHGraphFromFile();
 };
 
+template <typename NodeT, typename EdgeT>
+void CHGraph<NodeT, EdgeT>::initCH(GraphInData<CHNode<NodeT>, Shortcut>&& data)
+{
+	_validateCH(data);
+
+	GraphInData<NodeT, Shortcut> graph_data;
+	graph_data.meta_data.swap(data.meta_data);
+
+	_node_levels.resize(data.nodes.size());
+	graph_data.nodes.reserve(data.nodes.size());
+	_next_lvl = 0;
+	for (NodeID i(0); i < data.nodes.size(); i++) {
+		_node_levels[i] = data.nodes[i].lvl;
+		_next_lvl = std::max(_next_lvl, data.nodes[i].lvl + 1);
+		graph_data.nodes.push_back(static_cast<NodeT const&>(data.nodes[i]));
+	}
+	data.nodes = decltype(data.nodes)();
+
+	/* the center node isn't part of the CH formats */
+	for (auto& edge: data.edges) {
+		if (c::NO_EID != edge.child_edge1) {
+			edge.center_node = data.edges[edge.child_edge1].tgt;
+		}
+	}
+	graph_data.edges.swap(data.edges);
+
+	BaseGraph::init(std::move(graph_data));
+}
+
+template <typename NodeT, typename EdgeT>
+void CHGraph<NodeT, EdgeT>::_validateCH(GraphInData<CHNode<NodeT>, Shortcut> const& data)
+{
+	auto const invalid = [](char const* reason) {
+		std::cerr << "FATAL_ERROR: Invalid CH: " << reason << ". Exiting." << std::endl;
+		std::abort();
+	};
+	auto const& nodes(data.nodes);
+	auto const& edges(data.edges);
+
+	for (EdgeID edge_id(0); edge_id < edges.size(); edge_id++) {
+		Shortcut const& edge(edges[edge_id]);
+		if (edge.id != edge_id) invalid("edge id isn't its position");
+		if (edge.src >= nodes.size() || edge.tgt >= nodes.size()) invalid("edge node out of range");
+		/* every edge leads up in one direction */
+		if (nodes[edge.src].lvl == nodes[edge.tgt].lvl) invalid("edge between nodes of the same level");
+	}
+
+	/* the center node of a shortcut is below its ends, so unpacking a
+	 * child lowers the minimal level of the ends and terminates */
+	for (Shortcut const& edge: edges) {
+		if (c::NO_EID == edge.child_edge1 && c::NO_EID == edge.child_edge2) continue;
+		if (edge.child_edge1 >= edges.size() || edge.child_edge2 >= edges.size()) invalid("child edge out of range");
+
+		Shortcut const& child1(edges[edge.child_edge1]);
+		Shortcut const& child2(edges[edge.child_edge2]);
+		NodeID const center(child1.tgt);
+		if (child1.src != edge.src || child2.src != center || child2.tgt != edge.tgt ||
+				nodes[center].lvl >= std::min(nodes[edge.src].lvl, nodes[edge.tgt].lvl)) {
+			invalid("invalid shortcut");
+		}
+	}
+}
+
 template <typename NodeT, typename EdgeT>
 void CHGraph<NodeT, EdgeT>::restructure(
 		std::vector<NodeID> const& removed,
@@ -185,6 +287,38 @@ bool CHGraph<NodeT, EdgeT>::isUp(Shortcut const& edge, EdgeType direction) const
 	return false;
 }
 
+template <typename NodeT, typename EdgeT>
+void CHGraph<NodeT, EdgeT>::unpackEdge(EdgeID edge_id, std::vector<EdgeID>& path) const
+{
+	/* explicit stack instead of recursion; push the second child first so
+	 * the first child gets unpacked (and appended) first */
+	std::vector<EdgeID> stack(1, edge_id);
+	while (!stack.empty()) {
+		Shortcut const& edge(BaseGraph::getEdge(stack.back()));
+		stack.pop_back();
+
+		if (c::NO_EID == edge.child_edge1) {
+			path.push_back(edge.id);
+		}
+		else {
+			assert(c::NO_EID != edge.child_edge2);
+			stack.push_back(edge.child_edge2);
+			stack.push_back(edge.child_edge1);
+		}
+	}
+}
+
+template <typename NodeT, typename EdgeT>
+std::vector<EdgeID> CHGraph<NodeT, EdgeT>::unpackPath(std::vector<EdgeID> const& path) const
+{
+	std::vector<EdgeID> unpacked_path;
+	unpacked_path.reserve(path.size());
+	for (EdgeID edge_id: path) {
+		unpackEdge(edge_id, unpacked_path);
+	}
+	return unpacked_path;
+}
+
 template <typename NodeT, typename EdgeT>
 auto CHGraph<NodeT, EdgeT>::exportData() -> GraphCHOutData<NodeT, Shortcut>
 {
@@ -226,7 +360,19 @@ auto CHGraph<NodeT, EdgeT>::exportData() -> GraphCHOutData<NodeT, Shortcut>
 
 	_edges_dump = decltype(_edges_dump)();
 
+	return getExportData();
+}
+
+template <typename NodeT, typename EdgeT>
+auto CHGraph<NodeT, EdgeT>::getExportData() const -> GraphCHOutData<NodeT, Shortcut>
+{
 	return GraphCHOutData<NodeT, Shortcut>{BaseGraph::_nodes, _node_levels, _out_edges, BaseGraph::_meta_data};
 }
 
+template <typename NodeT, typename EdgeT>
+uint CHGraph<NodeT, EdgeT>::getNrOfExportEdges() const
+{
+	return _out_edges.empty() && _in_edges.empty() ? _edges_dump.size() : _out_edges.size();
+}
+
 }
@@ -19,6 +19,14 @@
 
 #define Unused(x) ((void)x)
 
+/* statements that only count work for statistics (cmake -DCHC_STATS=ON);
+ * not wrapped in a block, so they may declare variables for later Count() */
+#ifdef CHC_STATS
+#define Count(x) x
+#else
+#define Count(x) CHC_NOP
+#endif
+
 #ifdef NDEBUG
 # undef NDEBUG
 # include <cassert>
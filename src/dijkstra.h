@@ -3,10 +3,12 @@
 #include "graph.h"
 #include "chgraph.h"
 #include "enum_array.h"
+#include "geo.h"
 
 #include <vector>
 #include <limits>
 #include <queue>
+#include <algorithm>
 
 namespace chc
 {
@@ -17,6 +19,64 @@ namespace unit_tests
 	void testDijkstra();
 }
 
+/* work done by the last search */
+struct SearchStats
+{
+	size_t settled_nodes = 0;
+	size_t relaxed_edges = 0;
+};
+
+/*
+ * Tentative distances of one search (direction) and the edges they were
+ * found by. Resetting only touches the reached nodes, so a search costs
+ * O(search space) and not O(#nodes).
+ */
+struct SearchState
+{
+	std::vector<EdgeID> _found_by;
+	std::vector<uint> _dists;
+	std::vector<NodeID> _reset_dists;
+
+	void init(size_t nr_of_nodes)
+	{
+		_found_by.resize(nr_of_nodes);
+		_dists.assign(nr_of_nodes, c::NO_DIST);
+	}
+
+	void reset()
+	{
+		for (auto const node: _reset_dists) {
+			_dists[node] = c::NO_DIST;
+		}
+		_reset_dists.clear();
+	}
+
+	/* sets dist and found_by of node if dist is shorter; returns if it was */
+	bool improve(NodeID node, uint dist, EdgeID found_by)
+	{
+		if (dist >= _dists[node]) return false;
+		if (_dists[node] == c::NO_DIST) {
+			_reset_dists.push_back(node);
+		}
+		_dists[node] = dist;
+		_found_by[node] = found_by;
+		return true;
+	}
+
+	/* appends the edges on the way from node back to start to path; for a
+	 * forward (OUT) search that's the reverse path order */
+	template <typename GraphT>
+	void backtrack(GraphT const& g, NodeID node, NodeID start, EdgeType direction,
+			std::vector<EdgeID>& path) const
+	{
+		while (node != start) {
+			EdgeID edge_id = _found_by[node];
+			node = otherNode(g.getEdge(edge_id), !direction);
+			path.push_back(edge_id);
+		}
+	}
+};
+
 template <typename Node, typename Edge>
 class Dijkstra
 {
@@ -27,36 +87,53 @@ class Dijkstra
 
 		Graph<Node, Edge> const& _g;
 
-		std::vector<EdgeID> _found_by;
-		std::vector<uint> _dists;
-		std::vector<NodeID> _reset_dists;
+		SearchState _state;
+		SearchStats _stats;
 
 		void _reset();
-		void _relaxAllEdges(PQ& pq, PQElement const& top);
+		void _relaxAllEdges(PQ& pq, PQElement const& top, EdgeType direction = EdgeType::OUT);
 	public:
 		Dijkstra(Graph<Node, Edge> const& g);
 
 		/**
 		 * @brief Computes the shortest path between src and tgt.
 		 *
-		 * @param path The edges of the shortest path in no
-		 * particular order.
+		 * @param path The edges of the shortest path in path
+		 * order (from src to tgt).
 		 *
 		 * @return The distance of the shortest path.
 		 */
 		uint calcShopa(NodeID src, NodeID tgt,
 				std::vector<EdgeID>& path);
+
+		/**
+		 * @brief Runs a search from src until all reachable nodes are
+		 * settled.
+		 *
+		 * @param callback Called as callback(node, dist) for every settled
+		 * node, in order of increasing distance (i.e. the i-th call is for
+		 * the node with Dijkstra rank i).
+		 * @param direction IN searches backwards, i.e. the distances are
+		 * the ones from the nodes to src.
+		 */
+		template <typename Callback>
+		void run(NodeID src, Callback&& callback, EdgeType direction = EdgeType::OUT);
+
+		/* edge by which node was reached in the last search (c::NO_EID for
+		 * its start); only valid for nodes reached by it */
+		EdgeID foundBy(NodeID node) const { return _state._found_by[node]; }
+
+		SearchStats const& getStats() const { return _stats; }
 };
 
 template <typename Node, typename Edge>
 struct Dijkstra<Node, Edge>::PQElement
 {
 	NodeID node;
-	EdgeID found_by;
 	uint _dist;
 
-	PQElement(NodeID node, EdgeID found_by, uint dist)
-		: node(node), found_by(found_by), _dist(dist) {}
+	PQElement(NodeID node, uint dist)
+		: node(node), _dist(dist) {}
 
 	bool operator>(PQElement const& other) const
 	{
@@ -69,8 +146,10 @@ struct Dijkstra<Node, Edge>::PQElement
 
 template <typename Node, typename Edge>
 Dijkstra<Node,Edge>::Dijkstra(Graph<Node, Edge> const& g)
-	: _g(g), _found_by(g.getNrOfNodes()),
-	_dists(g.getNrOfNodes(), c::NO_DIST) {}
+	: _g(g)
+{
+	_state.init(g.getNrOfNodes());
+}
 
 template <typename Node, typename Edge>
 uint Dijkstra<Node,Edge>::calcShopa(NodeID src, NodeID tgt,
@@ -80,17 +159,15 @@ uint Dijkstra<Node,Edge>::calcShopa(NodeID src, NodeID tgt,
 	path.clear();
 
 	PQ pq;
-	pq.push(PQElement(src, c::NO_EID, 0));
-	_dists[src] = 0;
-	_reset_dists.push_back(src);
+	pq.push(PQElement(src, 0));
+	_state.improve(src, 0, c::NO_EID);
 
 	// Dijkstra loop
 	while (!pq.empty() && pq.top().node != tgt) {
 		PQElement top(pq.top());
 		pq.pop();
 
-		if (_dists[top.node] == top.distance()) {
-			_found_by[top.node] = top.found_by;
+		if (_state._dists[top.node] == top.distance()) {
 			_relaxAllEdges(pq, top);
 		}
 	}
@@ -99,47 +176,320 @@ uint Dijkstra<Node,Edge>::calcShopa(NodeID src, NodeID tgt,
 		Print("No path found from " << src << " to " << tgt << ".");
 		return c::NO_DIST;
 	}
+	_stats.settled_nodes++; /* tgt */
 
 	// Path backtracking.
-	NodeID bt_node(tgt);
-	_found_by[tgt] = pq.top().found_by;
-	while (bt_node != src) {
-		EdgeID edge_id = _found_by[bt_node];
-		bt_node = _g.getEdge(edge_id).src;
-		path.push_back(edge_id);
-	}
+	_state.backtrack(_g, tgt, src, EdgeType::OUT, path);
+	std::reverse(path.begin(), path.end());
 
 	return pq.top().distance();
 }
 
 template <typename Node, typename Edge>
-void Dijkstra<Node,Edge>::_relaxAllEdges(PQ& pq, PQElement const& top)
+template <typename Callback>
+void Dijkstra<Node,Edge>::run(NodeID src, Callback&& callback, EdgeType direction)
 {
-	for (auto const& edge: _g.nodeEdges(top.node, EdgeType::OUT)) {
-		NodeID tgt(edge.tgt);
+	_reset();
+
+	PQ pq;
+	pq.push(PQElement(src, 0));
+	_state.improve(src, 0, c::NO_EID);
+
+	while (!pq.empty()) {
+		PQElement top(pq.top());
+		pq.pop();
+
+		if (_state._dists[top.node] == top.distance()) {
+			callback(top.node, top.distance());
+			_relaxAllEdges(pq, top, direction);
+		}
+	}
+}
+
+template <typename Node, typename Edge>
+void Dijkstra<Node,Edge>::_relaxAllEdges(PQ& pq, PQElement const& top, EdgeType direction)
+{
+	_stats.settled_nodes++;
+	for (auto const& edge: _g.nodeEdges(top.node, direction)) {
+		_stats.relaxed_edges++;
+		NodeID other_node(otherNode(edge, direction));
 		uint new_dist(top.distance() + edge.distance());
 
-		if (new_dist < _dists[tgt]) {
-			if (_dists[tgt] == c::NO_DIST) {
-				_reset_dists.push_back(tgt);
+		if (_state.improve(other_node, new_dist, edge.id)) {
+			pq.push(PQElement(other_node, new_dist));
+		}
+	}
+}
+
+template <typename Node, typename Edge>
+void Dijkstra<Node,Edge>::_reset()
+{
+	_state.reset();
+	_stats = SearchStats();
+}
+
+/*
+ * Dijkstra from src and backwards from tgt on the plain graph, always
+ * advancing the search with the smaller distance, until the minima of both
+ * queues add up to at least the shortest path seen so far.
+ */
+template <typename Node, typename Edge>
+class BidirectionalDijkstra
+{
+	private:
+		struct PQElement;
+		typedef std::priority_queue<
+			PQElement, std::vector<PQElement>, std::greater<PQElement> > PQ;
+
+		Graph<Node, Edge> const& _g;
+
+		enum_array<SearchState, EdgeType, 2> _dir;
+		SearchStats _stats;
+
+		void _reset();
+	public:
+		BidirectionalDijkstra(Graph<Node, Edge> const& g);
+
+		/* like Dijkstra::calcShopa */
+		uint calcShopa(NodeID src, NodeID tgt,
+				std::vector<EdgeID>& path);
+
+		/* nodes settled and edges relaxed in both directions */
+		SearchStats const& getStats() const { return _stats; }
+};
+
+template <typename Node, typename Edge>
+struct BidirectionalDijkstra<Node, Edge>::PQElement
+{
+	NodeID node;
+	uint _dist;
+
+	PQElement(NodeID node, uint dist)
+		: node(node), _dist(dist) {}
+
+	bool operator>(PQElement const& other) const
+	{
+		return _dist > other._dist;
+	}
+
+	/* make interface look similar to an edge */
+	uint distance() const { return _dist; }
+};
+
+template <typename Node, typename Edge>
+BidirectionalDijkstra<Node,Edge>::BidirectionalDijkstra(Graph<Node, Edge> const& g)
+	: _g(g)
+{
+	for (auto& dir_state: _dir) {
+		dir_state.init(g.getNrOfNodes());
+	}
+}
+
+template <typename Node, typename Edge>
+uint BidirectionalDijkstra<Node,Edge>::calcShopa(NodeID src, NodeID tgt,
+		std::vector<EdgeID>& path)
+{
+	_reset();
+	path.clear();
+
+	enum_array<PQ, EdgeType, 2> pq;
+	pq[EdgeType::OUT].push(PQElement(src, 0));
+	pq[EdgeType::IN].push(PQElement(tgt, 0));
+	_dir[EdgeType::OUT].improve(src, 0, c::NO_EID);
+	_dir[EdgeType::IN].improve(tgt, 0, c::NO_EID);
+
+	uint shortest_dist(src == tgt ? 0 : c::NO_DIST);
+	NodeID center_node(src == tgt ? src : c::NO_NID);
+	while (!pq[EdgeType::OUT].empty() && !pq[EdgeType::IN].empty()
+			&& pq[EdgeType::OUT].top().distance() + pq[EdgeType::IN].top().distance() < shortest_dist) {
+		EdgeType dir(pq[EdgeType::OUT].top().distance() <= pq[EdgeType::IN].top().distance()
+				? EdgeType::OUT : EdgeType::IN);
+		PQElement top(pq[dir].top());
+		pq[dir].pop();
+
+		if (_dir[dir]._dists[top.node] != top.distance()) continue;
+
+		_stats.settled_nodes++;
+		for (auto const& edge: _g.nodeEdges(top.node, dir)) {
+			_stats.relaxed_edges++;
+			NodeID other_node(otherNode(edge, dir));
+			uint new_dist(top.distance() + edge.distance());
+
+			if (_dir[dir].improve(other_node, new_dist, edge.id)) {
+				pq[dir].push(PQElement(other_node, new_dist));
+
+				uint rest_dist(_dir[!dir]._dists[other_node]);
+				if (rest_dist != c::NO_DIST && new_dist + rest_dist < shortest_dist) {
+					shortest_dist = new_dist + rest_dist;
+					center_node = other_node;
+				}
 			}
-			_dists[tgt] = new_dist;
+		}
+	}
+
+	if (center_node == c::NO_NID) {
+		Print("No path found from " << src << " to " << tgt << ".");
+		return c::NO_DIST;
+	}
+
+	// Path backtracking.
+	_dir[EdgeType::OUT].backtrack(_g, center_node, src, EdgeType::OUT, path);
+	std::reverse(path.begin(), path.end());
+	_dir[EdgeType::IN].backtrack(_g, center_node, tgt, EdgeType::IN, path);
+
+	return shortest_dist;
+}
+
+template <typename Node, typename Edge>
+void BidirectionalDijkstra<Node,Edge>::_reset()
+{
+	for (auto& dir_state: _dir) {
+		dir_state.reset();
+	}
+	_stats = SearchStats();
+}
+
+/*
+ * A* on the plain graph with the great-circle distance to tgt as heuristic
+ * (the nodes need lat and lon). It's scaled with the smallest ratio of edge
+ * distance to great-circle length over all edges with a distance > 0, so it
+ * works for any metric (meters, travel times, ...). Edges with distance 0
+ * (e.g. rounded down) can be passed for free, so the total great-circle
+ * length of them is subtracted; then the heuristic is a lower bound, but not
+ * necessarily consistent, so nodes are settled again if they improve.
+ */
+template <typename Node, typename Edge>
+class AStar
+{
+	private:
+		struct PQElement;
+		typedef std::priority_queue<
+			PQElement, std::vector<PQElement>, std::greater<PQElement> > PQ;
+
+		Graph<Node, Edge> const& _g;
+
+		SearchState _state;
+		SearchStats _stats;
+		double _scale;
+		double _offset; /* scaled length of the edges with distance 0 */
+
+		uint _heuristic(NodeID node, NodeID tgt) const;
+		void _reset();
+	public:
+		AStar(Graph<Node, Edge> const& g);
+
+		/* like Dijkstra::calcShopa */
+		uint calcShopa(NodeID src, NodeID tgt,
+				std::vector<EdgeID>& path);
+
+		/* metric units per meter of great-circle distance */
+		double getScale() const { return _scale; }
+
+		SearchStats const& getStats() const { return _stats; }
+};
+
+template <typename Node, typename Edge>
+struct AStar<Node, Edge>::PQElement
+{
+	NodeID node;
+	uint dist;
+	uint _key; /* dist + heuristic */
+
+	PQElement(NodeID node, uint dist, uint key)
+		: node(node), dist(dist), _key(key) {}
+
+	bool operator>(PQElement const& other) const
+	{
+		return _key > other._key;
+	}
+};
 
-			pq.push(PQElement(tgt, edge.id, new_dist));
+template <typename Node, typename Edge>
+AStar<Node,Edge>::AStar(Graph<Node, Edge> const& g)
+	: _g(g), _scale(std::numeric_limits<double>::max()), _offset(0)
+{
+	_state.init(g.getNrOfNodes());
+
+	double free_length(0);
+	for (NodeID node(0); node < g.getNrOfNodes(); node++) {
+		for (auto const& edge: g.nodeEdges(node, EdgeType::OUT)) {
+			Node const& src(g.getNode(edge.src));
+			Node const& tgt(g.getNode(edge.tgt));
+			double const length(geoDist(src.lat, src.lon, tgt.lat, tgt.lon));
+			if (edge.distance() == 0) {
+				free_length += length;
+			}
+			else if (length > 0) {
+				_scale = std::min(_scale, edge.distance() / length);
+			}
 		}
 	}
+	/* no geometry: plain Dijkstra; else leave room for rounding errors */
+	_scale = _scale == std::numeric_limits<double>::max() ? 0 : _scale * (1 - 1e-6);
+	_offset = _scale * free_length + 1;
 }
 
 template <typename Node, typename Edge>
-void Dijkstra<Node,Edge>::_reset()
+uint AStar<Node,Edge>::_heuristic(NodeID node, NodeID tgt) const
 {
-	for (auto const node: _reset_dists) {
-		_dists[node] = c::NO_DIST;
+	Node const& n1(_g.getNode(node));
+	Node const& n2(_g.getNode(tgt));
+	return std::max(0.0, _scale * geoDist(n1.lat, n1.lon, n2.lat, n2.lon) - _offset);
+}
+
+template <typename Node, typename Edge>
+uint AStar<Node,Edge>::calcShopa(NodeID src, NodeID tgt,
+		std::vector<EdgeID>& path)
+{
+	_reset();
+	path.clear();
+
+	PQ pq;
+	pq.push(PQElement(src, 0, _heuristic(src, tgt)));
+	_state.improve(src, 0, c::NO_EID);
+
+	while (!pq.empty() && pq.top().node != tgt) {
+		PQElement top(pq.top());
+		pq.pop();
+
+		if (_state._dists[top.node] != top.dist) continue;
+
+		_stats.settled_nodes++;
+		for (auto const& edge: _g.nodeEdges(top.node, EdgeType::OUT)) {
+			_stats.relaxed_edges++;
+			uint new_dist(top.dist + edge.distance());
+
+			if (_state.improve(edge.tgt, new_dist, edge.id)) {
+				pq.push(PQElement(edge.tgt, new_dist, new_dist + _heuristic(edge.tgt, tgt)));
+			}
+		}
 	}
-	_reset_dists.clear();
+
+	if (pq.empty()) {
+		Print("No path found from " << src << " to " << tgt << ".");
+		return c::NO_DIST;
+	}
+	_stats.settled_nodes++; /* tgt */
+
+	// Path backtracking.
+	_state.backtrack(_g, tgt, src, EdgeType::OUT, path);
+	std::reverse(path.begin(), path.end());
+
+	return pq.top().dist;
 }
 
 template <typename Node, typename Edge>
+void AStar<Node,Edge>::_reset()
+{
+	_state.reset();
+	_stats = SearchStats();
+}
+
+/*
+ * Bidirectional upward search in a CH. GraphT is a CHGraph or a view with the
+ * same interface (nodeEdges, isUp, getEdge), e.g. FormatBINARY_CH::MappedCH.
+ */
+template <typename Node, typename Edge, typename GraphT = CHGraph<Node, Edge>>
 class CHDijkstra
 {
 	private:
@@ -147,45 +497,42 @@ class CHDijkstra
 		typedef std::priority_queue<
 			PQElement, std::vector<PQElement>, std::greater<PQElement> > PQ;
 
-		CHGraph<Node, Edge> const& _g;
+		GraphT const& _g;
 
-		/*
-		 * data stored per direction
-		 */
-		struct direction_info {
-			std::vector<EdgeID> _found_by;
-			std::vector<uint> _dists;
-			std::vector<NodeID> _reset_dists;
-		};
-		enum_array<direction_info, EdgeType, 2> _dir;
+		/* search state per direction */
+		enum_array<SearchState, EdgeType, 2> _dir;
+
+		SearchStats _stats;
 
 		void _reset();
 		void _relaxAllEdges(PQ& pq, PQElement const& top);
 	public:
-		CHDijkstra(CHGraph<Node, Edge> const& g);
+		CHDijkstra(GraphT const& g);
 
 		/**
 		 * @brief Computes the shortest path between src and tgt.
 		 *
-		 * @param path The edges of the shortest path in no
-		 * particular order.
+		 * @param path The edges of the shortest path in path
+		 * order (from src to tgt).
 		 *
 		 * @return The distance of the shortest path.
 		 */
 		uint calcShopa(NodeID src, NodeID tgt,
 				std::vector<EdgeID>& path);
+
+		/* nodes settled and (upward) edges relaxed in both directions */
+		SearchStats const& getStats() const { return _stats; }
 };
 
-template <typename Node, typename Edge>
-struct CHDijkstra<Node, Edge>::PQElement
+template <typename Node, typename Edge, typename GraphT>
+struct CHDijkstra<Node, Edge, GraphT>::PQElement
 {
 	NodeID node;
-	EdgeID found_by;
 	EdgeType direction;
 	uint _dist;
 
-	PQElement(NodeID node, EdgeID found_by, EdgeType direction, uint dist)
-		: node(node), found_by(found_by), direction(direction), _dist(dist) {}
+	PQElement(NodeID node, EdgeType direction, uint dist)
+		: node(node), direction(direction), _dist(dist) {}
 
 	bool operator>(PQElement const& other) const
 	{
@@ -196,29 +543,26 @@ struct CHDijkstra<Node, Edge>::PQElement
 	uint distance() const { return _dist; }
 };
 
-template <typename Node, typename Edge>
-CHDijkstra<Node,Edge>::CHDijkstra(CHGraph<Node, Edge> const& g)
+template <typename Node, typename Edge, typename GraphT>
+CHDijkstra<Node, Edge, GraphT>::CHDijkstra(GraphT const& g)
 : _g(g) {
-	for(auto& dir_info: _dir) {
-		dir_info._dists.resize(g.getNrOfNodes(), c::NO_DIST);
-		dir_info._found_by.resize(g.getNrOfNodes());
+	for(auto& dir_state: _dir) {
+		dir_state.init(g.getNrOfNodes());
 	}
 }
 
-template <typename Node, typename Edge>
-uint CHDijkstra<Node,Edge>::calcShopa(NodeID src, NodeID tgt,
+template <typename Node, typename Edge, typename GraphT>
+uint CHDijkstra<Node, Edge, GraphT>::calcShopa(NodeID src, NodeID tgt,
 		std::vector<EdgeID>& path)
 {
 	_reset();
 	path.clear();
 
 	PQ pq;
-	pq.push(PQElement(src, c::NO_EID, EdgeType::OUT, 0));
-	pq.push(PQElement(tgt, c::NO_EID, EdgeType::IN, 0));
-	_dir[EdgeType::OUT]._dists[src] = 0;
-	_dir[EdgeType::OUT]._reset_dists.push_back(src);
-	_dir[EdgeType::IN]._dists[tgt] = 0;
-	_dir[EdgeType::IN]._reset_dists.push_back(tgt);
+	pq.push(PQElement(src, EdgeType::OUT, 0));
+	pq.push(PQElement(tgt, EdgeType::IN, 0));
+	_dir[EdgeType::OUT].improve(src, 0, c::NO_EID);
+	_dir[EdgeType::IN].improve(tgt, 0, c::NO_EID);
 
 	// Dijkstra loop
 	uint shortest_dist(c::NO_DIST);
@@ -228,7 +572,6 @@ uint CHDijkstra<Node,Edge>::calcShopa(NodeID src, NodeID tgt,
 		pq.pop();
 
 		if (_dir[top.direction]._dists[top.node] == top.distance()) {
-			_dir[top.direction]._found_by[top.node] = top.found_by;
 			_relaxAllEdges(pq, top);
 
 			uint rest_dist = _dir[!top.direction]._dists[top.node];
@@ -246,58 +589,127 @@ uint CHDijkstra<Node,Edge>::calcShopa(NodeID src, NodeID tgt,
 	}
 
 	// Path backtracking.
-	for (uint i(0); i<2; i++) {
-		EdgeType dir((EdgeType) i);
-		NodeID bt_node(center_node);
-		NodeID end_node;
-		if (dir == EdgeType::OUT) {
-			end_node = src;
-		}
-		else {
-			end_node = tgt;
-		}
-
-		while (bt_node != end_node) {
-			EdgeID edge_id = _dir[dir]._found_by[bt_node];
-			bt_node = otherNode(_g.getEdge(edge_id), !dir);
-			path.push_back(edge_id);
-		}
-	}
+	_dir[EdgeType::OUT].backtrack(_g, center_node, src, EdgeType::OUT, path);
+	/* the forward part was collected from center_node back to src */
+	std::reverse(path.begin(), path.end());
+	_dir[EdgeType::IN].backtrack(_g, center_node, tgt, EdgeType::IN, path);
 
 	return shortest_dist;
 }
 
-template <typename Node, typename Edge>
-void CHDijkstra<Node,Edge>::_relaxAllEdges(PQ& pq, PQElement const& top)
+template <typename Node, typename Edge, typename GraphT>
+void CHDijkstra<Node, Edge, GraphT>::_relaxAllEdges(PQ& pq, PQElement const& top)
 {
 	EdgeType dir(top.direction);
+	_stats.settled_nodes++;
 	// TODO When edges are sorted accordingly: loop while
 	// edge is up.
 	for (auto const& edge: _g.nodeEdges(top.node, dir)) {
 		if (_g.isUp(edge, dir)) {
+			_stats.relaxed_edges++;
 			NodeID other_node(otherNode(edge, dir));
 			uint new_dist(top.distance() + edge.distance());
 
-			if (new_dist < _dir[dir]._dists[other_node]) {
-				if (_dir[dir]._dists[other_node] == c::NO_DIST) {
-					_dir[dir]._reset_dists.push_back(other_node);
-				}
-				_dir[dir]._dists[other_node] = new_dist;
-
-				pq.push(PQElement(other_node, edge.id, dir, new_dist));
+			if (_dir[dir].improve(other_node, new_dist, edge.id)) {
+				pq.push(PQElement(other_node, dir, new_dist));
 			}
 		}
 	}
 }
 
+template <typename Node, typename Edge, typename GraphT>
+void CHDijkstra<Node, Edge, GraphT>::_reset()
+{
+	for (auto& dir_state: _dir) {
+		dir_state.reset();
+	}
+	_stats = SearchStats();
+}
+
+/*
+ * Explores the complete upward search space of a node in the CH, i.e. the
+ * building block of many-to-many, PHAST and similar one-to-many algorithms.
+ */
+template <typename Node, typename Edge>
+class CHUpwardDijkstra
+{
+	private:
+		struct PQElement;
+		typedef std::priority_queue<
+			PQElement, std::vector<PQElement>, std::greater<PQElement> > PQ;
+
+		CHGraph<Node, Edge> const& _g;
+
+		SearchState _state;
+	public:
+		CHUpwardDijkstra(CHGraph<Node, Edge> const& g);
+
+		/**
+		 * @brief Runs an upward search from start in the given direction
+		 * (OUT: forward search, IN: backward search).
+		 *
+		 * @param callback Called as callback(node, dist) for every settled
+		 * node, in order of increasing distance.
+		 */
+		template <typename Callback>
+		void run(NodeID start, EdgeType direction, Callback&& callback);
+
+		/* Distance of node in the last search (c::NO_DIST if not reached) */
+		uint getDist(NodeID node) const { return _state._dists[node]; }
+};
+
+template <typename Node, typename Edge>
+struct CHUpwardDijkstra<Node, Edge>::PQElement
+{
+	NodeID node;
+	uint _dist;
+
+	PQElement(NodeID node, uint dist)
+		: node(node), _dist(dist) {}
+
+	bool operator>(PQElement const& other) const
+	{
+		return _dist > other._dist;
+	}
+
+	/* make interface look similar to an edge */
+	uint distance() const { return _dist; }
+};
+
+template <typename Node, typename Edge>
+CHUpwardDijkstra<Node,Edge>::CHUpwardDijkstra(CHGraph<Node, Edge> const& g)
+	: _g(g)
+{
+	_state.init(g.getNrOfNodes());
+}
+
 template <typename Node, typename Edge>
-void CHDijkstra<Node,Edge>::_reset()
+template <typename Callback>
+void CHUpwardDijkstra<Node,Edge>::run(NodeID start, EdgeType direction, Callback&& callback)
 {
-	for (auto& dir: _dir) {
-		for (auto const node: dir._reset_dists) {
-			dir._dists[node] = c::NO_DIST;
+	_state.reset();
+
+	PQ pq;
+	pq.push(PQElement(start, 0));
+	_state.improve(start, 0, c::NO_EID);
+
+	while (!pq.empty()) {
+		PQElement top(pq.top());
+		pq.pop();
+
+		if (_state._dists[top.node] != top.distance()) continue;
+		callback(top.node, top.distance());
+
+		for (auto const& edge: _g.nodeEdges(top.node, direction)) {
+			if (!_g.isUp(edge, direction)) continue;
+
+			NodeID other_node(otherNode(edge, direction));
+			uint new_dist(top.distance() + edge.distance());
+
+			if (_state.improve(other_node, new_dist, edge.id)) {
+				pq.push(PQElement(other_node, new_dist));
+			}
 		}
-		dir._reset_dists.clear();
 	}
 }
 
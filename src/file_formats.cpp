@@ -37,6 +37,61 @@ namespace chc {
 			return r;
 #endif
 		}
+
+		/* "# key : value" line of the FMI header */
+		void parseMetaDataLine(std::string const& line, Metadata& meta_data)
+		{
+			std::stringstream ss(line);
+			std::string hash;
+			std::string key;
+			std::string map;
+			std::string colon;
+			ss >> hash >> key >> colon >> map;
+
+			if (hash != "#") {
+				std::cout << "Error while parsing meta data: expected '#' instead of '"
+					<< hash << "'\n";
+			}
+			if (colon != ":") {
+				std::cout << "Error while parsing meta data: expected ':' instead of '"
+					<< colon << "'\n";
+			}
+
+			meta_data[key] = map;
+		}
+
+		/* marks edges with negative distance as invalid (like the text readers) */
+		template<typename EdgeT>
+		void scanDist(TextScanner& scanner, EdgeT& edge, EdgeID edge_id)
+		{
+			auto signed_dist(scanner.template readSigned<typename std::make_signed<decltype(edge.dist)>::type>());
+			if (signed_dist >= 0) {
+				edge.id = edge_id;
+				edge.dist = signed_dist;
+			} else {
+				// mark as invalid edge with 0 length
+				edge.id = c::NO_EID;
+				edge.dist = 0;
+			}
+		}
+
+		/* "<child_edge1> <child_edge2>\n", -1 for no child */
+		template<typename EdgeT>
+		void formatChildEdges(TextBuffer& buffer, CHEdge<EdgeT> const& edge)
+		{
+			if (edge.child_edge1 == c::NO_EID) buffer.append("-1", 2);
+			else buffer.append(edge.child_edge1);
+			buffer.append(' ');
+			if (edge.child_edge2 == c::NO_EID) buffer.append("-1", 2);
+			else buffer.append(edge.child_edge2);
+			buffer.append('\n');
+		}
+
+		void invalidNodeId(NodeID read_id, NodeID node_id)
+		{
+			std::cerr << "FATAL_ERROR: Invalid node id " << read_id << " at index " << node_id << ". Exiting\n";
+			std::abort();
+		}
 	}
 
 	FileFormat toFileFormat(std::string const& format)
@@ -65,6 +120,9 @@ namespace chc {
 		else if (format == "STEFAN_CH") {
 			return FileFormat::STEFAN_CH;
 		}
+		else if (format == "BINARY_CH") {
+			return FileFormat::BINARY_CH;
+		}
 		else {
 			std::cerr << "Unknown fileformat: " << format << "\n";
 		}
@@ -91,6 +149,8 @@ namespace chc {
 			return "FMI_EUCL_CH";
 		case FileFormat::STEFAN_CH:
 			return "STEFAN_CH";
+		case FileFormat::BINARY_CH:
+			return "BINARY_CH";
 		}
 
 		std::cerr << "Unknown fileformat: " << static_cast<int>(format) << "\n";
@@ -131,101 +191,100 @@ namespace chc {
 		return s;
 	}
 
-	void calcTimeMetric(OSMEdge& edge)
+	uint calcTravelTime(OSMEdge const& edge)
 	{
 		/* Stolen from ToureNPlaner */
 		if (edge.speed <= 0){
 			switch (edge.type) {
 				//motorway
 				case 1:
-					edge.dist = (edge.dist * 1.3) / 1.3;
-					break;
+					return (edge.dist * 1.3) / 1.3;
 					//motorway link
 				case 2:
-					edge.dist = (edge.dist * 1.3) / 1.0;
-					break;
+					return (edge.dist * 1.3) / 1.0;
 					//primary
 				case 3:
-					edge.dist = (edge.dist * 1.3) / 0.7;
-					break;
+					return (edge.dist * 1.3) / 0.7;
 					//primary link
 				case 4:
-					edge.dist = (edge.dist * 1.3) / 0.7;
-					break;
+					return (edge.dist * 1.3) / 0.7;
 					//secondary
 				case 5:
-					edge.dist = (edge.dist * 1.3) / 0.65;
-					break;
+					return (edge.dist * 1.3) / 0.65;
 					//secondary link
 				case 6:
-					edge.dist = (edge.dist * 1.3) / 0.65;
-					break;
+					return (edge.dist * 1.3) / 0.65;
 					//tertiary
 				case 7:
-					edge.dist = (edge.dist * 1.3) / 0.6;
-					break;
+					return (edge.dist * 1.3) / 0.6;
 					//tertiary link
 				case 8:
-					edge.dist = (edge.dist * 1.3) / 0.6;
-					break;
+					return (edge.dist * 1.3) / 0.6;
 					//trunk
 				case 9:
-					edge.dist = (edge.dist * 1.3) / 0.8;
-					break;
+					return (edge.dist * 1.3) / 0.8;
 					//trunk link
 				case 10:
-					edge.dist = (edge.dist * 1.3) / 0.8;
-					break;
+					return (edge.dist * 1.3) / 0.8;
 					//unclassified
 				case 11:
-					edge.dist = (edge.dist * 1.3) / 0.25;
-					break;
+					return (edge.dist * 1.3) / 0.25;
 					//residential
 				case 12:
-					edge.dist = (edge.dist * 1.3) / 0.45;
-					break;
+					return (edge.dist * 1.3) / 0.45;
 					//living street
 				case 13:
-					edge.dist = (edge.dist * 1.3) / 0.3;
-					break;
+					return (edge.dist * 1.3) / 0.3;
 					//road
 				case 14:
-					edge.dist = (edge.dist * 1.3) / 0.25;
-					break;
+					return (edge.dist * 1.3) / 0.25;
 					//service
 				case 15:
-					edge.dist = (edge.dist * 1.3) / 0.3;
-					break;
+					return (edge.dist * 1.3) / 0.3;
 					//turning circle
 				case 16:
-					edge.dist = (edge.dist * 1.3) / 0.3;
-					break;
+					return (edge.dist * 1.3) / 0.3;
 				default:
-					edge.dist = (edge.dist * 1.3) / 0.5;
+					return (edge.dist * 1.3) / 0.5;
 			}
 		} else {
-			edge.dist = (edge.dist * 1.3) / (((edge.speed > 130) ? 130.0 : (double) edge.speed)/100.0);
+			return (edge.dist * 1.3) / (((edge.speed > 130) ? 130.0 : (double) edge.speed)/100.0);
 		}
 	}
 
+	void calcTimeMetric(OSMEdge& edge)
+	{
+		edge.dist = calcTravelTime(edge);
+	}
+
 	template<>
-	void text_writeNode<OSMNode>(std::ostream& os, OSMNode const& node)
+	void text_formatNode<OSMNode>(TextBuffer& buffer, OSMNode const& node)
 	{
-		os << node.id << " " << node.osm_id << " " << node.lat << " "
-			<< node.lon << " " << node.elev << "\n";
+		buffer.append(node.id); buffer.append(' ');
+		buffer.append(node.osm_id); buffer.append(' ');
+		buffer.appendFixed(node.lat); buffer.append(' ');
+		buffer.appendFixed(node.lon); buffer.append(' ');
+		buffer.append(node.elev); buffer.append('\n');
 	}
 
 	template<>
-	void text_writeNode<CHNode<OSMNode>>(std::ostream& os, CHNode<OSMNode> const& node)
+	void text_formatNode<CHNode<OSMNode>>(TextBuffer& buffer, CHNode<OSMNode> const& node)
 	{
-		os << node.id << " " << node.osm_id << " " << node.lat << " "
-			<< node.lon << " " << node.elev << " " << node.lvl << "\n";
+		buffer.append(node.id); buffer.append(' ');
+		buffer.append(node.osm_id); buffer.append(' ');
+		buffer.appendFixed(node.lat); buffer.append(' ');
+		buffer.appendFixed(node.lon); buffer.append(' ');
+		buffer.append(node.elev); buffer.append(' ');
+		buffer.append(node.lvl); buffer.append('\n');
 	}
 
 	template<>
-	void text_writeNode<CHNode<StefanNode>>(std::ostream& os, CHNode<StefanNode> const& node)
+	void text_formatNode<CHNode<StefanNode>>(TextBuffer& buffer, CHNode<StefanNode> const& node)
 	{
-		os << node.lon << " " << node.lat << " " <<  node.lvl << " " << node.osm_id << "\n";
+		buffer.appendFixed(node.lon); buffer.append(' ');
+		buffer.appendFixed(node.lat); buffer.append(' ');
+		buffer.append(node.lvl); buffer.append(' ');
+		buffer.append(node.osm_id); buffer.append('\n');
 	}
 
 	template<>
@@ -244,9 +303,26 @@ namespace chc {
 	}
 
 	template<>
-	void text_writeNode<GeoNode>(std::ostream& os, GeoNode const& node)
+	CHNode<OSMNode> text_readNode<CHNode<OSMNode>>(std::istream& is, NodeID node_id)
 	{
-		os << node.lat << " " << node.lon << " " << node.elev << "\n";
+		return readLine(is, [node_id](std::istream& is) {
+			CHNode<OSMNode> node;
+			is >> node.id >> node.osm_id >> node.lat >> node.lon >> node.elev >> node.lvl;
+			if (node_id != c::NO_NID && node.id != node_id) {
+				std::cerr << "FATAL_ERROR: Invalid node id " << node.id << " at index " << node_id << ". Exiting\n";
+				text_writeNode(std::cerr, node);
+				std::abort();
+			}
+			return node;
+		});
+	}
+
+	template<>
+	void text_formatNode<GeoNode>(TextBuffer& buffer, GeoNode const& node)
+	{
+		buffer.appendFixed(node.lat); buffer.append(' ');
+		buffer.appendFixed(node.lon); buffer.append(' ');
+		buffer.append(node.elev); buffer.append('\n');
 	}
 
 	template<>
@@ -261,10 +337,13 @@ namespace chc {
 	}
 
 	template<>
-	void text_writeEdge<OSMEdge>(std::ostream& os, OSMEdge const& edge)
+	void text_formatEdge<OSMEdge>(TextBuffer& buffer, OSMEdge const& edge)
 	{
-		os << edge.src << " " << edge.tgt << " " << edge.dist << " "
-			<< edge.type << " " << edge.speed << "\n";
+		buffer.append(edge.src); buffer.append(' ');
+		buffer.append(edge.tgt); buffer.append(' ');
+		buffer.append(edge.dist); buffer.append(' ');
+		buffer.append(edge.type); buffer.append(' ');
+		buffer.append(edge.speed); buffer.append('\n');
 	}
 
 	template<>
@@ -331,9 +410,11 @@ namespace chc {
 	}
 
 	template<>
-	void text_writeEdge<Edge>(std::ostream& os, Edge const& edge)
+	void text_formatEdge<Edge>(TextBuffer& buffer, Edge const& edge)
 	{
-		os << edge.src << " " << edge.tgt << " " << edge.dist << "\n";
+		buffer.append(edge.src); buffer.append(' ');
+		buffer.append(edge.tgt); buffer.append(' ');
+		buffer.append(edge.dist); buffer.append('\n');
 	}
 
 	template<>
@@ -357,31 +438,165 @@ namespace chc {
 	}
 
 	template<>
-	void text_writeEdge<CHEdge<OSMEdge>>(std::ostream& os, CHEdge<OSMEdge> const& edge)
+	void text_formatEdge<CHEdge<OSMEdge>>(TextBuffer& buffer, CHEdge<OSMEdge> const& edge)
+	{
+		buffer.append(edge.src); buffer.append(' ');
+		buffer.append(edge.tgt); buffer.append(' ');
+		buffer.append(edge.dist); buffer.append(' ');
+		buffer.append(edge.type); buffer.append(' ');
+		buffer.append(edge.speed); buffer.append(' ');
+		formatChildEdges(buffer, edge);
+	}
+
+	template<>
+	CHEdge<OSMEdge> text_readEdge<CHEdge<OSMEdge>>(std::istream& is, EdgeID edge_id)
+	{
+		return readLine(is, [edge_id](std::istream& is) {
+			CHEdge<OSMEdge> edge;
+			long long child_edge1, child_edge2;
+
+			is >> edge.src >> edge.tgt >> edge.dist >> edge.type >> edge.speed >> child_edge1 >> child_edge2;
+			edge.id = edge_id;
+			/* center_node isn't stored; CHGraph::initCH restores it */
+			edge.child_edge1 = (child_edge1 < 0 ? c::NO_EID : EdgeID(child_edge1));
+			edge.child_edge2 = (child_edge2 < 0 ? c::NO_EID : EdgeID(child_edge2));
+			return edge;
+		});
+	}
+
+	template<>
+	void text_formatEdge<CHEdge<EuclOSMEdge>>(TextBuffer& buffer, CHEdge<EuclOSMEdge> const& edge)
+	{
+		buffer.append(edge.src); buffer.append(' ');
+		buffer.append(edge.tgt); buffer.append(' ');
+		buffer.append(edge.dist); buffer.append(' ');
+		buffer.append(edge.type); buffer.append(' ');
+		buffer.append(edge.eucl_dist); buffer.append(' ');
+		formatChildEdges(buffer, edge);
+	}
+
+	template<>
+	void text_formatEdge<CHEdge<StefanEdge>>(TextBuffer& buffer, CHEdge<StefanEdge> const& edge)
+	{
+		buffer.append(edge.src); buffer.append(' ');
+		buffer.append(edge.tgt); buffer.append(' ');
+		buffer.append(edge.dist); buffer.append(' ');
+		formatChildEdges(buffer, edge);
+	}
+
+
+	template<>
+	OSMNode scan_readNode<OSMNode>(TextScanner& scanner, NodeID node_id)
+	{
+		OSMNode node;
+		node.id = scanner.readUnsigned<NodeID>();
+		node.osm_id = scanner.readUnsigned<uint64_t>();
+		node.lat = scanner.readDouble();
+		node.lon = scanner.readDouble();
+		node.elev = scanner.readSigned<int>();
+		scanner.expectEndOfLine();
+		if (node_id != c::NO_NID && node.id != node_id) invalidNodeId(node.id, node_id);
+		return node;
+	}
+
+	template<>
+	CHNode<OSMNode> scan_readNode<CHNode<OSMNode>>(TextScanner& scanner, NodeID node_id)
 	{
-		os << edge.src << " " << edge.tgt << " " << edge.dist << " "
-			<< edge.type << " " << edge.speed << " "
-			<< (edge.child_edge1 == c::NO_EID ? "-1" : std::to_string(edge.child_edge1)) << " "
-			<< (edge.child_edge2 == c::NO_EID ? "-1" : std::to_string(edge.child_edge2)) << "\n";
+		CHNode<OSMNode> node;
+		node.id = scanner.readUnsigned<NodeID>();
+		node.osm_id = scanner.readUnsigned<uint64_t>();
+		node.lat = scanner.readDouble();
+		node.lon = scanner.readDouble();
+		node.elev = scanner.readSigned<int>();
+		node.lvl = scanner.readUnsigned<uint>();
+		scanner.expectEndOfLine();
+		if (node_id != c::NO_NID && node.id != node_id) invalidNodeId(node.id, node_id);
+		return node;
 	}
 
 	template<>
-	void text_writeEdge<CHEdge<EuclOSMEdge>>(std::ostream& os, CHEdge<EuclOSMEdge> const& edge)
+	GeoNode scan_readNode<GeoNode>(TextScanner& scanner, NodeID node_id)
 	{
-		os << edge.src << " " << edge.tgt << " " << edge.dist << " "
-			<< edge.type << " " << edge.eucl_dist << " "
-			<< (edge.child_edge1 == c::NO_EID ? "-1" : std::to_string(edge.child_edge1)) << " "
-			<< (edge.child_edge2 == c::NO_EID ? "-1" : std::to_string(edge.child_edge2)) << "\n";
+		GeoNode node;
+		node.id = node_id;
+		node.lat = scanner.readDouble();
+		node.lon = scanner.readDouble();
+		node.elev = scanner.readSigned<int>();
+		scanner.expectEndOfLine();
+		return node;
 	}
 
 	template<>
-	void text_writeEdge<CHEdge<StefanEdge>>(std::ostream& os, CHEdge<StefanEdge> const& edge)
+	OSMEdge scan_readEdge<OSMEdge>(TextScanner& scanner, EdgeID edge_id)
 	{
-		os << edge.src << " " << edge.tgt << " " << edge.dist << " "
-			<< (edge.child_edge1 == c::NO_EID ? "-1" : std::to_string(edge.child_edge1)) << " "
-			<< (edge.child_edge2 == c::NO_EID ? "-1" : std::to_string(edge.child_edge2)) << "\n";
+		OSMEdge edge;
+		edge.src = scanner.readUnsigned<NodeID>();
+		edge.tgt = scanner.readUnsigned<NodeID>();
+		scanDist(scanner, edge, edge_id);
+		edge.type = scanner.readUnsigned<uint>();
+		edge.speed = scanner.readSigned<int>();
+		scanner.expectEndOfLine();
+		calcTimeMetric(edge);
+		return edge;
 	}
 
+	template<>
+	EuclOSMEdge scan_readEdge<EuclOSMEdge>(TextScanner& scanner, EdgeID edge_id)
+	{
+		EuclOSMEdge edge;
+		edge.src = scanner.readUnsigned<NodeID>();
+		edge.tgt = scanner.readUnsigned<NodeID>();
+		scanDist(scanner, edge, edge_id);
+		edge.type = scanner.readUnsigned<uint>();
+		edge.speed = scanner.readSigned<int>();
+		scanner.expectEndOfLine();
+		edge.eucl_dist = edge.dist;
+		calcTimeMetric(edge);
+		return edge;
+	}
+
+	template<>
+	OSMDistEdge scan_readEdge<OSMDistEdge>(TextScanner& scanner, EdgeID edge_id)
+	{
+		OSMDistEdge edge;
+		edge.src = scanner.readUnsigned<NodeID>();
+		edge.tgt = scanner.readUnsigned<NodeID>();
+		scanDist(scanner, edge, edge_id);
+		edge.type = scanner.readUnsigned<uint>();
+		edge.speed = scanner.readSigned<int>();
+		scanner.expectEndOfLine();
+		return edge;
+	}
+
+	template<>
+	Edge scan_readEdge<Edge>(TextScanner& scanner, EdgeID edge_id)
+	{
+		Edge edge;
+		edge.src = scanner.readUnsigned<NodeID>();
+		edge.tgt = scanner.readUnsigned<NodeID>();
+		scanDist(scanner, edge, edge_id);
+		scanner.expectEndOfLine();
+		return edge;
+	}
+
+	template<>
+	CHEdge<OSMEdge> scan_readEdge<CHEdge<OSMEdge>>(TextScanner& scanner, EdgeID edge_id)
+	{
+		CHEdge<OSMEdge> edge;
+		edge.id = edge_id;
+		edge.src = scanner.readUnsigned<NodeID>();
+		edge.tgt = scanner.readUnsigned<NodeID>();
+		edge.dist = scanner.readUnsigned<uint>();
+		edge.type = scanner.readUnsigned<uint>();
+		edge.speed = scanner.readSigned<int>();
+		long long child_edge1(scanner.readSigned<long long>());
+		long long child_edge2(scanner.readSigned<long long>());
+		scanner.expectEndOfLine();
+		/* center_node isn't stored; CHGraph::initCH restores it */
+		edge.child_edge1 = (child_edge1 < 0 ? c::NO_EID : EdgeID(child_edge1));
+		edge.child_edge2 = (child_edge2 < 0 ? c::NO_EID : EdgeID(child_edge2));
+		return edge;
+	}
 
 	namespace FormatSTD {
 		void Reader_impl::readHeader(NodeID& estimated_nr_nodes, EdgeID& estimated_nr_edges,
@@ -400,6 +615,23 @@ namespace chc {
 			return text_readEdge<edge_type>(is, edge_id);
 		}
 
+		void ScanReader_impl::readHeader(NodeID& estimated_nr_nodes, EdgeID& estimated_nr_edges,
+				Metadata& meta_data)
+		{
+			estimated_nr_nodes = scanner.readUnsigned<NodeID>();
+			estimated_nr_edges = scanner.readUnsigned<EdgeID>();
+		}
+
+		auto ScanReader_impl::readNode(NodeID node_id) -> node_type
+		{
+			return scan_readNode<node_type>(scanner, node_id);
+		}
+
+		auto ScanReader_impl::readEdge(EdgeID edge_id) -> edge_type
+		{
+			return scan_readEdge<edge_type>(scanner, edge_id);
+		}
+
 		Writer_impl::Writer_impl(std::ostream& os) : os(os) {
 			os.precision(7);
 			os << std::fixed;
@@ -411,18 +643,18 @@ namespace chc {
 			os << nr_of_edges << "\n";
 		}
 
-		void Writer_impl::writeNode(node_type const& out, NodeID node_id)
+		void Writer_impl::formatNode(TextBuffer& buffer, node_type const& out, NodeID node_id) const
 		{
 			if (node_id != out.id) {
 				std::cerr << "FATAL_ERROR: Invalid node id " << out.id << " at index " << node_id << ". Exiting\n";
 				std::abort();
 			}
-			text_writeNode<node_type>(os, out);
+			text_formatNode<node_type>(buffer, out);
 		}
 
-		void Writer_impl::writeEdge(edge_type const& out, EdgeID)
+		void Writer_impl::formatEdge(TextBuffer& buffer, edge_type const& out, EdgeID) const
 		{
-			text_writeEdge<edge_type>(os, out);
+			text_formatEdge<edge_type>(buffer, out);
 		}
 	}
 
@@ -444,6 +676,23 @@ namespace chc {
 			return text_readEdge<edge_type>(is, edge_id);
 		}
 
+		void ScanReader_impl::readHeader(NodeID& estimated_nr_nodes, EdgeID& estimated_nr_edges,
+				Metadata& meta_data)
+		{
+			estimated_nr_nodes = scanner.readUnsigned<NodeID>();
+			estimated_nr_edges = scanner.readUnsigned<EdgeID>();
+		}
+
+		auto ScanReader_impl::readNode(NodeID node_id) -> node_type
+		{
+			return scan_readNode<node_type>(scanner, node_id);
+		}
+
+		auto ScanReader_impl::readEdge(EdgeID edge_id) -> edge_type
+		{
+			return scan_readEdge<edge_type>(scanner, edge_id);
+		}
+
 		Writer_impl::Writer_impl(std::ostream& os) : os(os) {
 			os.precision(7);
 			os << std::fixed;
@@ -455,14 +704,14 @@ namespace chc {
 			os << nr_of_edges << "\n";
 		}
 
-		void Writer_impl::writeNode(node_type const& out, NodeID)
+		void Writer_impl::formatNode(TextBuffer& buffer, node_type const& out, NodeID) const
 		{
-			text_writeNode<node_type>(os, out);
+			text_formatNode<node_type>(buffer, out);
 		}
 
-		void Writer_impl::writeEdge(edge_type const& out, EdgeID)
+		void Writer_impl::formatEdge(TextBuffer& buffer, edge_type const& out, EdgeID) const
 		{
-			text_writeEdge<edge_type>(os, out);
+			text_formatEdge<edge_type>(buffer, out);
 		}
 	}
 
@@ -473,30 +722,26 @@ namespace chc {
 			std::string line;
 			std::getline(is, line);
 			while (line != "") {
-				std::stringstream ss(line);
-				std::string hash;
-				std::string key;
-				std::string map;
-				std::string colon;
-				ss >> hash >> key >> colon >> map;
-
-				if (hash != "#") {
-					std::cout << "Error while parsing meta data: expected '#' instead of '"
-						<< hash << "'\n";
-				}
-				if (colon != ":") {
-					std::cout << "Error while parsing meta data: expected ':' instead of '"
-						<< colon << "'\n";
-				}
-
-				meta_data[key] = map;
-
+				parseMetaDataLine(line, meta_data);
 				std::getline(is, line);
 			}
 
 			is >> estimated_nr_nodes >> estimated_nr_edges;
 		}
 
+		void ScanReader_impl::readHeader(NodeID& estimated_nr_nodes, EdgeID& estimated_nr_edges,
+				Metadata& meta_data)
+		{
+			std::string line(scanner.readLine());
+			while (line != "") {
+				parseMetaDataLine(line, meta_data);
+				line = scanner.readLine();
+			}
+
+			estimated_nr_nodes = scanner.readUnsigned<NodeID>();
+			estimated_nr_edges = scanner.readUnsigned<EdgeID>();
+		}
+
 		Writer_impl::Writer_impl(std::ostream& os) : FormatSTD::Writer_impl(os) {
 			os.precision(7);
 			os << std::fixed;
@@ -524,6 +769,11 @@ namespace chc {
 		{
 			return text_readEdge<edge_type>(is, edge_id);
 		}
+
+		auto ScanReader_impl::readEdge(EdgeID edge_id) -> edge_type
+		{
+			return scan_readEdge<edge_type>(scanner, edge_id);
+		}
 	}
 
 	namespace FormatFMI_EUCL {
@@ -531,9 +781,34 @@ namespace chc {
 		{
 			return text_readEdge<edge_type>(is, edge_id);
 		}
+
+		auto ScanReader_impl::readEdge(EdgeID edge_id) -> edge_type
+		{
+			return scan_readEdge<edge_type>(scanner, edge_id);
+		}
 	}
 
 	namespace FormatFMI_CH {
+		auto Reader_impl::readNode(NodeID node_id) -> node_type
+		{
+			return text_readNode<node_type>(is, node_id);
+		}
+
+		auto Reader_impl::readEdge(EdgeID edge_id) -> edge_type
+		{
+			return text_readEdge<edge_type>(is, edge_id);
+		}
+
+		auto ScanReader_impl::readNode(NodeID node_id) -> node_type
+		{
+			return scan_readNode<node_type>(scanner, node_id);
+		}
+
+		auto ScanReader_impl::readEdge(EdgeID edge_id) -> edge_type
+		{
+			return scan_readEdge<edge_type>(scanner, edge_id);
+		}
+
 		Writer_impl::Writer_impl(std::ostream& os) : FormatSTD::Writer_impl(os) {
 			os.precision(7);
 			os << std::fixed;
@@ -555,21 +830,21 @@ namespace chc {
 			os << nr_of_edges << "\n";
 		}
 
-		void Writer_impl::writeNode(node_type const& out, NodeID)
+		void Writer_impl::formatNode(TextBuffer& buffer, node_type const& out, NodeID) const
 		{
-			text_writeNode<node_type>(os, out);
+			text_formatNode<node_type>(buffer, out);
 		}
 
-		void Writer_impl::writeEdge(edge_type const& out, EdgeID)
+		void Writer_impl::formatEdge(TextBuffer& buffer, edge_type const& out, EdgeID) const
 		{
-			text_writeEdge<edge_type>(os, out);
+			text_formatEdge<edge_type>(buffer, out);
 		}
 	}
 
 	namespace FormatFMI_EUCL_CH {
-		void Writer_impl::writeEdge(edge_type const& out, EdgeID)
+		void Writer_impl::formatEdge(TextBuffer& buffer, edge_type const& out, EdgeID) const
 		{
-			text_writeEdge<edge_type>(os, out);
+			text_formatEdge<edge_type>(buffer, out);
 		}
 	}
 
@@ -579,14 +854,14 @@ namespace chc {
 			os << std::fixed;
 		}
 
-		void Writer_impl::writeNode(node_type const& out, NodeID)
+		void Writer_impl::formatNode(TextBuffer& buffer, node_type const& out, NodeID) const
 		{
-			text_writeNode<node_type>(os, out);
+			text_formatNode<node_type>(buffer, out);
 		}
 
-		void Writer_impl::writeEdge(edge_type const& out, EdgeID)
+		void Writer_impl::formatEdge(TextBuffer& buffer, edge_type const& out, EdgeID) const
 		{
-			text_writeEdge<edge_type>(os, out);
+			text_formatEdge<edge_type>(buffer, out);
 		}
 	}
 }
@@ -1,29 +1,54 @@
 #pragma once
 
 #include "file_formats_helper.h"
+#include "binary_ch.h"
+#include "graph_snapshot.h"
 
 namespace chc {
 	// "default" text serialization of some nodes and edge types,
 	// used in the the formats below
 	template<typename NodeT>
-	void text_writeNode(std::ostream& os, NodeT const& node);
-	template<> void text_writeNode<OSMNode>(std::ostream& os, OSMNode const& node);
-	template<> void text_writeNode<GeoNode>(std::ostream& os, GeoNode const& node);
-	template<> void text_writeNode<CHNode<OSMNode>>(std::ostream& os, CHNode<OSMNode> const& node);
-	template<> void text_writeNode<CHNode<StefanNode>>(std::ostream& os, CHNode<StefanNode> const& node);
+	void text_formatNode(TextBuffer& buffer, NodeT const& node);
+	template<> void text_formatNode<OSMNode>(TextBuffer& buffer, OSMNode const& node);
+	template<> void text_formatNode<GeoNode>(TextBuffer& buffer, GeoNode const& node);
+	template<> void text_formatNode<CHNode<OSMNode>>(TextBuffer& buffer, CHNode<OSMNode> const& node);
+	template<> void text_formatNode<CHNode<StefanNode>>(TextBuffer& buffer, CHNode<StefanNode> const& node);
+
+	template<typename NodeT>
+	void text_writeNode(std::ostream& os, NodeT const& node)
+	{
+		TextBuffer buffer;
+		text_formatNode<NodeT>(buffer, node);
+		buffer.writeTo(os);
+	}
 
 	template<typename NodeT>
 	NodeT text_readNode(std::istream& is, NodeID node_id = c::NO_NID);
 	template<> OSMNode text_readNode<OSMNode>(std::istream& is, NodeID node_id);
 	template<> GeoNode text_readNode<GeoNode>(std::istream& is, NodeID node_id);
+	template<> CHNode<OSMNode> text_readNode<CHNode<OSMNode>>(std::istream& is, NodeID node_id);
+
+	template<typename NodeT>
+	NodeT scan_readNode(TextScanner& scanner, NodeID node_id = c::NO_NID);
+	template<> OSMNode scan_readNode<OSMNode>(TextScanner& scanner, NodeID node_id);
+	template<> GeoNode scan_readNode<GeoNode>(TextScanner& scanner, NodeID node_id);
+	template<> CHNode<OSMNode> scan_readNode<CHNode<OSMNode>>(TextScanner& scanner, NodeID node_id);
+
+	template<typename EdgeT>
+	void text_formatEdge(TextBuffer& buffer, EdgeT const& edge);
+	template<> void text_formatEdge<OSMEdge>(TextBuffer& buffer, OSMEdge const& edge);
+	template<> void text_formatEdge<Edge>(TextBuffer& buffer, Edge const& edge);
+	template<> void text_formatEdge<CHEdge<OSMEdge>>(TextBuffer& buffer, CHEdge<OSMEdge> const& edge);
+	template<> void text_formatEdge<CHEdge<EuclOSMEdge>>(TextBuffer& buffer, CHEdge<EuclOSMEdge> const& edge);
+	template<> void text_formatEdge<CHEdge<StefanEdge>>(TextBuffer& buffer, CHEdge<StefanEdge> const& edge);
 
 	template<typename EdgeT>
-	void text_writeEdge(std::ostream& os, EdgeT const& edge);
-	template<> void text_writeEdge<OSMEdge>(std::ostream& os, OSMEdge const& edge);
-	template<> void text_writeEdge<Edge>(std::ostream& os, Edge const& edge);
-	template<> void text_writeEdge<CHEdge<OSMEdge>>(std::ostream& os, CHEdge<OSMEdge> const& edge);
-	template<> void text_writeEdge<CHEdge<EuclOSMEdge>>(std::ostream& os, CHEdge<EuclOSMEdge> const& edge);
-	template<> void text_writeEdge<CHEdge<StefanEdge>>(std::ostream& os, CHEdge<StefanEdge> const& edge);
+	void text_writeEdge(std::ostream& os, EdgeT const& edge)
+	{
+		TextBuffer buffer;
+		text_formatEdge<EdgeT>(buffer, edge);
+		buffer.writeTo(os);
+	}
 
 	template<typename EdgeT>
 	EdgeT text_readEdge(std::istream& is, EdgeID edge_id = c::NO_EID);
@@ -31,6 +56,15 @@ namespace chc {
 	template<> EuclOSMEdge text_readEdge<EuclOSMEdge>(std::istream& is, EdgeID edge_id);
 	template<> OSMDistEdge text_readEdge<OSMDistEdge>(std::istream& is, EdgeID edge_id);
 	template<> Edge text_readEdge<Edge>(std::istream& is, EdgeID edge_id);
+	template<> CHEdge<OSMEdge> text_readEdge<CHEdge<OSMEdge>>(std::istream& is, EdgeID edge_id);
+
+	template<typename EdgeT>
+	EdgeT scan_readEdge(TextScanner& scanner, EdgeID edge_id = c::NO_EID);
+	template<> OSMEdge scan_readEdge<OSMEdge>(TextScanner& scanner, EdgeID edge_id);
+	template<> EuclOSMEdge scan_readEdge<EuclOSMEdge>(TextScanner& scanner, EdgeID edge_id);
+	template<> OSMDistEdge scan_readEdge<OSMDistEdge>(TextScanner& scanner, EdgeID edge_id);
+	template<> Edge scan_readEdge<Edge>(TextScanner& scanner, EdgeID edge_id);
+	template<> CHEdge<OSMEdge> scan_readEdge<CHEdge<OSMEdge>>(TextScanner& scanner, EdgeID edge_id);
 
 	namespace FormatSTD
 	{
@@ -47,14 +81,26 @@ namespace chc {
 		protected:
 			std::istream& is;
 		};
-		typedef SimpleReader<Reader_impl> Reader;
+		typedef SimpleReader<Reader_impl> StreamReader;
+
+		struct ScanReader_impl
+		{
+			ScanReader_impl(TextScanner& scanner) : scanner(scanner) { }
+			void readHeader(NodeID& estimated_nr_nodes, EdgeID& estimated_nr_edges,
+					Metadata& meta_data);
+			node_type readNode(NodeID node_id);
+			edge_type readEdge(EdgeID edge_id);
+		protected:
+			TextScanner& scanner;
+		};
+		typedef ScanReader<ScanReader_impl> Reader;
 
 		struct Writer_impl
 		{
 			Writer_impl(std::ostream& os);
 			void writeHeader(NodeID nr_of_nodes, EdgeID nr_of_edges, Metadata const& meta_data);
-			void writeNode(node_type const& out, NodeID node_id);
-			void writeEdge(edge_type const& out, EdgeID edge_id);
+			void formatNode(TextBuffer& buffer, node_type const& out, NodeID node_id) const;
+			void formatEdge(TextBuffer& buffer, edge_type const& out, EdgeID edge_id) const;
 		protected:
 			std::ostream& os;
 		};
@@ -77,15 +123,27 @@ namespace chc {
 		protected:
 			std::istream& is;
 		};
-		typedef SimpleReader<Reader_impl> Reader;
+		typedef SimpleReader<Reader_impl> StreamReader;
+
+		struct ScanReader_impl
+		{
+			ScanReader_impl(TextScanner& scanner) : scanner(scanner) { }
+			void readHeader(NodeID& estimated_nr_nodes, EdgeID& estimated_nr_edges,
+					Metadata& meta_data);
+			node_type readNode(NodeID node_id);
+			edge_type readEdge(EdgeID edge_id);
+		protected:
+			TextScanner& scanner;
+		};
+		typedef ScanReader<ScanReader_impl> Reader;
 
 		struct Writer_impl
 		{
 		public:
 			Writer_impl(std::ostream& os);
 			void writeHeader(NodeID nr_of_nodes, EdgeID nr_of_edges, Metadata const& meta_data);
-			void writeNode(node_type const& out, NodeID node_id);
-			void writeEdge(edge_type const& out, EdgeID edge_id);
+			void formatNode(TextBuffer& buffer, node_type const& out, NodeID node_id) const;
+			void formatEdge(TextBuffer& buffer, edge_type const& out, EdgeID edge_id) const;
 		protected:
 			std::ostream& os;
 		};
@@ -104,7 +162,15 @@ namespace chc {
 			void readHeader(NodeID& estimated_nr_nodes, EdgeID& estimated_nr_edges,
 					Metadata& meta_data);
 		};
-		typedef SimpleReader<Reader_impl> Reader;
+		typedef SimpleReader<Reader_impl> StreamReader;
+
+		struct ScanReader_impl : public FormatSTD::ScanReader_impl
+		{
+			ScanReader_impl(TextScanner& scanner) : FormatSTD::ScanReader_impl(scanner) { }
+			void readHeader(NodeID& estimated_nr_nodes, EdgeID& estimated_nr_edges,
+					Metadata& meta_data);
+		};
+		typedef ScanReader<ScanReader_impl> Reader;
 
 		struct Writer_impl : public FormatSTD::Writer_impl
 		{
@@ -124,7 +190,14 @@ namespace chc {
 			edge_type readEdge(EdgeID edge_id);
 			Reader_impl(std::istream& is) : FormatFMI::Reader_impl(is) { }
 		};
-		typedef SimpleReader<Reader_impl> Reader;
+		typedef SimpleReader<Reader_impl> StreamReader;
+
+		struct ScanReader_impl : public FormatFMI::ScanReader_impl
+		{
+			edge_type readEdge(EdgeID edge_id);
+			ScanReader_impl(TextScanner& scanner) : FormatFMI::ScanReader_impl(scanner) { }
+		};
+		typedef ScanReader<ScanReader_impl> Reader;
 	}
 
 	namespace FormatFMI_EUCL
@@ -137,7 +210,14 @@ namespace chc {
 			edge_type readEdge(EdgeID edge_id);
 			Reader_impl(std::istream& is) : FormatFMI::Reader_impl(is) { }
 		};
-		typedef SimpleReader<Reader_impl> Reader;
+		typedef SimpleReader<Reader_impl> StreamReader;
+
+		struct ScanReader_impl : public FormatFMI::ScanReader_impl
+		{
+			edge_type readEdge(EdgeID edge_id);
+			ScanReader_impl(TextScanner& scanner) : FormatFMI::ScanReader_impl(scanner) { }
+		};
+		typedef ScanReader<ScanReader_impl> Reader;
 	}
 
 	namespace FormatFMI_CH
@@ -145,13 +225,30 @@ namespace chc {
 		typedef CHNode<OSMNode> node_type;
 		typedef CHEdge<OSMEdge> edge_type;
 
+		/* header is the same as in FormatFMI */
+		struct Reader_impl : public FormatFMI::Reader_impl
+		{
+			Reader_impl(std::istream& is) : FormatFMI::Reader_impl(is) { }
+			node_type readNode(NodeID node_id);
+			edge_type readEdge(EdgeID edge_id);
+		};
+		typedef SimpleReader<Reader_impl> StreamReader;
+
+		struct ScanReader_impl : public FormatFMI::ScanReader_impl
+		{
+			ScanReader_impl(TextScanner& scanner) : FormatFMI::ScanReader_impl(scanner) { }
+			node_type readNode(NodeID node_id);
+			edge_type readEdge(EdgeID edge_id);
+		};
+		typedef ScanReader<ScanReader_impl> Reader;
+
 		struct Writer_impl : public FormatSTD::Writer_impl
 		{
 		public:
 			Writer_impl(std::ostream& os);
 			void writeHeader(NodeID nr_of_nodes, EdgeID nr_of_edges, Metadata const& meta_data);
-			void writeNode(node_type const& out, NodeID node_id);
-			void writeEdge(edge_type const& out, EdgeID edge_id);
+			void formatNode(TextBuffer& buffer, node_type const& out, NodeID node_id) const;
+			void formatEdge(TextBuffer& buffer, edge_type const& out, EdgeID edge_id) const;
 		};
 		typedef SimpleWriter<Writer_impl> Writer;
 	}
@@ -165,7 +262,7 @@ namespace chc {
 		{
 		public:
 			Writer_impl(std::ostream& os) : FormatFMI_CH::Writer_impl(os) { }
-			void writeEdge(edge_type const& out, EdgeID edge_id);
+			void formatEdge(TextBuffer& buffer, edge_type const& out, EdgeID edge_id) const;
 		};
 		typedef SimpleWriter<Writer_impl> Writer;
 	}
@@ -179,16 +276,26 @@ namespace chc {
 		{
 		public:
 			Writer_impl(std::ostream& os);
-			void writeNode(node_type const& out, NodeID node_id);
-			void writeEdge(edge_type const& out, EdgeID edge_id);
+			void formatNode(TextBuffer& buffer, node_type const& out, NodeID node_id) const;
+			void formatEdge(TextBuffer& buffer, edge_type const& out, EdgeID edge_id) const;
 		};
 		typedef SimpleWriter<Writer_impl> Writer;
 	}
 
 
 
-	enum class FileFormat { STD, SIMPLE, FMI, FMI_DIST, FMI_EUCL, FMI_CH, FMI_EUCL_CH, STEFAN_CH };
-	static constexpr FileFormat LastFileFormat = FileFormat::STEFAN_CH;
+	/* child edges reference other edges by their position in the file */
+	template<>
+	struct keeps_edge_ids<FormatFMI_CH::Reader_impl> : std::true_type { };
+	template<>
+	struct keeps_edge_ids<FormatFMI_CH::ScanReader_impl> : std::true_type { };
+
+	/* travel time of an edge from its distance, type and speed; the formats
+	 * with OSMEdge (STD, FMI) read it as the edge distance */
+	uint calcTravelTime(OSMEdge const& edge);
+
+	enum class FileFormat { STD, SIMPLE, FMI, FMI_DIST, FMI_EUCL, FMI_CH, FMI_EUCL_CH, STEFAN_CH, BINARY_CH };
+	static constexpr FileFormat LastFileFormat = FileFormat::BINARY_CH;
 
 	FileFormat toFileFormat(std::string const& format);
 	std::string to_string(FileFormat format);
@@ -210,11 +317,13 @@ namespace chc {
 		case FileFormat::FMI_EUCL:
 			return FormatFMI_EUCL::Reader::readGraph<Node, Edge>(filename);
 		case FileFormat::FMI_CH:
-			break;
+			return FormatFMI_CH::Reader::readGraph<Node, Edge>(filename);
 		case FileFormat::FMI_EUCL_CH:
 			break;
 		case FileFormat::STEFAN_CH:
 			break;
+		case FileFormat::BINARY_CH:
+			return FormatBINARY_CH::Reader::readGraph<Node, Edge>(filename);
 		}
 		std::cerr << "Unknown input fileformat!" << std::endl;
 		std::exit(1);
@@ -241,28 +350,40 @@ namespace chc {
 			break;
 		case FileFormat::STEFAN_CH:
 			break;
+		case FileFormat::BINARY_CH:
+			break;
 		}
 		std::cerr << "Unknown input fileformat!" << std::endl;
 		std::exit(1);
 	}
 
+	/* readGraph, but reuses / stores a binary snapshot in cache_dir (see graph_snapshot.h) unless cache_dir is empty */
+	template<typename Node, typename Edge>
+	inline GraphInData<Node, Edge> readGraph(FileFormat format, std::string const& filename, std::string const& cache_dir)
+	{
+		if (cache_dir.empty()) return readGraph<Node, Edge>(format, filename);
+		return readGraphCached<Node, Edge>(filename, to_string(format), cache_dir, [format, &filename] {
+			return readGraph<Node, Edge>(format, filename);
+		});
+	}
+
 	/* try to read with types suitable to be written with Writer; strip CHNode<>, but apply CHEdge<> */
 	template<typename Writer>
-	inline GraphInData<typename MakeCHNode<typename Writer::node_type>::base_node_type, MakeCHEdge<typename Writer::edge_type>> readGraphForWriter(FileFormat format, std::string const& filename)
+	inline GraphInData<typename MakeCHNode<typename Writer::node_type>::base_node_type, MakeCHEdge<typename Writer::edge_type>> readGraphForWriter(FileFormat format, std::string const& filename, std::string const& cache_dir = "")
 	{
-		return readGraph<typename MakeCHNode<typename Writer::node_type>::base_node_type, MakeCHEdge<typename Writer::edge_type>>(format, filename);
+		return readGraph<typename MakeCHNode<typename Writer::node_type>::base_node_type, MakeCHEdge<typename Writer::edge_type>>(format, filename, cache_dir);
 	}
 
 	/* run callable with types suitable to be written with Writer for write_format; strip CHNode<>, but apply CHEdge<> */
 	template<typename Callable>
-	inline void readGraphForWriteFormat(FileFormat write_format, FileFormat read_format, std::string const& filename, Callable&& callable)
+	inline void readGraphForWriteFormat(FileFormat write_format, FileFormat read_format, std::string const& filename, Callable&& callable, std::string const& cache_dir = "")
 	{
 		switch (write_format) {
 		case FileFormat::STD:
-			callable(readGraphForWriter<FormatSTD::Writer>(read_format, filename));
+			callable(readGraphForWriter<FormatSTD::Writer>(read_format, filename, cache_dir));
 			return;
 		case FileFormat::SIMPLE:
-			callable(readGraphForWriter<FormatSimple::Writer>(read_format, filename));
+			callable(readGraphForWriter<FormatSimple::Writer>(read_format, filename, cache_dir));
 			return;
 		case FileFormat::FMI:
 			break;
@@ -271,23 +392,32 @@ namespace chc {
 		case FileFormat::FMI_EUCL:
 			break;
 		case FileFormat::FMI_CH:
-			callable(readGraphForWriter<FormatFMI_CH::Writer>(read_format, filename));
+			callable(readGraphForWriter<FormatFMI_CH::Writer>(read_format, filename, cache_dir));
 			return;
 		case FileFormat::FMI_EUCL_CH:
-			callable(readGraphForWriter<FormatFMI_EUCL_CH::Writer>(read_format, filename));
+			callable(readGraphForWriter<FormatFMI_EUCL_CH::Writer>(read_format, filename, cache_dir));
 			return;
 		case FileFormat::STEFAN_CH:
-			callable(readGraphForWriter<FormatSTEFAN_CH::Writer>(read_format, filename));
+			callable(readGraphForWriter<FormatSTEFAN_CH::Writer>(read_format, filename, cache_dir));
+			return;
+		case FileFormat::BINARY_CH:
+			callable(readGraphForWriter<FormatBINARY_CH::Writer>(read_format, filename, cache_dir));
 			return;
 		}
 		std::cerr << "Unknown output fileformat!" << std::endl;
 		std::exit(1);
 	}
 
+	/*
+	 * Writes the header and the nodes, then calls wait_for_edges() and writes
+	 * the nr_of_edges edges of data. So data.edges may still be produced by
+	 * another thread (see CHGraph::getExportData) while the nodes are written.
+	 */
 	template<typename Writer, typename NodeT, typename EdgeT>
-	inline void writeCHGraphFile(std::string const& filename, GraphCHOutData<NodeT, EdgeT> const& data)
+	inline void writeCHGraphFile(std::string const& filename, GraphCHOutData<NodeT, EdgeT> const& data,
+			EdgeID nr_of_edges, std::function<void()> const& wait_for_edges)
 	{
-		std::ofstream os(filename.c_str());
+		std::ofstream os(filename.c_str(), std::ios::binary);
 
 		if (!os.is_open()) {
 			std::cerr << "FATAL_ERROR: Couldn't open graph file \'" <<
@@ -296,19 +426,26 @@ namespace chc {
 		}
 
 		Print("Exporting to " << filename);
-		Writer::writeCHGraph(os, data);
+		Writer::writeCHGraph(os, data, nr_of_edges, wait_for_edges);
 		os.close();
 	}
 
+	template<typename Writer, typename NodeT, typename EdgeT>
+	inline void writeCHGraphFile(std::string const& filename, GraphCHOutData<NodeT, EdgeT> const& data)
+	{
+		writeCHGraphFile<Writer>(filename, data, data.edges.size(), [] { });
+	}
+
 	template<typename NodeT, typename EdgeT>
-	inline void writeCHGraphFile(FileFormat format, std::string const& filename, GraphCHOutData<NodeT, EdgeT> const& data)
+	inline void writeCHGraphFile(FileFormat format, std::string const& filename, GraphCHOutData<NodeT, EdgeT> const& data,
+			EdgeID nr_of_edges, std::function<void()> const& wait_for_edges)
 	{
 		switch (format) {
 		case FileFormat::STD:
-			writeCHGraphFile<FormatSTD::Writer>(filename, data);
+			writeCHGraphFile<FormatSTD::Writer>(filename, data, nr_of_edges, wait_for_edges);
 			return;
 		case FileFormat::SIMPLE:
-			writeCHGraphFile<FormatSimple::Writer>(filename, data);
+			writeCHGraphFile<FormatSimple::Writer>(filename, data, nr_of_edges, wait_for_edges);
 			return;
 		case FileFormat::FMI:
 			break;
@@ -317,19 +454,28 @@ namespace chc {
 		case FileFormat::FMI_EUCL:
 			break;
 		case FileFormat::FMI_CH:
-			writeCHGraphFile<FormatFMI_CH::Writer>(filename, data);
+			writeCHGraphFile<FormatFMI_CH::Writer>(filename, data, nr_of_edges, wait_for_edges);
 			return;
 		case FileFormat::FMI_EUCL_CH:
-			writeCHGraphFile<FormatFMI_EUCL_CH::Writer>(filename, data);
+			writeCHGraphFile<FormatFMI_EUCL_CH::Writer>(filename, data, nr_of_edges, wait_for_edges);
 			return;
 		case FileFormat::STEFAN_CH:
-			writeCHGraphFile<FormatSTEFAN_CH::Writer>(filename, data);
+			writeCHGraphFile<FormatSTEFAN_CH::Writer>(filename, data, nr_of_edges, wait_for_edges);
+			return;
+		case FileFormat::BINARY_CH:
+			writeCHGraphFile<FormatBINARY_CH::Writer>(filename, data, nr_of_edges, wait_for_edges);
 			return;
 		}
 		std::cerr << "Unknown output fileformat!" << std::endl;
 		std::exit(1);
 	}
 
+	template<typename NodeT, typename EdgeT>
+	inline void writeCHGraphFile(FileFormat format, std::string const& filename, GraphCHOutData<NodeT, EdgeT> const& data)
+	{
+		writeCHGraphFile(format, filename, data, data.edges.size(), [] { });
+	}
+
 	template<typename Writer, typename NodeT, typename EdgeT>
 	inline void writeGraphFile(std::string const& filename, GraphOutData<NodeT, EdgeT> const& data)
 	{
@@ -372,6 +518,8 @@ namespace chc {
 		case FileFormat::STEFAN_CH:
 			writeGraphFile<FormatSTEFAN_CH::Writer>(filename, data);
 			return;
+		case FileFormat::BINARY_CH:
+			break;
 		}
 		std::cerr << "Unknown output fileformat!" << std::endl;
 		std::exit(1);
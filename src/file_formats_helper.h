@@ -2,8 +2,17 @@
 
 #include "nodes_and_edges.h"
 #include "function_traits.h"
+#include "mapped_file.h"
+#include "text_scanner.h"
+#include "parallel_algorithms.h"
+#include "text_buffer.h"
+#include "bounded_queue.h"
 
 #include <algorithm>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <omp.h>
 
 namespace chc {
 	template<typename Writer, typename NodeT, typename EdgeT>
@@ -18,6 +27,244 @@ namespace chc {
 	};
 
 
+	/* readers of formats which reference edges by id (like the child edges
+	 * of CH formats) must not drop, reorder or renumber any edges */
+	template<typename Implementation>
+	struct keeps_edge_ids : std::false_type { };
+
+	/* reads nodes and edges through impl, drops loops and invalid edges
+	 * and removes duplicate edges */
+	template<typename Implementation, typename NodeT, typename EdgeT>
+	GraphInData<NodeT, EdgeT> readGraphData(Implementation& impl)
+	{
+		NodeID nr_of_nodes = 0;
+		EdgeID nr_of_edges = 0;
+		GraphInData<NodeT, EdgeT> result;
+		impl.readHeader(nr_of_nodes, nr_of_edges, result.meta_data);
+
+		result.nodes.reserve(nr_of_nodes);
+		result.edges.reserve(nr_of_edges);
+
+		Print("Number of nodes: " << nr_of_nodes);
+		Print("Number of edges: " << nr_of_edges);
+
+		for (NodeID i = 0; i < nr_of_nodes; ++i) {
+			result.nodes.push_back(static_cast<NodeT>(impl.readNode((NodeID) i)));
+		}
+		Print("Read all the nodes.");
+
+		for (EdgeID i = 0; i < nr_of_edges; ++i) {
+			auto edge = static_cast<EdgeT>(impl.readEdge((EdgeID) i));
+			if (keeps_edge_ids<Implementation>::value && (edge.src == edge.tgt || edge.id == c::NO_EID)) {
+				std::cerr << "FATAL_ERROR: input contained loop or invalid edge (@" << i << "). Exiting.\n";
+				std::abort();
+			}
+			else if (edge.src == edge.tgt) {
+				std::cerr << "WARNING: input contained loop edge (@" << i << "), dropped edge.\n";
+				--i; --nr_of_edges;
+				continue;
+			}
+			else if (edge.id == c::NO_EID) {
+				std::cerr << "WARNING: input contained edge with invalid id (@" << i << "), dropped edge.\n";
+				--i; --nr_of_edges;
+				continue;
+			}
+
+			result.edges.push_back(std::move(edge));
+		}
+		Print("Read all the edges.");
+
+		if (keeps_edge_ids<Implementation>::value) return result;
+
+		auto size_before(result.edges.size());
+		std::sort(result.edges.begin(), result.edges.end(), EdgeSortSrcTgtDist<EdgeT>());
+		result.edges.erase(std::unique(result.edges.begin(), result.edges.end(),
+			equalEndpoints<EdgeT,EdgeT>), result.edges.end());
+		auto size_diff(size_before - result.edges.size());
+
+		if (size_diff) {
+			// reset IDs
+			for (EdgeID i(0); i<result.edges.size(); i++) {
+				result.edges[i].id = i;
+			}
+			std::cerr << "Removed " << size_diff << " duplicate edge(s) and updated edge IDs.\n";
+		}
+		Print("Checked for duplicates.");
+
+		return result;
+	}
+
+	/* a line aligned part of the input and the index of its first record */
+	struct TextChunk
+	{
+		char const* begin;
+		char const* end;
+		size_t first_record;
+		size_t nr_of_records;
+	};
+
+	/*
+	 * Like readGraphData, but pipelined: a reader thread splits the text after
+	 * the header into line aligned chunks and counts their records (which also
+	 * pages a memory mapped input in ahead of the parsers). The chunks are
+	 * passed through a bounded queue to the parser threads, which parse them
+	 * directly into the pre-sized vectors (every chunk with its own
+	 * Implementation), flag loops and invalid edges and sort the edges of
+	 * their chunk. What's left after the last chunk is removing the flagged
+	 * edges, merging the sorted runs and removing duplicates.
+	 *
+	 * Every record has to be on its own line. Relies on the readers setting
+	 * the id of every valid edge to its index in the input.
+	 */
+	template<typename Implementation, typename NodeT, typename EdgeT>
+	GraphInData<NodeT, EdgeT> readGraphDataParallel(TextScanner& scanner)
+	{
+		/* chunks per thread, for load balancing; bounds for the chunk size */
+		size_t const CHUNKS_PER_THREAD(4);
+		size_t const MIN_CHUNK_SIZE(1 << 14);
+		size_t const MAX_CHUNK_SIZE(1 << 22);
+
+		NodeID nr_of_nodes = 0;
+		EdgeID nr_of_edges = 0;
+		GraphInData<NodeT, EdgeT> result;
+		{
+			Implementation impl(scanner);
+			impl.readHeader(nr_of_nodes, nr_of_edges, result.meta_data);
+		}
+
+		Print("Number of nodes: " << nr_of_nodes);
+		Print("Number of edges: " << nr_of_edges);
+
+		size_t const nr_of_records(size_t(nr_of_nodes) + nr_of_edges);
+		result.nodes.resize(nr_of_nodes);
+		result.edges.resize(nr_of_edges);
+		auto& edges(result.edges);
+
+		/* the OpenMP setting, which the tools set from --threads */
+		size_t const nr_of_threads(omp_get_max_threads());
+		size_t const chunk_size(std::min(MAX_CHUNK_SIZE, std::max(MIN_CHUNK_SIZE,
+				size_t(scanner.end() - scanner.pos()) / (nr_of_threads * CHUNKS_PER_THREAD))));
+
+		BoundedQueue<TextChunk> chunks(nr_of_threads * CHUNKS_PER_THREAD);
+		size_t nr_of_read_records(0);
+		std::thread reader([&] {
+			char const* pos(scanner.pos());
+			while (pos != scanner.end() && nr_of_read_records < nr_of_records) {
+				char const* end(pos + std::min(chunk_size, size_t(scanner.end() - pos)));
+				if (end != scanner.end()) {
+					end = static_cast<char const*>(std::memchr(end - 1, '\n', scanner.end() - end + 1));
+					end = (end ? end + 1 : scanner.end());
+				}
+				size_t const records(TextScanner::countRecords(pos, end));
+				chunks.push(TextChunk{pos, end, nr_of_read_records, records});
+				nr_of_read_records += records;
+				pos = end;
+			}
+			chunks.close();
+		});
+
+		/* edges [first, last) of a chunk, sorted if duplicates are removed */
+		std::vector<std::pair<EdgeID, EdgeID>> runs;
+		std::vector<EdgeID> loops, invalid;
+
+		#pragma omp parallel num_threads(nr_of_threads)
+		{
+			TextChunk chunk;
+			while (chunks.pop(chunk)) {
+				TextScanner chunk_scanner(scanner.begin(), chunk.begin, chunk.end);
+				Implementation impl(chunk_scanner);
+				size_t const last(std::min(chunk.first_record + chunk.nr_of_records, nr_of_records));
+				for (size_t record(chunk.first_record); record < last; ++record) {
+					if (record < nr_of_nodes) {
+						result.nodes[record] = static_cast<NodeT>(impl.readNode((NodeID) record));
+					}
+					else {
+						edges[record - nr_of_nodes] = static_cast<EdgeT>(impl.readEdge((EdgeID) (record - nr_of_nodes)));
+					}
+				}
+
+				EdgeID const first_edge(std::max(chunk.first_record, size_t(nr_of_nodes)) - nr_of_nodes);
+				EdgeID const last_edge(std::max(last, size_t(nr_of_nodes)) - nr_of_nodes);
+				std::vector<EdgeID> chunk_loops, chunk_invalid;
+				for (EdgeID i(first_edge); i < last_edge; i++) {
+					if (edges[i].src == edges[i].tgt) chunk_loops.push_back(i);
+					else if (edges[i].id == c::NO_EID) chunk_invalid.push_back(i);
+				}
+				if (!keeps_edge_ids<Implementation>::value) {
+					std::stable_sort(edges.begin() + first_edge, edges.begin() + last_edge, EdgeSortSrcTgtDist<EdgeT>());
+				}
+
+				#pragma omp critical
+				{
+					if (first_edge != last_edge) runs.emplace_back(first_edge, last_edge);
+					loops.insert(loops.end(), chunk_loops.begin(), chunk_loops.end());
+					invalid.insert(invalid.end(), chunk_invalid.begin(), chunk_invalid.end());
+				}
+			}
+		}
+		reader.join();
+
+		if (nr_of_read_records < nr_of_records) {
+			std::cerr << "FATAL_ERROR: end of file\n";
+			std::abort();
+		}
+		Print("Read all the nodes and edges.");
+
+		std::sort(runs.begin(), runs.end());
+		std::sort(loops.begin(), loops.end());
+		std::sort(invalid.begin(), invalid.end());
+		std::vector<EdgeID> dropped;
+		std::merge(loops.begin(), loops.end(), invalid.begin(), invalid.end(), std::back_inserter(dropped));
+
+		if (!dropped.empty()) {
+			if (keeps_edge_ids<Implementation>::value) {
+				std::cerr << "FATAL_ERROR: input contained loop or invalid edge (@" << dropped.front() << "). Exiting.\n";
+				std::abort();
+			}
+			for (auto i: loops) {
+				std::cerr << "WARNING: input contained loop edge (@" << i << "), dropped edge.\n";
+			}
+			for (auto i: invalid) {
+				std::cerr << "WARNING: input contained edge with invalid id (@" << i << "), dropped edge.\n";
+			}
+
+			parallelRemoveIf(edges, [&edges](size_t i) {
+				return edges[i].src == edges[i].tgt || edges[i].id == c::NO_EID;
+			});
+
+			/* ids are positions in the input without the dropped edges */
+			#pragma omp parallel for schedule(static)
+			for (EdgeID i = 0; i < edges.size(); i++) {
+				edges[i].id -= std::lower_bound(dropped.begin(), dropped.end(), edges[i].id) - dropped.begin();
+			}
+		}
+
+		if (keeps_edge_ids<Implementation>::value) return result;
+
+		/* the runs without the dropped edges */
+		std::vector<size_t> bounds(1, 0);
+		for (auto const& run: runs) {
+			bounds.push_back(run.second - (std::lower_bound(dropped.begin(), dropped.end(), run.second) - dropped.begin()));
+		}
+		parallelMergeRuns(edges, bounds, EdgeSortSrcTgtDist<EdgeT>());
+
+		auto size_diff(parallelRemoveIf(edges, [&edges](size_t i) {
+			return i > 0 && equalEndpoints(edges[i-1], edges[i]);
+		}));
+
+		if (size_diff) {
+			// reset IDs
+			#pragma omp parallel for schedule(static)
+			for (EdgeID i = 0; i < edges.size(); i++) {
+				edges[i].id = i;
+			}
+			std::cerr << "Removed " << size_diff << " duplicate edge(s) and updated edge IDs.\n";
+		}
+		Print("Checked for duplicates.");
+
+		return result;
+	}
+
 	template<typename Implementation>
 	struct SimpleReader
 	{
@@ -45,55 +292,7 @@ namespace chc {
 		static GraphInData<NodeT, EdgeT> readGraph(std::istream& is)
 		{
 			Implementation impl(is);
-			NodeID nr_of_nodes = 0;
-			EdgeID nr_of_edges = 0;
-			GraphInData<NodeT, EdgeT> result;
-			impl.readHeader(nr_of_nodes, nr_of_edges, result.meta_data);
-
-			result.nodes.reserve(nr_of_nodes);
-			result.edges.reserve(nr_of_edges);
-
-			Print("Number of nodes: " << nr_of_nodes);
-			Print("Number of edges: " << nr_of_edges);
-
-			for (NodeID i = 0; i < nr_of_nodes; ++i) {
-				result.nodes.push_back(static_cast<NodeT>(impl.readNode((NodeID) i)));
-			}
-			Print("Read all the nodes.");
-
-			for (EdgeID i = 0; i < nr_of_edges; ++i) {
-				auto edge = static_cast<EdgeT>(impl.readEdge((EdgeID) i));
-				if (edge.src == edge.tgt) {
-					std::cerr << "WARNING: input contained loop edge (@" << i << "), dropped edge.\n";
-					--i; --nr_of_edges;
-					continue;
-				}
-				else if (edge.id == c::NO_EID) {
-					std::cerr << "WARNING: input contained edge with invalid id (@" << i << "), dropped edge.\n";
-					--i; --nr_of_edges;
-					continue;
-				}
-
-				result.edges.push_back(std::move(edge));
-			}
-			Print("Read all the edges.");
-
-			auto size_before(result.edges.size());
-			std::sort(result.edges.begin(), result.edges.end(), EdgeSortSrcTgtDist<EdgeT>());
-			result.edges.erase(std::unique(result.edges.begin(), result.edges.end(),
-				equalEndpoints<EdgeT,EdgeT>), result.edges.end());
-			auto size_diff(size_before - result.edges.size());
-
-			if (size_diff) {
-				// reset IDs
-				for (EdgeID i(0); i<result.edges.size(); i++) {
-					result.edges[i].id = i;
-				}
-				std::cerr << "Removed " << size_diff << " duplicate edge(s) and updated edge IDs.\n";
-			}
-			Print("Checked for duplicates.");
-
-			return result;
+			return readGraphData<Implementation, NodeT, EdgeT>(impl);
 		}
 
 		template<typename NodeT = node_type, typename EdgeT = chedge_type>
@@ -109,12 +308,117 @@ namespace chc {
 		}
 	};
 
+	/*
+	 * Like SimpleReader, but the Implementation parses from a TextScanner
+	 * over the memory mapped file instead of a std::istream, and the records
+	 * are parsed in parallel (see readGraphDataParallel).
+	 */
+	template<typename Implementation>
+	struct ScanReader
+	{
+		typedef typename std::remove_reference<decltype(result_of(&Implementation::readNode))>::type node_type;
+		typedef typename std::remove_reference<decltype(result_of(&Implementation::readEdge))>::type edge_type;
+		typedef MakeCHEdge<edge_type> chedge_type;
+
+		template<typename NodeT = node_type, typename EdgeT = chedge_type>
+		using can_read = typename SimpleReader<Implementation>::template can_read<NodeT, EdgeT>;
+
+		template<typename NodeT = node_type, typename EdgeT = chedge_type, typename std::enable_if<!can_read<NodeT, EdgeT>::value>::type* = nullptr>
+		static GraphInData<NodeT, EdgeT> readGraph(TextScanner&)
+		{
+			Print("Can't read nodes / edges in this format");
+			std::abort();
+		}
+
+		template<typename NodeT = node_type, typename EdgeT = chedge_type, typename std::enable_if<can_read<NodeT, EdgeT>::value>::type* = nullptr>
+		static GraphInData<NodeT, EdgeT> readGraph(TextScanner& scanner)
+		{
+			return readGraphDataParallel<Implementation, NodeT, EdgeT>(scanner);
+		}
+
+		template<typename NodeT = node_type, typename EdgeT = chedge_type>
+		static GraphInData<NodeT, EdgeT> readGraph(std::istream& is)
+		{
+			std::string const buffer{std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+			TextScanner scanner(buffer.data(), buffer.data() + buffer.size());
+			return readGraph<NodeT, EdgeT>(scanner);
+		}
+
+		template<typename NodeT = node_type, typename EdgeT = chedge_type>
+		static GraphInData<NodeT, EdgeT> readGraph(std::string const& filename)
+		{
+			MappedFile file(filename);
+			file.adviseSequential();
+			TextScanner scanner(file.begin(), file.end());
+			return readGraph<NodeT, EdgeT>(scanner);
+		}
+	};
+
+
+	/*
+	 * Formats records [0, nr_of_records) with format(buffer, i) into
+	 * buffers, block by block in parallel. The filled buffers are passed in
+	 * order through a bounded queue to a writer thread, so formatting goes on
+	 * while earlier blocks are written.
+	 */
+	template<typename Format>
+	void writeRecordsParallel(std::ostream& os, size_t nr_of_records, Format&& format)
+	{
+		/* records formatted into one buffer before it is written */
+		size_t const BLOCK_SIZE(1 << 14);
+		size_t const nr_of_blocks((nr_of_records + BLOCK_SIZE - 1) / BLOCK_SIZE);
+		size_t const max_filled(2 * omp_get_max_threads());
+
+		BoundedQueue<TextBuffer> filled(max_filled);
+		/* written buffers for reuse; there are never more buffers than
+		 * filled ones, one per thread and the writer's */
+		BoundedQueue<TextBuffer> written(max_filled + omp_get_max_threads() + 1);
+
+		std::thread writer([&] {
+			TextBuffer buffer;
+			while (filled.pop(buffer)) {
+				buffer.writeTo(os);
+				written.push(std::move(buffer));
+			}
+		});
+
+		#pragma omp parallel
+		{
+			TextBuffer buffer;
+
+			#pragma omp for ordered schedule(dynamic)
+			for (size_t block = 0; block < nr_of_blocks; block++) {
+				if (!written.tryPop(buffer)) buffer = TextBuffer();
+				buffer.clear();
+				size_t const last(std::min(nr_of_records, (block + 1) * BLOCK_SIZE));
+				for (size_t i(block * BLOCK_SIZE); i < last; i++) {
+					format(buffer, i);
+				}
+
+				#pragma omp ordered
+				filled.push(std::move(buffer));
+			}
+		}
+
+		filled.close();
+		writer.join();
+	}
+
+	/* the edges of a CH written in two steps have to match its header */
+	inline void checkNrOfEdges(size_t nr_of_edges, size_t announced)
+	{
+		if (nr_of_edges != announced) {
+			std::cerr << "FATAL_ERROR: " << nr_of_edges << " edges exported instead of "
+				<< announced << ". Exiting.\n";
+			std::abort();
+		}
+	}
 
 	template<typename Implementation>
 	struct SimpleWriter
 	{
-		typedef decay_tuple_element<0, decltype(return_args(&Implementation::writeNode))> node_type;
-		typedef decay_tuple_element<0, decltype(return_args(&Implementation::writeEdge))> edge_type;
+		typedef decay_tuple_element<1, decltype(return_args(&Implementation::formatNode))> node_type;
+		typedef decay_tuple_element<1, decltype(return_args(&Implementation::formatEdge))> edge_type;
 
 
 		template<typename NodeT, typename EdgeT>
@@ -139,33 +443,30 @@ namespace chc {
 
 			impl.writeHeader(nr_of_nodes, nr_of_edges, data.meta_data);
 
-			NodeID node_id = 0;
-			for (auto const& node: data.nodes) {
-				impl.writeNode(static_cast<node_type>(node), (NodeID) node_id);
-				++node_id;
-			}
+			writeRecordsParallel(os, nr_of_nodes, [&](TextBuffer& buffer, size_t node_id) {
+				impl.formatNode(buffer, static_cast<node_type>(data.nodes[node_id]), (NodeID) node_id);
+			});
 			Print("Exported all nodes.");
 
-			EdgeID edge_id = 0;
-			for (auto const& edge: data.edges) {
-				impl.writeEdge(static_cast<edge_type>(edge), (EdgeID) edge_id);
-				++edge_id;
-			}
+			writeRecordsParallel(os, nr_of_edges, [&](TextBuffer& buffer, size_t edge_id) {
+				impl.formatEdge(buffer, static_cast<edge_type>(data.edges[edge_id]), (EdgeID) edge_id);
+			});
 			Print("Exported all edges.");
 		}
 
+		/* see writeCHGraphFile for nr_of_edges and wait_for_edges */
 		template<typename NodeT, typename EdgeT, typename std::enable_if<!can_write<NodeT, EdgeT>::value>::type* = nullptr>
-		static void writeCHGraph(std::ostream&, GraphCHOutData<NodeT, EdgeT> const&)
+		static void writeCHGraph(std::ostream&, GraphCHOutData<NodeT, EdgeT> const&, EdgeID, std::function<void()> const&)
 		{
 			Print("Can't export nodes / edges in this format");
 			std::abort();
 		}
 
 		template<typename NodeT, typename EdgeT, typename std::enable_if<can_write<NodeT, EdgeT>::value>::type* = nullptr>
-		static void writeCHGraph(std::ostream& os, GraphCHOutData<NodeT, EdgeT> const& data)
+		static void writeCHGraph(std::ostream& os, GraphCHOutData<NodeT, EdgeT> const& data,
+				EdgeID nr_of_edges, std::function<void()> const& wait_for_edges)
 		{
 			NodeID nr_of_nodes(data.nodes.size());
-			EdgeID nr_of_edges(data.edges.size());
 
 			Print("Exporting " << nr_of_nodes << " nodes and " << nr_of_edges << " edges");
 
@@ -173,18 +474,16 @@ namespace chc {
 
 			impl.writeHeader(nr_of_nodes, nr_of_edges, data.meta_data);
 
-			NodeID node_id = 0;
-			for (auto const& node: data.nodes) {
-				impl.writeNode(static_cast<node_type>(makeCHNode(node, data.node_levels[node_id])), (NodeID) node_id);
-				++node_id;
-			}
+			writeRecordsParallel(os, nr_of_nodes, [&](TextBuffer& buffer, size_t node_id) {
+				impl.formatNode(buffer, static_cast<node_type>(makeCHNode(data.nodes[node_id], data.node_levels[node_id])), (NodeID) node_id);
+			});
 			Print("Exported all nodes.");
 
-			EdgeID edge_id = 0;
-			for (auto const& edge: data.edges) {
-				impl.writeEdge(static_cast<edge_type>(edge), (EdgeID) edge_id);
-				++edge_id;
-			}
+			wait_for_edges();
+			checkNrOfEdges(data.edges.size(), nr_of_edges);
+			writeRecordsParallel(os, nr_of_edges, [&](TextBuffer& buffer, size_t edge_id) {
+				impl.formatEdge(buffer, static_cast<edge_type>(data.edges[edge_id]), (EdgeID) edge_id);
+			});
 			Print("Exported all edges.");
 		}
 	};
@@ -7,6 +7,8 @@ namespace chc {
 	/* usage: decltype(return_args(&Class::memberfunction)) */
 	template<typename Base, typename Result, typename... Args>
 	std::tuple<Args...> return_args(Result (Base::*func)(Args...));
+	template<typename Base, typename Result, typename... Args>
+	std::tuple<Args...> return_args(Result (Base::*func)(Args...) const);
 
 	/* usage: decltype(result_of(&Class::memberfunction)) */
 	template<typename Base, typename Result, typename... Args>
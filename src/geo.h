@@ -0,0 +1,21 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+namespace chc
+{
+
+double const EARTH_RADIUS(6371000);
+
+/* great-circle distance in meters */
+inline double geoDist(double lat1, double lon1, double lat2, double lon2)
+{
+	double const to_rad(M_PI / 180);
+	double const dlat((lat2 - lat1) * to_rad), dlon((lon2 - lon1) * to_rad);
+	double const a(std::sin(dlat / 2) * std::sin(dlat / 2) +
+			std::cos(lat1 * to_rad) * std::cos(lat2 * to_rad) * std::sin(dlon / 2) * std::sin(dlon / 2));
+	return 2 * EARTH_RADIUS * std::asin(std::min(1.0, std::sqrt(a)));
+}
+
+}
@@ -3,6 +3,7 @@
 #include "defs.h"
 #include "nodes_and_edges.h"
 #include "indexed_container.h"
+#include "memory_usage.h"
 
 #include <vector>
 #include <algorithm>
@@ -59,6 +60,9 @@ class Graph
 		template<typename Range>
 		void printInfo(Range&& nodes) const;
 
+		/* allocated bytes of the nodes, edges and indices */
+		MemoryUsage memoryUsage() const;
+
 		uint getNrOfNodes() const { return _nodes.size(); }
 		uint getNrOfEdges() const { return _out_edges.size(); }
 		Metadata const& getMetadata() const { return _meta_data; }
@@ -156,6 +160,19 @@ void Graph<NodeT, EdgeT>::printInfo(Range&& nodes) const
 #endif
 }
 
+template <typename NodeT, typename EdgeT>
+MemoryUsage Graph<NodeT, EdgeT>::memoryUsage() const
+{
+	MemoryUsage usage;
+	usage.add("nodes", chc::memoryUsage(_nodes));
+	usage.add("out_offsets", chc::memoryUsage(_out_offsets));
+	usage.add("in_offsets", chc::memoryUsage(_in_offsets));
+	usage.add("out_edges", chc::memoryUsage(_out_edges));
+	usage.add("in_edges", chc::memoryUsage(_in_edges));
+	usage.add("id_to_index", chc::memoryUsage(_id_to_index));
+	return usage;
+}
+
 template <typename NodeT, typename EdgeT>
 void Graph<NodeT, EdgeT>::sortInEdges()
 {
@@ -170,6 +187,9 @@ void Graph<NodeT, EdgeT>::sortOutEdges()
 {
 	Debug("Sort the outgoing edges.");
 
+	/* edges from readGraphDataParallel were sorted by its parsers while
+	 * the input was read */
+	if (std::is_sorted(_out_edges.begin(), _out_edges.end(), OutEdgeSort())) return;
 	std::sort(_out_edges.begin(), _out_edges.end(), OutEdgeSort());
 	debug_assert(std::is_sorted(_out_edges.begin(), _out_edges.end(), OutEdgeSort()));
 }
@@ -221,10 +241,22 @@ void Graph<NodeT, EdgeT>::initIdToIndex()
 template <typename NodeT, typename EdgeT>
 void Graph<NodeT, EdgeT>::update()
 {
-	sortOutEdges();
-	sortInEdges();
-	initOffsets();
-	initIdToIndex();
+	/* the out and in edges are independent, so sort them (and build the
+	 * offsets and the index mapper) concurrently */
+	#pragma omp parallel sections
+	{
+		#pragma omp section
+		sortOutEdges();
+		#pragma omp section
+		sortInEdges();
+	}
+	#pragma omp parallel sections
+	{
+		#pragma omp section
+		initOffsets();
+		#pragma omp section
+		initIdToIndex();
+	}
 
 	_is_dirty = false;
 }
@@ -0,0 +1,440 @@
+#pragma once
+
+#include "defs.h"
+#include "nodes_and_edges.h"
+#include "geo.h"
+#include "parallel_algorithms.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <utility>
+
+namespace chc
+{
+
+namespace unit_tests
+{
+	void testGraphGenerator();
+}
+
+/*
+ * Synthetic road-like graphs, for benchmarks on inputs of any size.
+ *
+ * Nodes get coordinates (around 48.7N, 9.1E) and distances are in meters, so
+ * the graphs can be written in the usual formats and used with geometric
+ * heuristics. The same parameters and seed always give the same graph
+ * (independent of the number of threads).
+ *
+ * - gridGraph: regular grid with randomly longer roads
+ * - randomGeometricGraph: random points, each connected to its 1-4 nearest
+ *   neighbours, which gives road-like degrees (and a few islands)
+ * - addHighways: hierarchical overlay of faster, straighter roads between
+ *   hub nodes on coarser and coarser lattices
+ */
+namespace generator
+{
+	double const ORIGIN_LAT(48.7);
+	double const ORIGIN_LON(9.1);
+
+	/* road classes and speeds like in the OSM based test data (smaller
+	 * types are more important roads); index 0 is used for local roads,
+	 * index l for highways of level l */
+	uint const ROAD_TYPES[] = { 15, 9, 5, 1 };
+	int const ROAD_SPEEDS[] = { -1, 70, 100, 130 };
+	uint const NR_OF_ROAD_CLASSES(sizeof(ROAD_TYPES) / sizeof(ROAD_TYPES[0]));
+
+	/* position in meters in a local equirectangular projection around the origin */
+	struct Point
+	{
+		double x;
+		double y;
+	};
+
+	inline Point project(double lat, double lon)
+	{
+		double const to_meters(EARTH_RADIUS * M_PI / 180);
+		return Point{(lon - ORIGIN_LON) * to_meters * std::cos(ORIGIN_LAT * M_PI / 180), (lat - ORIGIN_LAT) * to_meters};
+	}
+
+	inline void unproject(Point const& point, double& lat, double& lon)
+	{
+		double const to_meters(EARTH_RADIUS * M_PI / 180);
+		lat = ORIGIN_LAT + point.y / to_meters;
+		lon = ORIGIN_LON + point.x / (to_meters * std::cos(ORIGIN_LAT * M_PI / 180));
+	}
+
+	inline double squaredDist(Point const& p1, Point const& p2)
+	{
+		return (p1.x - p2.x) * (p1.x - p2.x) + (p1.y - p2.y) * (p1.y - p2.y);
+	}
+
+	/* pseudo random number from (seed, a, b), so values can be drawn in
+	 * parallel without depending on the order (splitmix64 finalizer) */
+	inline uint64_t hash(uint64_t seed, uint64_t a, uint64_t b = 0)
+	{
+		uint64_t x(seed * 0x9E3779B97F4A7C15ull ^ (a + 0x632BE59BD9B4E019ull) * 0xBF58476D1CE4E5B9ull ^ (b + 1) * 0x94D049BB133111EBull);
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+		return x ^ (x >> 31);
+	}
+
+	/* uniformly distributed in [0, 1) */
+	inline double uniform(uint64_t hash_value)
+	{
+		return (hash_value >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	inline OSMNode makeNode(NodeID id, double lat, double lon)
+	{
+		OSMNode node;
+		node.id = id;
+		node.osm_id = id;
+		node.lat = lat;
+		node.lon = lon;
+		return node;
+	}
+
+	/* edges in both directions; the length is the distance of the nodes
+	 * times detour (>= 1) */
+	inline void addRoad(GraphInData<OSMNode, OSMEdge>& data, NodeID src, NodeID tgt,
+			double detour, uint type, int speed)
+	{
+		auto const& n1(data.nodes[src]);
+		auto const& n2(data.nodes[tgt]);
+		uint const dist(std::max(1.0, std::round(geoDist(n1.lat, n1.lon, n2.lat, n2.lon) * detour)));
+		data.edges.emplace_back(data.edges.size(), src, tgt, dist, type, speed);
+		data.edges.emplace_back(data.edges.size(), tgt, src, dist, type, speed);
+	}
+
+	/* sorts the edges by source and target, keeps only the shortest of
+	 * parallel edges and numbers the edges in this order */
+	inline void normalizeEdges(std::vector<OSMEdge>& edges)
+	{
+		parallelStableSort(edges, EdgeSortSrcTgtDist<OSMEdge>());
+		parallelRemoveIf(edges, [&edges](size_t i) {
+			return i > 0 && equalEndpoints(edges[i-1], edges[i]);
+		});
+		#pragma omp parallel for schedule(static)
+		for (size_t i = 0; i < edges.size(); i++) {
+			edges[i].id = i;
+		}
+	}
+
+	/*
+	 * Nodes bucketed into square cells of their projected positions, for
+	 * nearest neighbour queries.
+	 */
+	class SpatialGrid
+	{
+		private:
+			std::vector<Point> _points;
+			Point _min;
+			double _cell_size;
+			size_t _width;
+			size_t _height;
+			/* nodes of cell c are _cell_nodes[_cell_offsets[c], _cell_offsets[c+1]) */
+			std::vector<size_t> _cell_offsets;
+			std::vector<NodeID> _cell_nodes;
+
+			size_t _column(double x) const { return std::min(_width - 1, size_t(std::max(0.0, (x - _min.x) / _cell_size))); }
+			size_t _row(double y) const { return std::min(_height - 1, size_t(std::max(0.0, (y - _min.y) / _cell_size))); }
+
+			/* calls visit(node) for all nodes in the cells with Chebyshev
+			 * distance ring from cell (column, row); returns false if the
+			 * ring is completely outside of the grid */
+			template<typename Visit>
+			bool _visitRing(size_t column, size_t row, size_t ring, Visit&& visit) const;
+		public:
+			SpatialGrid(std::vector<OSMNode> const& nodes, double cell_size);
+
+			Point const& point(NodeID node) const { return _points[node]; }
+			double cellSize() const { return _cell_size; }
+			Point min() const { return _min; }
+			Point max() const { return Point{_min.x + _width * _cell_size, _min.y + _height * _cell_size}; }
+
+			/* node closest to point (c::NO_NID if there are no nodes) */
+			NodeID nearest(Point const& point) const;
+			/* the (at most) k nodes closest to node, without node itself, closest first */
+			std::vector<NodeID> nearest(NodeID node, size_t k) const;
+	};
+
+	inline SpatialGrid::SpatialGrid(std::vector<OSMNode> const& nodes, double cell_size)
+		: _points(nodes.size()), _min(Point{0, 0}), _cell_size(cell_size), _width(1), _height(1)
+	{
+		#pragma omp parallel for schedule(static)
+		for (size_t i = 0; i < nodes.size(); i++) {
+			_points[i] = project(nodes[i].lat, nodes[i].lon);
+		}
+
+		if (!_points.empty()) {
+			Point max(_points.front());
+			_min = _points.front();
+			for (auto const& point: _points) {
+				_min.x = std::min(_min.x, point.x);
+				_min.y = std::min(_min.y, point.y);
+				max.x = std::max(max.x, point.x);
+				max.y = std::max(max.y, point.y);
+			}
+			_width = size_t((max.x - _min.x) / _cell_size) + 1;
+			_height = size_t((max.y - _min.y) / _cell_size) + 1;
+		}
+
+		/* counting sort of the nodes by cell */
+		std::vector<size_t> cells(_points.size());
+		_cell_offsets.assign(_width * _height + 1, 0);
+		for (size_t i(0); i < _points.size(); i++) {
+			cells[i] = _row(_points[i].y) * _width + _column(_points[i].x);
+			_cell_offsets[cells[i] + 1]++;
+		}
+		for (size_t c(0); c < _width * _height; c++) {
+			_cell_offsets[c + 1] += _cell_offsets[c];
+		}
+		_cell_nodes.resize(_points.size());
+		std::vector<size_t> pos(_cell_offsets.begin(), _cell_offsets.end() - 1);
+		for (size_t i(0); i < _points.size(); i++) {
+			_cell_nodes[pos[cells[i]]++] = i;
+		}
+	}
+
+	template<typename Visit>
+	bool SpatialGrid::_visitRing(size_t column, size_t row, size_t ring, Visit&& visit) const
+	{
+		if (ring > column && ring > row && column + ring >= _width && row + ring >= _height) return false;
+
+		auto visitCell = [&](size_t c, size_t r) {
+			size_t const cell(r * _width + c);
+			for (size_t i(_cell_offsets[cell]); i < _cell_offsets[cell + 1]; i++) {
+				visit(_cell_nodes[i]);
+			}
+		};
+
+		long const c_begin(long(column) - long(ring)), c_end(long(column) + long(ring));
+		long const r_begin(long(row) - long(ring)), r_end(long(row) + long(ring));
+		for (long r(std::max(0l, r_begin)); r <= std::min(long(_height) - 1, r_end); r++) {
+			bool const border_row(r == r_begin || r == r_end);
+			for (long c(std::max(0l, c_begin)); c <= std::min(long(_width) - 1, c_end); c++) {
+				if (border_row || c == c_begin || c == c_end) visitCell(c, r);
+				else c = c_end - 1; /* jump to the right border */
+			}
+		}
+		return true;
+	}
+
+	inline NodeID SpatialGrid::nearest(Point const& point) const
+	{
+		NodeID best(c::NO_NID);
+		double best_dist(0);
+		size_t const column(_column(point.x)), row(_row(point.y));
+		for (size_t ring(0); ; ring++) {
+			bool const inside(_visitRing(column, row, ring, [&](NodeID node) {
+				double const dist(squaredDist(point, _points[node]));
+				if (best == c::NO_NID || dist < best_dist || (dist == best_dist && node < best)) {
+					best = node;
+					best_dist = dist;
+				}
+			}));
+			/* nodes outside of this ring are at least ring cells away */
+			if (!inside || (best != c::NO_NID && best_dist <= std::pow(ring * _cell_size, 2))) break;
+		}
+		return best;
+	}
+
+	inline std::vector<NodeID> SpatialGrid::nearest(NodeID node, size_t k) const
+	{
+		if (0 == k) return std::vector<NodeID>();
+
+		/* (squared distance, node), sorted */
+		std::vector<std::pair<double, NodeID>> best;
+		Point const& point(_points[node]);
+		size_t const column(_column(point.x)), row(_row(point.y));
+		for (size_t ring(0); ; ring++) {
+			bool const inside(_visitRing(column, row, ring, [&](NodeID other) {
+				if (other == node) return;
+				std::pair<double, NodeID> const candidate(squaredDist(point, _points[other]), other);
+				if (best.size() < k || candidate < best.back()) {
+					best.insert(std::upper_bound(best.begin(), best.end(), candidate), candidate);
+					if (best.size() > k) best.pop_back();
+				}
+			}));
+			if (!inside || (best.size() == k && best.back().first <= std::pow(ring * _cell_size, 2))) break;
+		}
+
+		std::vector<NodeID> result;
+		for (auto const& entry: best) {
+			result.push_back(entry.second);
+		}
+		return result;
+	}
+
+	/*
+	 * width x height grid with about spacing meters between neighbours; the
+	 * length of every road is its straight distance times a random detour in
+	 * [1, 1.5), which avoids the many equal distances of a regular grid.
+	 */
+	inline GraphInData<OSMNode, OSMEdge> gridGraph(uint width, uint height, uint seed = 0, double spacing = 100)
+	{
+		std::mt19937 gen(seed);
+		std::uniform_real_distribution<double> detour(1, 1.5);
+
+		double const lat_step(spacing / EARTH_RADIUS * 180 / M_PI);
+		double const lon_step(lat_step / std::cos(ORIGIN_LAT * M_PI / 180));
+
+		GraphInData<OSMNode, OSMEdge> data;
+		data.nodes.reserve(size_t(width) * height);
+		for (uint y(0); y < height; y++) {
+			for (uint x(0); x < width; x++) {
+				data.nodes.push_back(makeNode(data.nodes.size(), ORIGIN_LAT + y * lat_step, ORIGIN_LON + x * lon_step));
+			}
+		}
+
+		data.edges.reserve(4 * size_t(width) * height);
+		for (uint y(0); y < height; y++) {
+			for (uint x(0); x < width; x++) {
+				NodeID const node(y * width + x);
+				if (x + 1 < width) addRoad(data, node, node + 1, detour(gen), ROAD_TYPES[0], ROAD_SPEEDS[0]);
+				if (y + 1 < height) addRoad(data, node, node + width, detour(gen), ROAD_TYPES[0], ROAD_SPEEDS[0]);
+			}
+		}
+		normalizeEdges(data.edges);
+
+		return data;
+	}
+
+	/*
+	 * nr_of_nodes random points with about spacing meters between
+	 * neighbours. Every node is connected to its k nearest neighbours, k
+	 * random in [1, 4] (mostly 2 or 3); with the roads from the neighbours
+	 * this gives an average degree of about 3. The detours are random in
+	 * [1, 1.5) as in gridGraph. Node ids follow the position, cell by cell,
+	 * for some locality as in real data.
+	 */
+	inline GraphInData<OSMNode, OSMEdge> randomGeometricGraph(NodeID nr_of_nodes, uint seed = 0, double spacing = 100)
+	{
+		/* cumulative probabilities of connecting to 1, 2, 3, 4 nearest neighbours */
+		double const K_DISTRIBUTION[] = { 0.25, 0.65, 0.9, 1 };
+		size_t const MAX_K(sizeof(K_DISTRIBUTION) / sizeof(K_DISTRIBUTION[0]));
+
+		double const side(spacing * std::sqrt(double(nr_of_nodes)));
+
+		/* random points sorted by cell of size spacing */
+		size_t const columns(size_t(side / spacing) + 1);
+		std::vector<std::pair<uint64_t, Point>> points(nr_of_nodes);
+		#pragma omp parallel for schedule(static)
+		for (NodeID i = 0; i < nr_of_nodes; i++) {
+			Point const point{uniform(hash(seed, i, 0)) * side, uniform(hash(seed, i, 1)) * side};
+			points[i] = std::make_pair(uint64_t(point.y / spacing) * columns + uint64_t(point.x / spacing), point);
+		}
+		parallelStableSort(points, [](std::pair<uint64_t, Point> const& p1, std::pair<uint64_t, Point> const& p2) {
+			return p1.first < p2.first;
+		});
+
+		GraphInData<OSMNode, OSMEdge> data;
+		data.nodes.resize(nr_of_nodes);
+		#pragma omp parallel for schedule(static)
+		for (NodeID i = 0; i < nr_of_nodes; i++) {
+			double lat, lon;
+			unproject(points[i].second, lat, lon);
+			data.nodes[i] = makeNode(i, lat, lon);
+		}
+		std::vector<std::pair<uint64_t, Point>>().swap(points);
+
+		SpatialGrid const grid(data.nodes, spacing);
+
+		std::vector<std::array<NodeID, MAX_K>> neighbours(nr_of_nodes);
+		std::vector<uint8_t> nr_of_neighbours(nr_of_nodes);
+		#pragma omp parallel for schedule(dynamic, 1024)
+		for (NodeID i = 0; i < nr_of_nodes; i++) {
+			double const r(uniform(hash(seed, i, 2)));
+			size_t const k(std::lower_bound(K_DISTRIBUTION, K_DISTRIBUTION + MAX_K, r) - K_DISTRIBUTION + 1);
+			auto const nearest(grid.nearest(i, k));
+			std::copy(nearest.begin(), nearest.end(), neighbours[i].begin());
+			nr_of_neighbours[i] = nearest.size();
+		}
+
+		/* every road once: from the smaller node, or from the only node which chose it */
+		auto isNeighbour = [&](NodeID node, NodeID neighbour) {
+			return neighbours[node].begin() + nr_of_neighbours[node] !=
+				std::find(neighbours[node].begin(), neighbours[node].begin() + nr_of_neighbours[node], neighbour);
+		};
+		auto hasRoad = [&](NodeID node, size_t i) {
+			NodeID const other(neighbours[node][i]);
+			return node < other || !isNeighbour(other, node);
+		};
+
+		std::vector<size_t> offsets(size_t(nr_of_nodes) + 1, 0);
+		#pragma omp parallel for schedule(static)
+		for (NodeID node = 0; node < nr_of_nodes; node++) {
+			for (size_t i(0); i < nr_of_neighbours[node]; i++) {
+				offsets[node + 1] += hasRoad(node, i) ? 2 : 0;
+			}
+		}
+		for (NodeID node(0); node < nr_of_nodes; node++) {
+			offsets[node + 1] += offsets[node];
+		}
+
+		data.edges.resize(offsets[nr_of_nodes]);
+		#pragma omp parallel for schedule(static)
+		for (NodeID node = 0; node < nr_of_nodes; node++) {
+			size_t pos(offsets[node]);
+			for (size_t i(0); i < nr_of_neighbours[node]; i++) {
+				if (!hasRoad(node, i)) continue;
+				NodeID const other(neighbours[node][i]);
+				auto const& n1(data.nodes[node]);
+				auto const& n2(data.nodes[other]);
+				double const detour(1 + 0.5 * uniform(hash(seed, std::min(node, other), std::max(node, other))));
+				uint const dist(std::max(1.0, std::round(geoDist(n1.lat, n1.lon, n2.lat, n2.lon) * detour)));
+				data.edges[pos++] = OSMEdge(c::NO_EID, node, other, dist, ROAD_TYPES[0], ROAD_SPEEDS[0]);
+				data.edges[pos++] = OSMEdge(c::NO_EID, other, node, dist, ROAD_TYPES[0], ROAD_SPEEDS[0]);
+			}
+		}
+		normalizeEdges(data.edges);
+
+		return data;
+	}
+
+	/*
+	 * Adds nr_of_levels levels of highways: the hubs of level l are the
+	 * nodes closest to the points of a square lattice with
+	 * hub_spacing * 4^(l-1) meters between the points, and neighbouring hubs
+	 * are connected in both directions. Highways are more important road
+	 * classes and almost straight (detour in [1, 1.1)), so shortest paths
+	 * over longer distances use them.
+	 */
+	inline void addHighways(GraphInData<OSMNode, OSMEdge>& data, uint nr_of_levels, uint seed = 0, double hub_spacing = 2000)
+	{
+		if (data.nodes.empty()) return;
+
+		SpatialGrid const grid(data.nodes, hub_spacing / 8);
+		Point const min(grid.min()), max(grid.max());
+
+		for (uint level(1); level <= nr_of_levels; level++) {
+			uint const road_class(std::min(level, NR_OF_ROAD_CLASSES - 1));
+			double const spacing(hub_spacing * std::pow(4, level - 1));
+			size_t const columns(size_t((max.x - min.x) / spacing) + 1);
+			size_t const rows(size_t((max.y - min.y) / spacing) + 1);
+			if (columns < 2 && rows < 2) break;
+
+			std::vector<NodeID> hubs(columns * rows);
+			#pragma omp parallel for schedule(dynamic)
+			for (size_t i = 0; i < hubs.size(); i++) {
+				hubs[i] = grid.nearest(Point{min.x + (i % columns) * spacing, min.y + (i / columns) * spacing});
+			}
+
+			for (size_t i(0); i < hubs.size(); i++) {
+				size_t const neighbours[] = { i % columns + 1 < columns ? i + 1 : i, i / columns + 1 < rows ? i + columns : i };
+				for (size_t neighbour: neighbours) {
+					if (hubs[neighbour] == hubs[i]) continue;
+					double const detour(1 + 0.1 * uniform(hash(seed, level, i * 2 + (neighbour != i + 1))));
+					addRoad(data, hubs[i], hubs[neighbour], detour, ROAD_TYPES[road_class], ROAD_SPEEDS[road_class]);
+				}
+			}
+		}
+
+		normalizeEdges(data.edges);
+	}
+}
+
+}
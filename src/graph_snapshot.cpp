@@ -0,0 +1,92 @@
+#include "graph_snapshot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <omp.h>
+#include <unistd.h>
+
+namespace chc {
+	namespace snapshot {
+		namespace {
+			uint64_t const FNV_OFFSET_BASIS(14695981039346656037ull);
+			uint64_t const FNV_PRIME(1099511628211ull);
+			size_t const HASH_CHUNK_SIZE(1 << 20);
+
+			std::atomic<uint64_t> tmp_counter(0);
+		}
+
+		uint64_t hashCombine(uint64_t hash, void const* data, size_t size)
+		{
+			unsigned char const* bytes(static_cast<unsigned char const*>(data));
+			for (size_t i(0); i < size; i++) {
+				hash ^= bytes[i];
+				hash *= FNV_PRIME;
+			}
+			return hash;
+		}
+
+		uint64_t hashFile(std::string const& filename)
+		{
+			MappedFile file(filename);
+			size_t const nr_of_chunks((file.size() + HASH_CHUNK_SIZE - 1) / HASH_CHUNK_SIZE);
+
+			/* with the threads of the OpenMP setting, like the readers */
+			std::vector<uint64_t> chunk_hashes(nr_of_chunks);
+			#pragma omp parallel for schedule(dynamic)
+			for (size_t i = 0; i < nr_of_chunks; i++) {
+				size_t const begin(i * HASH_CHUNK_SIZE);
+				size_t const size(std::min(HASH_CHUNK_SIZE, file.size() - begin));
+				chunk_hashes[i] = hashCombine(FNV_OFFSET_BASIS, file.data() + begin, size);
+			}
+
+			uint64_t const file_size(file.size());
+			uint64_t hash(hashCombine(FNV_OFFSET_BASIS, &file_size, sizeof(file_size)));
+			return hashCombine(hash, chunk_hashes.data(), chunk_hashes.size() * sizeof(uint64_t));
+		}
+
+		std::string serializeMetaData(Metadata const& meta_data)
+		{
+			std::string result;
+			for (auto const& meta_datum: meta_data) {
+				result += meta_datum.first;
+				result.push_back('\0');
+				result += meta_datum.second;
+				result.push_back('\0');
+			}
+			return result;
+		}
+
+		Metadata deserializeMetaData(char const* data, size_t size)
+		{
+			Metadata result;
+			char const* pos(data);
+			char const* end(data + size);
+			while (pos < end) {
+				char const* key_end(std::find(pos, end, '\0'));
+				char const* value(std::min(key_end + 1, end));
+				char const* value_end(std::find(value, end, '\0'));
+				result[std::string(pos, key_end)] = std::string(value, value_end);
+				pos = value_end + 1;
+			}
+			return result;
+		}
+
+		std::string filename(std::string const& cache_dir, uint64_t key)
+		{
+			std::ostringstream os;
+			os << cache_dir << (cache_dir.empty() || '/' == cache_dir.back() ? "" : "/")
+				<< "input_" << std::hex << std::setw(16) << std::setfill('0') << key << ".snapshot";
+			return os.str();
+		}
+
+		std::string tmpFilename(std::string const& filename)
+		{
+			std::ostringstream os;
+			os << filename << ".tmp." << getpid() << "." << tmp_counter++;
+			return os.str();
+		}
+	}
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include "defs.h"
+#include "nodes_and_edges.h"
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <typeinfo>
+#include <type_traits>
+
+namespace chc
+{
+
+namespace unit_tests
+{
+	void testGraphSnapshot();
+}
+
+/*
+ * Binary snapshots of the preprocessed input (GraphInData after parsing,
+ * filtering and deduplication), so repeated runs on the same input can skip
+ * the text readers.
+ *
+ * A snapshot is keyed by a hash of the content of the input file, the reader
+ * (input format) and the node and edge types it was read with; the key is part of
+ * the snapshot's file name and stored in its header. Nodes and edges are
+ * stored as raw bytes, so snapshots are only meant to be reused by the same
+ * build on the same machine.
+ */
+namespace snapshot
+{
+	uint32_t const VERSION = 1;
+
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t node_size;
+		uint32_t edge_size;
+		uint32_t padding;
+		uint64_t key;
+		uint64_t nr_of_nodes;
+		uint64_t nr_of_edges;
+		uint64_t meta_data_size;
+	};
+
+	/* 64 bit FNV-1a over chunks of the file, hashed in parallel */
+	uint64_t hashFile(std::string const& filename);
+	uint64_t hashCombine(uint64_t hash, void const* data, size_t size);
+	inline uint64_t hashCombine(uint64_t hash, std::string const& str)
+	{
+		return hashCombine(hash, str.data(), str.size());
+	}
+
+	std::string serializeMetaData(Metadata const& meta_data);
+	Metadata deserializeMetaData(char const* data, size_t size);
+
+	template<typename NodeT, typename EdgeT>
+	uint64_t key(std::string const& filename, std::string const& reader)
+	{
+		uint64_t hash(hashFile(filename));
+		hash = hashCombine(hash, reader);
+		hash = hashCombine(hash, typeid(NodeT).name());
+		hash = hashCombine(hash, typeid(EdgeT).name());
+		return hash;
+	}
+
+	std::string filename(std::string const& cache_dir, uint64_t key);
+	/* "<filename>.tmp.<pid>.<n>", unique per process and call, so concurrent
+	 * writers of one snapshot never share a temporary file */
+	std::string tmpFilename(std::string const& filename);
+
+	/* writes to a temporary file first, so a snapshot is either complete or missing */
+	template<typename NodeT, typename EdgeT>
+	void write(std::string const& filename, uint64_t key, GraphInData<NodeT, EdgeT> const& data);
+
+	/* returns false if there is no valid snapshot with this key */
+	template<typename NodeT, typename EdgeT>
+	bool read(std::string const& filename, uint64_t key, GraphInData<NodeT, EdgeT>& data);
+}
+
+/*
+ * Reuses a snapshot from cache_dir if there is one for this input and
+ * reader (e.g. the name of the input format); otherwise the input is read
+ * with read() and a snapshot is stored.
+ */
+template<typename NodeT, typename EdgeT, typename Read>
+GraphInData<NodeT, EdgeT> readGraphCached(std::string const& filename, std::string const& reader,
+		std::string const& cache_dir, Read&& read)
+{
+	uint64_t const key(snapshot::key<NodeT, EdgeT>(filename, reader));
+	std::string const snapshot_file(snapshot::filename(cache_dir, key));
+
+	GraphInData<NodeT, EdgeT> data;
+	if (snapshot::read(snapshot_file, key, data)) {
+		Print("Read input from snapshot " << snapshot_file);
+		return data;
+	}
+
+	data = read();
+	snapshot::write(snapshot_file, key, data);
+	Print("Stored input snapshot " << snapshot_file);
+	return data;
+}
+
+namespace snapshot
+{
+	char const MAGIC[8] = {'C', 'H', 'C', 'S', 'N', 'A', 'P', 'S'};
+
+	template<typename NodeT, typename EdgeT>
+	void write(std::string const& filename, uint64_t key, GraphInData<NodeT, EdgeT> const& data)
+	{
+		static_assert(std::is_trivially_copyable<NodeT>::value && std::is_trivially_copyable<EdgeT>::value,
+				"snapshots require trivially copyable nodes and edges");
+
+		std::string const meta(serializeMetaData(data.meta_data));
+
+		Header header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.node_size = sizeof(NodeT);
+		header.edge_size = sizeof(EdgeT);
+		header.key = key;
+		header.nr_of_nodes = data.nodes.size();
+		header.nr_of_edges = data.edges.size();
+		header.meta_data_size = meta.size();
+
+		std::string const tmp_filename(tmpFilename(filename));
+		std::ofstream os(tmp_filename, std::ios::binary);
+		if (!os.is_open()) {
+			std::cerr << "WARNING: Couldn't write snapshot \'" << tmp_filename << "\'.\n";
+			return;
+		}
+		os.write(reinterpret_cast<char const*>(&header), sizeof(header));
+		os.write(reinterpret_cast<char const*>(data.nodes.data()), data.nodes.size() * sizeof(NodeT));
+		os.write(reinterpret_cast<char const*>(data.edges.data()), data.edges.size() * sizeof(EdgeT));
+		os.write(meta.data(), meta.size());
+		os.close();
+
+		if (!os || 0 != std::rename(tmp_filename.c_str(), filename.c_str())) {
+			std::cerr << "WARNING: Couldn't write snapshot \'" << filename << "\'.\n";
+			std::remove(tmp_filename.c_str());
+		}
+	}
+
+	template<typename NodeT, typename EdgeT>
+	bool read(std::string const& filename, uint64_t key, GraphInData<NodeT, EdgeT>& data)
+	{
+		static_assert(std::is_trivially_copyable<NodeT>::value && std::is_trivially_copyable<EdgeT>::value,
+				"snapshots require trivially copyable nodes and edges");
+
+		if (!std::ifstream(filename).is_open()) return false;
+		MappedFile file(filename);
+
+		Header header;
+		if (file.size() < sizeof(header)) return false;
+		std::memcpy(&header, file.data(), sizeof(header));
+		if (0 != std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) || header.version != VERSION || header.key != key ||
+				header.node_size != sizeof(NodeT) || header.edge_size != sizeof(EdgeT)) {
+			return false;
+		}
+		uint64_t const nodes_size(header.nr_of_nodes * sizeof(NodeT));
+		uint64_t const edges_size(header.nr_of_edges * sizeof(EdgeT));
+		if (file.size() != sizeof(header) + nodes_size + edges_size + header.meta_data_size) {
+			std::cerr << "WARNING: Ignoring truncated snapshot \'" << filename << "\'.\n";
+			return false;
+		}
+
+		char const* pos(file.data() + sizeof(header));
+		data.nodes.resize(header.nr_of_nodes);
+		std::memcpy(static_cast<void*>(data.nodes.data()), pos, nodes_size);
+		pos += nodes_size;
+		data.edges.resize(header.nr_of_edges);
+		std::memcpy(static_cast<void*>(data.edges.data()), pos, edges_size);
+		pos += edges_size;
+		data.meta_data = deserializeMetaData(pos, header.meta_data_size);
+		return true;
+	}
+}
+
+}
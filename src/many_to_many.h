@@ -0,0 +1,141 @@
+#pragma once
+
+#include "defs.h"
+#include "nodes_and_edges.h"
+#include "chgraph.h"
+#include "dijkstra.h"
+
+#include <vector>
+#include <omp.h>
+
+namespace chc
+{
+
+namespace unit_tests
+{
+	void testManyToMany();
+}
+
+/*
+ * Bucket based many-to-many distance tables on a CH.
+ *
+ * The backward upward searches from all targets store (target, dist) entries
+ * in buckets at every node they settle; the forward upward search of a source
+ * then only has to scan the buckets of the nodes it settles.
+ */
+template <typename NodeT, typename EdgeT>
+class CHManyToMany
+{
+	private:
+		struct BucketEntry
+		{
+			uint target_index;
+			uint dist;
+		};
+
+		CHGraph<NodeT, EdgeT> const& _g;
+		uint _num_threads;
+
+		/* buckets of all nodes in one vector; node i owns
+		 * [_bucket_offsets[i], _bucket_offsets[i+1]) */
+		std::vector<uint> _bucket_offsets;
+		std::vector<BucketEntry> _buckets;
+
+		void _fillBuckets(std::vector<NodeID> const& targets);
+	public:
+		CHManyToMany(CHGraph<NodeT, EdgeT> const& g, uint num_threads = 1)
+			: _g(g), _num_threads(num_threads ? num_threads : 1) { }
+
+		/**
+		 * @brief Computes the distances from all sources to all targets.
+		 *
+		 * @return The table in row major order, i.e. the distance from
+		 * sources[i] to targets[j] is at index i * targets.size() + j;
+		 * c::NO_DIST if there is no path.
+		 */
+		std::vector<uint> calcTable(std::vector<NodeID> const& sources,
+				std::vector<NodeID> const& targets);
+
+		friend void unit_tests::testManyToMany();
+};
+
+template <typename NodeT, typename EdgeT>
+void CHManyToMany<NodeT, EdgeT>::_fillBuckets(std::vector<NodeID> const& targets)
+{
+	struct NodeEntry
+	{
+		NodeID node;
+		BucketEntry entry;
+	};
+
+	/* backward searches in parallel, collecting the entries per thread */
+	std::vector<std::vector<NodeEntry>> thread_entries(_num_threads);
+
+	uint size(targets.size());
+	#pragma omp parallel num_threads(_num_threads)
+	{
+		auto& entries(thread_entries[omp_get_thread_num()]);
+		CHUpwardDijkstra<NodeT, EdgeT> dij(_g);
+
+		#pragma omp for schedule(dynamic)
+		for (uint i = 0; i < size; i++) {
+			dij.run(targets[i], EdgeType::IN, [&entries, i](NodeID node, uint dist) {
+				entries.push_back(NodeEntry { node, BucketEntry { i, dist } });
+			});
+		}
+	}
+
+	/* build buckets like the offsets of the graph */
+	uint nr_of_nodes(_g.getNrOfNodes());
+	_bucket_offsets.assign(nr_of_nodes + 1, 0);
+	for (auto const& entries: thread_entries) {
+		for (auto const& node_entry: entries) {
+			_bucket_offsets[node_entry.node + 1]++;
+		}
+	}
+	for (NodeID i(0); i < nr_of_nodes; i++) {
+		_bucket_offsets[i + 1] += _bucket_offsets[i];
+	}
+
+	_buckets.resize(_bucket_offsets[nr_of_nodes]);
+	std::vector<uint> pos(_bucket_offsets.begin(), _bucket_offsets.end() - 1);
+	for (auto const& entries: thread_entries) {
+		for (auto const& node_entry: entries) {
+			_buckets[pos[node_entry.node]++] = node_entry.entry;
+		}
+	}
+}
+
+template <typename NodeT, typename EdgeT>
+std::vector<uint> CHManyToMany<NodeT, EdgeT>::calcTable(std::vector<NodeID> const& sources,
+		std::vector<NodeID> const& targets)
+{
+	std::vector<uint> table(sources.size() * targets.size(), c::NO_DIST);
+	if (table.empty()) return table;
+
+	_fillBuckets(targets);
+
+	uint size(sources.size());
+	#pragma omp parallel num_threads(_num_threads)
+	{
+		CHUpwardDijkstra<NodeT, EdgeT> dij(_g);
+
+		#pragma omp for schedule(dynamic)
+		for (uint i = 0; i < size; i++) {
+			uint* row(&table[size_t(i) * targets.size()]);
+			dij.run(sources[i], EdgeType::OUT, [this, row](NodeID node, uint dist) {
+				for (uint b(_bucket_offsets[node]), end(_bucket_offsets[node + 1]); b < end; b++) {
+					BucketEntry const& entry(_buckets[b]);
+					uint new_dist(dist + entry.dist);
+					if (new_dist < row[entry.target_index]) {
+						row[entry.target_index] = new_dist;
+					}
+				}
+			});
+		}
+	}
+
+	return table;
+}
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "defs.h"
+
+#include <string>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace chc
+{
+
+/*
+ * Read-only memory mapping of a complete file.
+ */
+class MappedFile
+{
+	private:
+		char const* _data = nullptr;
+		size_t _size = 0;
+
+		void _unmap()
+		{
+			if (_data) munmap(const_cast<char*>(_data), _size);
+			_data = nullptr;
+			_size = 0;
+		}
+	public:
+		explicit MappedFile(std::string const& filename)
+		{
+			int fd(open(filename.c_str(), O_RDONLY));
+			struct stat st;
+			if (fd < 0 || fstat(fd, &st) < 0) {
+				std::cerr << "FATAL_ERROR: Couldn't open file \'" <<
+					filename << "\'. Exiting." << std::endl;
+				std::abort();
+			}
+
+			_size = st.st_size;
+			if (_size) {
+				void* data(mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0));
+				if (MAP_FAILED == data) {
+					std::cerr << "FATAL_ERROR: Couldn't map file \'" <<
+						filename << "\'. Exiting." << std::endl;
+					std::abort();
+				}
+				_data = static_cast<char const*>(data);
+			}
+			close(fd);
+		}
+
+		~MappedFile() { _unmap(); }
+
+		MappedFile(MappedFile const&) = delete;
+		MappedFile& operator=(MappedFile const&) = delete;
+
+		MappedFile(MappedFile&& other) : _data(other._data), _size(other._size)
+		{
+			other._data = nullptr;
+			other._size = 0;
+		}
+
+		MappedFile& operator=(MappedFile&& other)
+		{
+			if (this != &other) {
+				_unmap();
+				std::swap(_data, other._data);
+				std::swap(_size, other._size);
+			}
+			return *this;
+		}
+
+		char const* data() const { return _data; }
+		size_t size() const { return _size; }
+		char const* begin() const { return _data; }
+		char const* end() const { return _data + _size; }
+
+		/* hint for sequential access (e.g. parsing) */
+		void adviseSequential() const
+		{
+			if (_data) madvise(const_cast<char*>(_data), _size, MADV_SEQUENTIAL);
+		}
+};
+
+}
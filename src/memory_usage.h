@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+namespace chc
+{
+
+/* bytes allocated by the (big) parts of a data structure */
+struct MemoryUsage
+{
+	std::vector<std::pair<std::string, size_t>> parts;
+
+	void add(std::string name, size_t bytes)
+	{
+		parts.emplace_back(std::move(name), bytes);
+	}
+
+	/* adds the parts of other, with "<prefix>." in front of their names */
+	void add(std::string const& prefix, MemoryUsage const& other)
+	{
+		for (auto const& part: other.parts) {
+			add(prefix + "." + part.first, part.second);
+		}
+	}
+
+	size_t total() const
+	{
+		size_t sum(0);
+		for (auto const& part: parts) sum += part.second;
+		return sum;
+	}
+
+	/* "total 12.3 MiB (out_edges 4.1 MiB, ...)" */
+	std::string toString() const
+	{
+		std::string str("total " + formatBytes(total()) + " (");
+		for (size_t i(0); i < parts.size(); i++) {
+			str += (i ? ", " : "") + parts[i].first + " " + formatBytes(parts[i].second);
+		}
+		return str + ")";
+	}
+
+	static std::string formatBytes(size_t bytes)
+	{
+		char buf[32];
+		std::snprintf(buf, sizeof(buf), "%.1f MiB", bytes / double(1 << 20));
+		return buf;
+	}
+};
+
+/* allocated, not used size */
+template <typename T>
+size_t memoryUsage(std::vector<T> const& vec)
+{
+	return vec.capacity() * sizeof(T);
+}
+
+inline size_t memoryUsage(std::vector<bool> const& vec)
+{
+	return vec.capacity() / 8;
+}
+
+/* peak resident set size of the process in bytes (0 if unknown) */
+inline size_t peakRSS()
+{
+#ifdef __linux__
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) return size_t(usage.ru_maxrss) * 1024;
+#endif
+	return 0;
+}
+
+}
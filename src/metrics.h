@@ -0,0 +1,95 @@
+#pragma once
+
+#include "defs.h"
+#include "nodes_and_edges.h"
+#include "file_formats.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace chc
+{
+
+namespace unit_tests
+{
+	void testMetrics();
+}
+
+/*
+ * Several metrics of one input: the edges keep their distance (dist) and
+ * travel time (metric), so CHs for all metrics can be built from one read.
+ */
+typedef MetricEdge<OSMEdge> OSMMetricEdge;
+
+enum class Metric { DIST = 0, TIME };
+static constexpr Metric LastMetric = Metric::TIME;
+
+inline Metric toMetric(std::string const& metric)
+{
+	if (metric == "DIST") {
+		return Metric::DIST;
+	}
+	else if (metric == "TIME") {
+		return Metric::TIME;
+	}
+	else {
+		std::cerr << "FATAL_ERROR: Unknown metric: " << metric << ". Exiting." << std::endl;
+		std::abort();
+	}
+}
+
+inline std::string to_string(Metric metric)
+{
+	switch (metric) {
+	case Metric::DIST:
+		return "DIST";
+	case Metric::TIME:
+		return "TIME";
+	}
+
+	std::cerr << "Unknown metric: " << static_cast<int>(metric) << "\n";
+	return "DIST";
+}
+
+/* comma separated list, e.g. "DIST,TIME" */
+inline std::vector<Metric> toMetrics(std::string const& metrics)
+{
+	std::vector<Metric> result;
+	std::istringstream is(metrics);
+	std::string metric;
+	while (std::getline(is, metric, ',')) {
+		result.push_back(toMetric(metric));
+	}
+	return result;
+}
+
+/* edges need their distance, type and speed (e.g. read as FMI_DIST) */
+template <typename NodeT, typename EdgeT>
+GraphInData<NodeT, OSMMetricEdge> calcMetrics(GraphInData<NodeT, EdgeT>&& data)
+{
+	GraphInData<NodeT, OSMMetricEdge> result{std::move(data.nodes), {}, std::move(data.meta_data)};
+	result.edges.reserve(data.edges.size());
+	for (auto const& edge: data.edges) {
+		OSMEdge const& osm_edge(edge);
+		result.edges.emplace_back(osm_edge, calcTravelTime(osm_edge));
+	}
+	data.edges.clear();
+	return result;
+}
+
+/* the graph with the weights of metric as edge distances */
+template <typename NodeT, typename EdgeT = CHEdge<OSMEdge>>
+GraphInData<NodeT, EdgeT> selectMetric(GraphInData<NodeT, OSMMetricEdge> const& data, Metric metric)
+{
+	GraphInData<NodeT, EdgeT> result{data.nodes, {}, data.meta_data};
+	result.edges.reserve(data.edges.size());
+	for (auto const& edge: data.edges) {
+		OSMEdge osm_edge(edge);
+		if (metric == Metric::TIME) osm_edge.dist = edge.metric;
+		result.edges.emplace_back(osm_edge);
+	}
+	return result;
+}
+
+}
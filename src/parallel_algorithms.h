@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <omp.h>
+
+namespace chc
+{
+
+/* below this size the sequential algorithms are used */
+size_t const PARALLEL_MIN_SIZE(1 << 14);
+
+/*
+ * Merges the sorted runs [bounds[i], bounds[i+1]) of v into one sorted
+ * range; neighbouring runs are merged pairwise in parallel. Equal elements
+ * keep the order of their runs.
+ */
+template<typename T, typename Compare>
+void parallelMergeRuns(std::vector<T>& v, std::vector<size_t> const& bounds, Compare comp)
+{
+	size_t const nr_of_runs(bounds.empty() ? 0 : bounds.size() - 1);
+	for (size_t width(1); width < nr_of_runs; width *= 2) {
+		size_t const nr_of_merges((nr_of_runs - width + 2*width - 1) / (2*width));
+		#pragma omp parallel for schedule(dynamic)
+		for (size_t k = 0; k < nr_of_merges; k++) {
+			size_t const first(2*width*k);
+			size_t const last(std::min(first + 2*width, nr_of_runs));
+			std::inplace_merge(v.begin() + bounds[first], v.begin() + bounds[first + width],
+					v.begin() + bounds[last], comp);
+		}
+	}
+}
+
+/*
+ * Stable sort: every thread sorts one block, then neighbouring blocks are
+ * merged pairwise in parallel. The result doesn't depend on the number of
+ * threads.
+ */
+template<typename T, typename Compare>
+void parallelStableSort(std::vector<T>& v, Compare comp)
+{
+	size_t const size(v.size());
+	size_t const nr_of_blocks(omp_get_max_threads());
+	if (size < PARALLEL_MIN_SIZE || nr_of_blocks < 2) {
+		std::stable_sort(v.begin(), v.end(), comp);
+		return;
+	}
+
+	std::vector<size_t> bounds(nr_of_blocks + 1);
+	for (size_t i(0); i <= nr_of_blocks; i++) {
+		bounds[i] = size * i / nr_of_blocks;
+	}
+
+	#pragma omp parallel for schedule(static)
+	for (size_t i = 0; i < nr_of_blocks; i++) {
+		std::stable_sort(v.begin() + bounds[i], v.begin() + bounds[i+1], comp);
+	}
+
+	parallelMergeRuns(v, bounds, comp);
+}
+
+/*
+ * Removes all elements v[i] with remove(i) == true, keeping the order of
+ * the remaining elements. remove(i) is evaluated for all elements before
+ * anything is moved, so it may look at other elements. Returns the number
+ * of removed elements.
+ */
+template<typename T, typename Predicate>
+size_t parallelRemoveIf(std::vector<T>& v, Predicate&& remove)
+{
+	size_t const size(v.size());
+	size_t const nr_of_blocks(omp_get_max_threads());
+
+	std::vector<char> keep(size);
+	std::vector<size_t> bounds(nr_of_blocks + 1);
+	std::vector<size_t> offsets(nr_of_blocks + 1, 0);
+	for (size_t i(0); i <= nr_of_blocks; i++) {
+		bounds[i] = size * i / nr_of_blocks;
+	}
+
+	#pragma omp parallel for schedule(static)
+	for (size_t b = 0; b < nr_of_blocks; b++) {
+		for (size_t i(bounds[b]); i < bounds[b+1]; i++) {
+			keep[i] = !remove(i);
+			offsets[b+1] += keep[i];
+		}
+	}
+	for (size_t b(0); b < nr_of_blocks; b++) {
+		offsets[b+1] += offsets[b];
+	}
+
+	size_t const removed(size - offsets[nr_of_blocks]);
+	if (!removed) return 0;
+
+	std::vector<T> result(offsets[nr_of_blocks]);
+	#pragma omp parallel for schedule(static)
+	for (size_t b = 0; b < nr_of_blocks; b++) {
+		size_t pos(offsets[b]);
+		for (size_t i(bounds[b]); i < bounds[b+1]; i++) {
+			if (keep[i]) result[pos++] = std::move(v[i]);
+		}
+	}
+	v.swap(result);
+
+	return removed;
+}
+
+}
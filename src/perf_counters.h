@@ -0,0 +1,91 @@
+#pragma once
+
+/* hardware performance counters of the process (Linux perf_event_open, no
+ * other dependencies); like track_time.h everything is inlined
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+/*
+ * Opens the counters cycles, instructions, llc_misses (last level cache read
+ * misses) and dtlb_misses (data TLB read misses) for user space code of this
+ * thread and the threads it creates afterwards - so create it before the
+ * first parallel region. Counters the machine (or the permissions, see
+ * /proc/sys/kernel/perf_event_paranoid) doesn't allow are left out; empty()
+ * tells if there are any. Values are scaled if the kernel multiplexes them.
+ */
+class PerfCounters {
+private:
+	std::vector<std::string> counter_names;
+	std::vector<int> fds;
+
+#ifdef __linux__
+	void open(char const* name, uint32_t type, uint64_t config)
+	{
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = type;
+		attr.config = config;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.inherit = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		int fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+		if (fd < 0) return;
+		counter_names.emplace_back(name);
+		fds.push_back(fd);
+	}
+
+	static uint64_t cacheConfig(uint64_t cache)
+	{
+		return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	}
+#endif
+
+public:
+	PerfCounters()
+	{
+#ifdef __linux__
+		open("cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+		open("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+		open("llc_misses", PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_LL));
+		open("dtlb_misses", PERF_TYPE_HW_CACHE, cacheConfig(PERF_COUNT_HW_CACHE_DTLB));
+#endif
+	}
+	~PerfCounters()
+	{
+#ifdef __linux__
+		for (int fd: fds) close(fd);
+#endif
+	}
+	PerfCounters(PerfCounters const&) = delete;
+	PerfCounters& operator=(PerfCounters const&) = delete;
+
+	bool empty() const { return fds.empty(); }
+	std::vector<std::string> const& names() const { return counter_names; }
+
+	/* current values, in the order of names() */
+	std::vector<uint64_t> read() const
+	{
+		std::vector<uint64_t> values(fds.size(), 0);
+#ifdef __linux__
+		for (size_t i(0); i < fds.size(); i++) {
+			uint64_t buf[3]; /* value, time enabled, time running */
+			if (::read(fds[i], buf, sizeof(buf)) != sizeof(buf) || buf[2] == 0) continue;
+			values[i] = buf[2] < buf[1] ? uint64_t(double(buf[0]) * buf[1] / buf[2]) : buf[0];
+		}
+#endif
+		return values;
+	}
+};
@@ -0,0 +1,256 @@
+#pragma once
+
+#include "defs.h"
+#include "nodes_and_edges.h"
+
+#include <vector>
+#include <queue>
+#include <limits>
+#include <algorithm>
+
+namespace chc
+{
+
+namespace unit_tests
+{
+	void testPHAST();
+}
+
+/*
+ * PHAST: one-to-all distances on a CH.
+ *
+ * An upward search from the source is followed by a linear sweep over all
+ * nodes in descending level order, relaxing the downward edges into each
+ * node. Nodes are renumbered by their position in the sweep ("rank") and the
+ * downward edges are stored contiguously in sweep order, so the sweep is a
+ * single pass over memory.
+ *
+ * Several sources can be handled in one sweep: the distances of LANES
+ * sources are stored next to each other per node, and the inner loop over the
+ * lanes is vectorized.
+ */
+template <typename NodeT, typename EdgeT>
+class PHAST
+{
+	public:
+		static constexpr size_t LANES = 8;
+
+	protected:
+		typedef CHEdge<EdgeT> Shortcut;
+
+		/* "infinity" which can't overflow when adding an edge distance */
+		static constexpr uint INF = std::numeric_limits<uint>::max() / 2;
+
+		struct RankEdge
+		{
+			uint other_rank;
+			uint dist;
+		};
+
+		struct PQElement
+		{
+			uint rank;
+			uint _dist;
+
+			PQElement(uint rank, uint dist) : rank(rank), _dist(dist) {}
+
+			bool operator>(PQElement const& other) const { return _dist > other._dist; }
+			uint distance() const { return _dist; }
+		};
+		typedef std::priority_queue<
+			PQElement, std::vector<PQElement>, std::greater<PQElement> > PQ;
+
+		uint _nr_of_nodes;
+
+		/* node id -> position in sweep order and vice versa */
+		std::vector<uint> _rank;
+		std::vector<NodeID> _node;
+
+		/* upward edges by source rank */
+		std::vector<uint> _up_offsets;
+		std::vector<RankEdge> _up_edges;
+
+		/* downward edges by target rank; other_rank is the source */
+		std::vector<uint> _down_offsets;
+		std::vector<RankEdge> _down_edges;
+
+		/* upward search; writes the tentative distances in lane <lane> and
+		 * optionally collects the ranks of all reached nodes in <reached> */
+		void _upwardSearch(uint src_rank, uint* dists, size_t lanes, size_t lane,
+				std::vector<uint>* reached = nullptr) const;
+		template <size_t K>
+		void _sweep(std::vector<uint>& dists) const;
+		template <size_t K>
+		void _calcDists(NodeID const* sources, size_t nr_of_sources,
+				std::vector<std::vector<uint>>& results, std::vector<uint>& dists) const;
+	public:
+		PHAST(GraphCHOutData<NodeT, Shortcut> const& data);
+
+		uint getNrOfNodes() const { return _nr_of_nodes; }
+
+		/* distances from src to all nodes (indexed by node id), c::NO_DIST if unreachable */
+		std::vector<uint> calcDists(NodeID src) const;
+		/* result[i] are the distances from sources[i]; LANES sources per sweep */
+		std::vector<std::vector<uint>> calcDists(std::vector<NodeID> const& sources) const;
+
+		friend void unit_tests::testPHAST();
+};
+
+template <typename NodeT, typename EdgeT>
+constexpr size_t PHAST<NodeT, EdgeT>::LANES;
+
+template <typename NodeT, typename EdgeT>
+constexpr uint PHAST<NodeT, EdgeT>::INF;
+
+template <typename NodeT, typename EdgeT>
+PHAST<NodeT, EdgeT>::PHAST(GraphCHOutData<NodeT, Shortcut> const& data)
+	: _nr_of_nodes(data.nodes.size())
+{
+	auto const& lvls(data.node_levels);
+
+	/* sweep order: descending level */
+	_node.resize(_nr_of_nodes);
+	for (NodeID i(0); i < _nr_of_nodes; i++) {
+		_node[i] = i;
+	}
+	std::stable_sort(_node.begin(), _node.end(), [&lvls](NodeID a, NodeID b) {
+		return lvls[a] > lvls[b];
+	});
+	_rank.resize(_nr_of_nodes);
+	for (uint r(0); r < _nr_of_nodes; r++) {
+		_rank[_node[r]] = r;
+	}
+
+	/* count edges per rank */
+	_up_offsets.assign(_nr_of_nodes + 1, 0);
+	_down_offsets.assign(_nr_of_nodes + 1, 0);
+	for (auto const& edge: data.edges) {
+		assert(lvls[edge.src] != lvls[edge.tgt]);
+		if (lvls[edge.src] < lvls[edge.tgt]) {
+			_up_offsets[_rank[edge.src] + 1]++;
+		}
+		else {
+			_down_offsets[_rank[edge.tgt] + 1]++;
+		}
+	}
+	for (uint r(0); r < _nr_of_nodes; r++) {
+		_up_offsets[r + 1] += _up_offsets[r];
+		_down_offsets[r + 1] += _down_offsets[r];
+	}
+
+	/* fill */
+	_up_edges.resize(_up_offsets[_nr_of_nodes]);
+	_down_edges.resize(_down_offsets[_nr_of_nodes]);
+	std::vector<uint> up_pos(_up_offsets.begin(), _up_offsets.end() - 1);
+	std::vector<uint> down_pos(_down_offsets.begin(), _down_offsets.end() - 1);
+	for (auto const& edge: data.edges) {
+		uint src_rank(_rank[edge.src]);
+		uint tgt_rank(_rank[edge.tgt]);
+		if (lvls[edge.src] < lvls[edge.tgt]) {
+			_up_edges[up_pos[src_rank]++] = RankEdge { tgt_rank, edge.distance() };
+		}
+		else {
+			_down_edges[down_pos[tgt_rank]++] = RankEdge { src_rank, edge.distance() };
+		}
+	}
+
+	/* relax downward edges in order of their source for better locality */
+	for (uint r(0); r < _nr_of_nodes; r++) {
+		std::sort(_down_edges.begin() + _down_offsets[r], _down_edges.begin() + _down_offsets[r + 1],
+			[](RankEdge const& a, RankEdge const& b) { return a.other_rank < b.other_rank; });
+	}
+}
+
+template <typename NodeT, typename EdgeT>
+void PHAST<NodeT, EdgeT>::_upwardSearch(uint src_rank, uint* dists, size_t lanes, size_t lane,
+		std::vector<uint>* reached) const
+{
+	PQ pq;
+	pq.push(PQElement(src_rank, 0));
+	dists[src_rank * lanes + lane] = 0;
+	if (reached) reached->push_back(src_rank);
+
+	while (!pq.empty()) {
+		PQElement top(pq.top());
+		pq.pop();
+
+		if (dists[top.rank * lanes + lane] != top.distance()) continue;
+
+		for (uint e(_up_offsets[top.rank]), end(_up_offsets[top.rank + 1]); e < end; e++) {
+			RankEdge const& edge(_up_edges[e]);
+			uint new_dist(top.distance() + edge.dist);
+			uint& dist(dists[edge.other_rank * lanes + lane]);
+			if (new_dist < dist) {
+				if (reached && INF == dist) reached->push_back(edge.other_rank);
+				dist = new_dist;
+				pq.push(PQElement(edge.other_rank, new_dist));
+			}
+		}
+	}
+}
+
+template <typename NodeT, typename EdgeT>
+template <size_t K>
+void PHAST<NodeT, EdgeT>::_sweep(std::vector<uint>& dists) const
+{
+	uint* d(dists.data());
+	for (uint r(0); r < _nr_of_nodes; r++) {
+		uint* tgt(d + size_t(r) * K);
+		for (uint e(_down_offsets[r]), end(_down_offsets[r + 1]); e < end; e++) {
+			RankEdge const edge(_down_edges[e]);
+			uint const* src(d + size_t(edge.other_rank) * K);
+			#pragma omp simd
+			for (size_t k = 0; k < K; k++) {
+				uint new_dist(src[k] + edge.dist);
+				tgt[k] = new_dist < tgt[k] ? new_dist : tgt[k];
+			}
+		}
+	}
+}
+
+template <typename NodeT, typename EdgeT>
+template <size_t K>
+void PHAST<NodeT, EdgeT>::_calcDists(NodeID const* sources, size_t nr_of_sources,
+		std::vector<std::vector<uint>>& results, std::vector<uint>& dists) const
+{
+	assert(nr_of_sources <= K);
+
+	dists.assign(size_t(_nr_of_nodes) * K, INF);
+	for (size_t k(0); k < nr_of_sources; k++) {
+		_upwardSearch(_rank[sources[k]], dists.data(), K, k);
+	}
+
+	_sweep<K>(dists);
+
+	for (size_t k(0); k < nr_of_sources; k++) {
+		std::vector<uint> result(_nr_of_nodes);
+		for (NodeID node(0); node < _nr_of_nodes; node++) {
+			uint dist(dists[size_t(_rank[node]) * K + k]);
+			result[node] = dist >= INF ? c::NO_DIST : dist;
+		}
+		results.push_back(std::move(result));
+	}
+}
+
+template <typename NodeT, typename EdgeT>
+std::vector<uint> PHAST<NodeT, EdgeT>::calcDists(NodeID src) const
+{
+	std::vector<std::vector<uint>> results;
+	std::vector<uint> dists;
+	_calcDists<1>(&src, 1, results, dists);
+	return std::move(results.front());
+}
+
+template <typename NodeT, typename EdgeT>
+std::vector<std::vector<uint>> PHAST<NodeT, EdgeT>::calcDists(std::vector<NodeID> const& sources) const
+{
+	std::vector<std::vector<uint>> results;
+	results.reserve(sources.size());
+	std::vector<uint> dists;
+	for (size_t i(0); i < sources.size(); i += LANES) {
+		_calcDists<LANES>(sources.data() + i, std::min(LANES, sources.size() - i), results, dists);
+	}
+	return results;
+}
+
+}
@@ -3,6 +3,7 @@
 #include "prioritizer.h"
 #include "nodes_and_edges.h"
 
+#include <algorithm>
 #include <memory>
 
 namespace chc
@@ -206,6 +207,86 @@ bool EdgeDiffPrioritizer<GraphT, CHConstructorT>::hasNodesLeft()
 	return !_prio_vec.empty();
 }
 
+/*
+ * Prioritizer that replays the levels of another CH of the same graph (e.g.
+ * one for another metric), so the expensive choice of the nodes is done only
+ * once. As the shortcuts differ, nodes of a level may be adjacent now; those
+ * are put in front of the next level.
+ * Not part of PrioritizerType as it needs the levels.
+ */
+template <class GraphT, class CHConstructorT>
+class LevelPrioritizer : public Prioritizer
+{
+	private:
+		GraphT const& _base_graph;
+		CHConstructorT const& _chc;
+		/* nodes by level, highest level first, so the next ones are at the end */
+		std::vector<std::vector<NodeID>> _levels;
+		std::vector<NodeID> _deferred;
+	public:
+		LevelPrioritizer(GraphT const& base_graph, CHConstructorT const& chc, std::vector<uint> const& node_levels)
+			: _base_graph(base_graph), _chc(chc)
+		{
+			for (NodeID node(0); node < node_levels.size(); node++) {
+				uint const lvl(node_levels[node]);
+				if (lvl == c::NO_LVL) continue; /* wasn't contracted */
+				if (lvl >= _levels.size()) _levels.resize(lvl + 1);
+				_levels[lvl].push_back(node);
+			}
+			std::reverse(_levels.begin(), _levels.end());
+		}
+		void init(std::vector<NodeID>& node_ids); // only keeps the levels of node_ids
+		std::vector<NodeID> extractNextNodes();
+		bool hasNodesLeft();
+};
+
+template <class GraphT, class CHConstructorT>
+void LevelPrioritizer<GraphT, CHConstructorT>::init(std::vector<NodeID>& node_ids)
+{
+	std::vector<bool> contained(_base_graph.getNrOfNodes(), false);
+	for (auto node: node_ids) {
+		contained[node] = true;
+	}
+	for (auto& level: _levels) {
+		level.erase(std::remove_if(level.begin(), level.end(),
+				[&contained](NodeID node) { return !contained[node]; }), level.end());
+	}
+	_levels.erase(std::remove_if(_levels.begin(), _levels.end(),
+			[](std::vector<NodeID> const& level) { return level.empty(); }), _levels.end());
+	node_ids.clear();
+}
+
+template <class GraphT, class CHConstructorT>
+std::vector<NodeID> LevelPrioritizer<GraphT, CHConstructorT>::extractNextNodes()
+{
+	assert(hasNodesLeft());
+
+	std::vector<NodeID> candidates(std::move(_deferred));
+	if (!_levels.empty()) {
+		candidates.insert(candidates.end(), _levels.back().begin(), _levels.back().end());
+		_levels.pop_back();
+	}
+
+	/* greedy in order of the candidates, so deferred nodes come first */
+	auto next_nodes(_chc.calcIndependentSet(candidates));
+	std::vector<bool> chosen(_base_graph.getNrOfNodes(), false);
+	for (auto node: next_nodes) {
+		chosen[node] = true;
+	}
+	_deferred.clear();
+	for (auto node: candidates) {
+		if (!chosen[node]) _deferred.push_back(node);
+	}
+
+	return next_nodes;
+}
+
+template <class GraphT, class CHConstructorT>
+bool LevelPrioritizer<GraphT, CHConstructorT>::hasNodesLeft()
+{
+	return !_levels.empty() || !_deferred.empty();
+}
+
 /*
  * New Prioritizers have to be included into the enum and the createPrioritizer function.
  */
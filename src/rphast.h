@@ -0,0 +1,206 @@
+#pragma once
+
+#include "defs.h"
+#include "nodes_and_edges.h"
+#include "phast.h"
+
+#include <vector>
+#include <omp.h>
+
+namespace chc
+{
+
+namespace unit_tests
+{
+	void testRPHAST();
+}
+
+/*
+ * RPHAST: one-to-many distances to a fixed target set.
+ *
+ * selectTargets() extracts the part of the hierarchy the targets can be
+ * reached from (all nodes reachable from the targets by reversed downward
+ * edges) once; afterwards each source query is an upward search followed by
+ * a sweep over the selected nodes only.
+ */
+template <typename NodeT, typename EdgeT>
+class RPHAST : protected PHAST<NodeT, EdgeT>
+{
+	private:
+		typedef PHAST<NodeT, EdgeT> BasePHAST;
+		typedef typename BasePHAST::Shortcut Shortcut;
+		typedef typename BasePHAST::RankEdge RankEdge;
+		using BasePHAST::INF;
+		using BasePHAST::_nr_of_nodes;
+		using BasePHAST::_rank;
+		using BasePHAST::_down_offsets;
+		using BasePHAST::_down_edges;
+
+		/* selected nodes (as ranks) in sweep order */
+		std::vector<uint> _selected;
+		/* rank -> index in _selected (c::NO_NID if not selected) */
+		std::vector<uint> _selected_index;
+		/* indices of the targets in _selected */
+		std::vector<uint> _target_index;
+
+		/* restricted downward edges by target index; other_rank is the
+		 * index of the source in _selected */
+		std::vector<uint> _sel_down_offsets;
+		std::vector<RankEdge> _sel_down_edges;
+
+		/* per query data */
+		struct QueryData
+		{
+			std::vector<uint> up_dists;
+			std::vector<uint> reached;
+			std::vector<uint> dists;
+		};
+		void _initQueryData(QueryData& qd) const;
+		void _calcDists(NodeID src, QueryData& qd, uint* result) const;
+	public:
+		RPHAST(GraphCHOutData<NodeT, Shortcut> const& data) : BasePHAST(data) { }
+
+		using BasePHAST::getNrOfNodes;
+
+		void selectTargets(std::vector<NodeID> const& targets);
+		uint getNrOfSelectedNodes() const { return _selected.size(); }
+		uint getNrOfTargets() const { return _target_index.size(); }
+
+		/* distances from src to the selected targets (in the order they were given) */
+		std::vector<uint> calcDists(NodeID src) const;
+		/* row major table: distance from sources[i] to target j at i * getNrOfTargets() + j */
+		std::vector<uint> calcTable(std::vector<NodeID> const& sources, uint num_threads = 1) const;
+
+		friend void unit_tests::testRPHAST();
+};
+
+template <typename NodeT, typename EdgeT>
+void RPHAST<NodeT, EdgeT>::selectTargets(std::vector<NodeID> const& targets)
+{
+	/* collect all nodes reachable from the targets by reversed downward edges */
+	std::vector<bool> selected(_nr_of_nodes, false);
+	std::vector<uint> stack;
+	for (NodeID target: targets) {
+		uint rank(_rank[target]);
+		if (!selected[rank]) {
+			selected[rank] = true;
+			stack.push_back(rank);
+		}
+	}
+	while (!stack.empty()) {
+		uint rank(stack.back());
+		stack.pop_back();
+		for (uint e(_down_offsets[rank]), end(_down_offsets[rank + 1]); e < end; e++) {
+			uint src_rank(_down_edges[e].other_rank);
+			if (!selected[src_rank]) {
+				selected[src_rank] = true;
+				stack.push_back(src_rank);
+			}
+		}
+	}
+
+	/* ranks are the sweep order already */
+	_selected.clear();
+	_selected_index.assign(_nr_of_nodes, c::NO_NID);
+	for (uint rank(0); rank < _nr_of_nodes; rank++) {
+		if (selected[rank]) {
+			_selected_index[rank] = _selected.size();
+			_selected.push_back(rank);
+		}
+	}
+
+	_target_index.clear();
+	for (NodeID target: targets) {
+		_target_index.push_back(_selected_index[_rank[target]]);
+	}
+
+	/* copy the restricted downward graph */
+	_sel_down_offsets.assign(1, 0);
+	_sel_down_edges.clear();
+	for (uint rank: _selected) {
+		for (uint e(_down_offsets[rank]), end(_down_offsets[rank + 1]); e < end; e++) {
+			RankEdge const& edge(_down_edges[e]);
+			assert(c::NO_NID != _selected_index[edge.other_rank]);
+			_sel_down_edges.push_back(RankEdge { _selected_index[edge.other_rank], edge.dist });
+		}
+		_sel_down_offsets.push_back(_sel_down_edges.size());
+	}
+
+	Print("RPHAST selected " << _selected.size() << " of " << _nr_of_nodes << " nodes and "
+			<< _sel_down_edges.size() << " of " << _down_edges.size() << " downward edges for "
+			<< targets.size() << " targets.");
+}
+
+template <typename NodeT, typename EdgeT>
+void RPHAST<NodeT, EdgeT>::_initQueryData(QueryData& qd) const
+{
+	qd.up_dists.assign(_nr_of_nodes, INF);
+	qd.reached.clear();
+	qd.dists.resize(_selected.size());
+}
+
+template <typename NodeT, typename EdgeT>
+void RPHAST<NodeT, EdgeT>::_calcDists(NodeID src, QueryData& qd, uint* result) const
+{
+	/* upward search on the complete upward graph */
+	BasePHAST::_upwardSearch(_rank[src], qd.up_dists.data(), 1, 0, &qd.reached);
+
+	for (uint i(0), size(_selected.size()); i < size; i++) {
+		qd.dists[i] = qd.up_dists[_selected[i]];
+	}
+	for (uint rank: qd.reached) {
+		qd.up_dists[rank] = INF;
+	}
+	qd.reached.clear();
+
+	/* sweep over the restricted downward graph */
+	uint* d(qd.dists.data());
+	for (uint i(0), size(_selected.size()); i < size; i++) {
+		uint dist(d[i]);
+		for (uint e(_sel_down_offsets[i]), end(_sel_down_offsets[i + 1]); e < end; e++) {
+			RankEdge const edge(_sel_down_edges[e]);
+			uint new_dist(d[edge.other_rank] + edge.dist);
+			dist = new_dist < dist ? new_dist : dist;
+		}
+		d[i] = dist;
+	}
+
+	for (uint j(0), size(_target_index.size()); j < size; j++) {
+		uint dist(d[_target_index[j]]);
+		result[j] = dist >= INF ? c::NO_DIST : dist;
+	}
+}
+
+template <typename NodeT, typename EdgeT>
+std::vector<uint> RPHAST<NodeT, EdgeT>::calcDists(NodeID src) const
+{
+	QueryData qd;
+	_initQueryData(qd);
+
+	std::vector<uint> result(_target_index.size());
+	_calcDists(src, qd, result.data());
+	return result;
+}
+
+template <typename NodeT, typename EdgeT>
+std::vector<uint> RPHAST<NodeT, EdgeT>::calcTable(std::vector<NodeID> const& sources, uint num_threads) const
+{
+	std::vector<uint> table(sources.size() * _target_index.size());
+	if (table.empty()) return table;
+
+	uint size(sources.size());
+	#pragma omp parallel num_threads(num_threads ? num_threads : 1)
+	{
+		QueryData qd;
+		_initQueryData(qd);
+
+		#pragma omp for schedule(dynamic)
+		for (uint i = 0; i < size; i++) {
+			_calcDists(sources[i], qd, &table[size_t(i) * _target_index.size()]);
+		}
+	}
+
+	return table;
+}
+
+}
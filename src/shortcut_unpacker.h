@@ -0,0 +1,139 @@
+#pragma once
+
+#include "defs.h"
+#include "nodes_and_edges.h"
+#include "chgraph.h"
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+
+namespace chc
+{
+
+namespace unit_tests
+{
+	void testShortcutUnpacker();
+}
+
+/*
+ * Expands paths of shortcuts (e.g. from CHDijkstra::calcShopa) into
+ * original edges or node sequences.
+ *
+ * Keeps an optional LRU cache of fully unpacked top-level shortcuts, as
+ * the same (long) shortcuts are unpacked over and over again in path queries.
+ * Not thread safe - use one unpacker per thread. GraphT is a CHGraph or a
+ * view with the same interface, e.g. FormatBINARY_CH::MappedCH.
+ */
+template <typename NodeT, typename EdgeT, typename GraphT = CHGraph<NodeT, EdgeT>>
+class ShortcutUnpacker
+{
+	private:
+		typedef std::list<std::pair<EdgeID, std::vector<EdgeID>>> LRUList;
+
+		GraphT const& _g;
+
+		/* max number of cached shortcuts; 0 disables the cache */
+		size_t _cache_size;
+		LRUList _lru; /* most recently used first */
+		std::unordered_map<EdgeID, typename LRUList::iterator> _cache;
+
+		size_t _hits = 0;
+		size_t _misses = 0;
+
+		void _unpackEdge(EdgeID edge_id, std::vector<EdgeID>& path);
+	public:
+		ShortcutUnpacker(GraphT const& g, size_t cache_size = 0)
+			: _g(g), _cache_size(cache_size) { }
+
+		/* <path> has to be in path order, like the result of CHDijkstra::calcShopa */
+		std::vector<EdgeID> unpackPath(std::vector<EdgeID> const& path);
+		/* starts with src, so a path of length 0 gives {src} */
+		std::vector<NodeID> unpackPathNodeIDs(NodeID src, std::vector<EdgeID> const& path);
+		/* nodes include coordinates for geo node types */
+		std::vector<NodeT> unpackPathNodes(NodeID src, std::vector<EdgeID> const& path);
+
+		void clearCache();
+		size_t getCacheHits() const { return _hits; }
+		size_t getCacheMisses() const { return _misses; }
+
+		friend void unit_tests::testShortcutUnpacker();
+};
+
+template <typename NodeT, typename EdgeT, typename GraphT>
+void ShortcutUnpacker<NodeT, EdgeT, GraphT>::_unpackEdge(EdgeID edge_id, std::vector<EdgeID>& path)
+{
+	/* original edges are never cached */
+	if (0 == _cache_size || c::NO_EID == _g.getEdge(edge_id).child_edge1) {
+		_g.unpackEdge(edge_id, path);
+		return;
+	}
+
+	auto it(_cache.find(edge_id));
+	if (it != _cache.end()) {
+		++_hits;
+		_lru.splice(_lru.begin(), _lru, it->second);
+		auto const& edges(it->second->second);
+		path.insert(path.end(), edges.begin(), edges.end());
+		return;
+	}
+
+	++_misses;
+	std::vector<EdgeID> edges;
+	_g.unpackEdge(edge_id, edges);
+	path.insert(path.end(), edges.begin(), edges.end());
+
+	if (_lru.size() >= _cache_size) {
+		_cache.erase(_lru.back().first);
+		_lru.pop_back();
+	}
+	_lru.emplace_front(edge_id, std::move(edges));
+	_cache[edge_id] = _lru.begin();
+}
+
+template <typename NodeT, typename EdgeT, typename GraphT>
+std::vector<EdgeID> ShortcutUnpacker<NodeT, EdgeT, GraphT>::unpackPath(std::vector<EdgeID> const& path)
+{
+	std::vector<EdgeID> unpacked_path;
+	unpacked_path.reserve(path.size());
+	for (EdgeID edge_id: path) {
+		_unpackEdge(edge_id, unpacked_path);
+	}
+	return unpacked_path;
+}
+
+template <typename NodeT, typename EdgeT, typename GraphT>
+std::vector<NodeID> ShortcutUnpacker<NodeT, EdgeT, GraphT>::unpackPathNodeIDs(NodeID src, std::vector<EdgeID> const& path)
+{
+	auto edges(unpackPath(path));
+	std::vector<NodeID> nodes;
+	nodes.reserve(edges.size() + 1);
+	nodes.push_back(src);
+	for (EdgeID edge_id: edges) {
+		auto const& edge(_g.getEdge(edge_id));
+		assert(edge.src == nodes.back());
+		nodes.push_back(edge.tgt);
+	}
+	return nodes;
+}
+
+template <typename NodeT, typename EdgeT, typename GraphT>
+std::vector<NodeT> ShortcutUnpacker<NodeT, EdgeT, GraphT>::unpackPathNodes(NodeID src, std::vector<EdgeID> const& path)
+{
+	std::vector<NodeT> nodes;
+	for (NodeID node_id: unpackPathNodeIDs(src, path)) {
+		nodes.push_back(_g.getNode(node_id));
+	}
+	return nodes;
+}
+
+template <typename NodeT, typename EdgeT, typename GraphT>
+void ShortcutUnpacker<NodeT, EdgeT, GraphT>::clearCache()
+{
+	_cache.clear();
+	_lru.clear();
+	_hits = 0;
+	_misses = 0;
+}
+
+}
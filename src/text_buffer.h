@@ -0,0 +1,137 @@
+#pragma once
+
+#include "defs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+namespace chc
+{
+
+namespace unit_tests
+{
+	void testTextBuffer();
+}
+
+/*
+ * Growing character buffer with fast formatting of numbers, used by the text
+ * writers instead of std::ostream << (no locale, no temporary strings).
+ *
+ * Doubles are written in fixed notation like std::fixed; the fast path is
+ * only taken if the rounding is certain, otherwise snprintf is used, so the
+ * output is the same as with std::ostream.
+ */
+class TextBuffer
+{
+	private:
+		std::vector<char> _data;
+		size_t _size = 0;
+
+		/* makes room for n more characters and returns a pointer to them */
+		char* _grow(size_t n)
+		{
+			if (_size + n > _data.size()) {
+				_data.resize(std::max(2 * _data.size(), _size + n));
+			}
+			char* pos(_data.data() + _size);
+			_size += n;
+			return pos;
+		}
+
+		void _appendDigits(uint64_t value)
+		{
+			char digits[20];
+			char* pos(digits + sizeof(digits));
+			do {
+				*--pos = '0' + value % 10;
+				value /= 10;
+			} while (value);
+			append(pos, digits + sizeof(digits) - pos);
+		}
+
+		void _appendFixedSlow(double value, uint precision)
+		{
+			char buffer[512];
+			int n(std::snprintf(buffer, sizeof(buffer), "%.*f", int(precision), value));
+			if (n > 0) append(buffer, std::min(size_t(n), sizeof(buffer) - 1));
+		}
+	public:
+		explicit TextBuffer(size_t capacity = 0) : _data(capacity) { }
+
+		char const* data() const { return _data.data(); }
+		size_t size() const { return _size; }
+		bool empty() const { return 0 == _size; }
+		void clear() { _size = 0; }
+
+		void append(char const* str, size_t n) { if (n) std::memcpy(_grow(n), str, n); }
+		void append(char const* str) { append(str, std::strlen(str)); }
+		void append(char c) { *_grow(1) = c; }
+
+		template<typename T, typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type* = nullptr>
+		void append(T value) { _appendDigits(value); }
+
+		template<typename T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type* = nullptr>
+		void append(T value)
+		{
+			if (value < 0) {
+				append('-');
+				_appendDigits(uint64_t(0) - uint64_t(value));
+			}
+			else {
+				_appendDigits(value);
+			}
+		}
+
+		/* like std::fixed with std::setprecision(precision) */
+		void appendFixed(double value, uint precision = 7);
+
+		void writeTo(std::ostream& os) const { os.write(_data.data(), _size); }
+
+		friend void unit_tests::testTextBuffer();
+};
+
+inline void TextBuffer::appendFixed(double value, uint precision)
+{
+	static uint64_t const pow10[] = { 1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull,
+		1000000ull, 10000000ull, 100000000ull, 1000000000ull };
+	if (precision >= sizeof(pow10) / sizeof(pow10[0]) || !std::isfinite(value)) {
+		_appendFixedSlow(value, precision);
+		return;
+	}
+
+	/* scaling by an exact power of ten adds one rounding error of at most
+	 * half an ulp; only round ourselves if that can't change the result */
+	double const scaled(std::fabs(value) * pow10[precision]);
+	if (scaled >= 9007199254740992.0 /* 2^53 */) {
+		_appendFixedSlow(value, precision);
+		return;
+	}
+	double const floor_scaled(std::floor(scaled));
+	double const margin(scaled * std::numeric_limits<double>::epsilon());
+	if (std::fabs(scaled - floor_scaled - 0.5) <= margin) {
+		_appendFixedSlow(value, precision);
+		return;
+	}
+	uint64_t const rounded(uint64_t(floor_scaled) + (scaled - floor_scaled > 0.5 ? 1 : 0));
+
+	if (std::signbit(value)) append('-');
+	_appendDigits(rounded / pow10[precision]);
+	if (precision) {
+		append('.');
+		uint64_t fraction(rounded % pow10[precision]);
+		char* pos(_grow(precision) + precision);
+		for (uint i(0); i < precision; i++) {
+			*--pos = '0' + fraction % 10;
+			fraction /= 10;
+		}
+	}
+}
+
+}
@@ -0,0 +1,244 @@
+#pragma once
+
+#include "defs.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace chc
+{
+
+namespace unit_tests
+{
+	void testTextScanner();
+}
+
+/*
+ * Parses whitespace separated numbers from an in-memory buffer (e.g. a
+ * MappedFile), replacing the std::istream >> operators of the text readers.
+ *
+ * Like operator>>, every read skips leading whitespace (including newlines).
+ * Numbers are parsed by hand; the buffer doesn't need to be null terminated.
+ * All parse errors abort with the line number of the error.
+ */
+class TextScanner
+{
+	private:
+		char const* _begin;
+		char const* _pos;
+		char const* _end;
+
+		static bool _isSpace(char c) { return ' ' == c || '\t' == c || '\r' == c || '\v' == c || '\f' == c; }
+		static bool _isDigit(char c) { return c >= '0' && c <= '9'; }
+
+		void _skipWhitespace()
+		{
+			while (_pos != _end && (_isSpace(*_pos) || '\n' == *_pos)) ++_pos;
+		}
+
+		/* returns true for a '-' sign */
+		bool _readSign()
+		{
+			if (_pos != _end && ('-' == *_pos || '+' == *_pos)) {
+				return '-' == *_pos++;
+			}
+			return false;
+		}
+
+		/* at least one digit; aborts on overflow of uint64_t */
+		uint64_t _readDigits(char const* what)
+		{
+			if (_pos == _end || !_isDigit(*_pos)) error(what);
+			uint64_t value(0);
+			for (; _pos != _end && _isDigit(*_pos); ++_pos) {
+				uint64_t digit(*_pos - '0');
+				if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10) error("number too large");
+				value = value * 10 + digit;
+			}
+			return value;
+		}
+
+		static double _pow10(int exp);
+	public:
+		TextScanner(char const* begin, char const* end) : _begin(begin), _pos(begin), _end(end) { }
+		/* scans [begin, end), a part of the buffer starting at buffer_begin
+		 * (only used for the line numbers in errors) */
+		TextScanner(char const* buffer_begin, char const* begin, char const* end)
+			: _begin(buffer_begin), _pos(begin), _end(end) { }
+
+		/* splits [begin, end) into at most nr_of_chunks parts of about the same
+		 * size, each starting at the beginning of a line; returns the chunk
+		 * boundaries (begin and end included) */
+		static std::vector<char const*> splitLines(char const* begin, char const* end, size_t nr_of_chunks);
+		/* number of lines with at least one non whitespace character */
+		static size_t countRecords(char const* begin, char const* end);
+
+		char const* begin() const { return _begin; }
+		char const* pos() const { return _pos; }
+		char const* end() const { return _end; }
+		bool eof() const { return _pos == _end; }
+
+		[[noreturn]] void error(char const* what) const;
+
+		template<typename T>
+		T readUnsigned()
+		{
+			static_assert(std::is_unsigned<T>::value, "unsigned type required");
+			_skipWhitespace();
+			uint64_t value(_readDigits("expected unsigned number"));
+			if (value > std::numeric_limits<T>::max()) error("number too large");
+			return T(value);
+		}
+
+		template<typename T>
+		T readSigned()
+		{
+			static_assert(std::is_signed<T>::value && std::is_integral<T>::value, "signed integral type required");
+			_skipWhitespace();
+			bool negative(_readSign());
+			uint64_t value(_readDigits("expected number"));
+			uint64_t const max(uint64_t(std::numeric_limits<T>::max()) + (negative ? 1 : 0));
+			if (value > max) error("number too large");
+			if (!negative || 0 == value) return T(value);
+			return T(-int64_t(value - 1) - 1);
+		}
+
+		/* decimal notation with optional exponent */
+		double readDouble();
+
+		/* the rest of the current line (without the newline); moves to the next line */
+		std::string readLine();
+
+		/* the record has to be followed by the end of the line (or file) */
+		void expectEndOfLine()
+		{
+			while (_pos != _end && _isSpace(*_pos)) ++_pos;
+			if (_pos != _end) {
+				if ('\n' != *_pos) error("couldn't find new line after record");
+				++_pos;
+			}
+		}
+
+		friend void unit_tests::testTextScanner();
+};
+
+inline double TextScanner::_pow10(int exp)
+{
+	static double const exact[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+	if (exp >= 0 && exp <= 22) return exact[exp];
+
+	double result(1), base(10);
+	for (uint e(exp < 0 ? -exp : exp); e; e >>= 1, base *= base) {
+		if (e & 1) result *= base;
+	}
+	return exp < 0 ? 1 / result : result;
+}
+
+inline double TextScanner::readDouble()
+{
+	_skipWhitespace();
+	bool negative(_readSign());
+
+	/* collect up to 19 significant digits as integer mantissa */
+	uint64_t mantissa(0);
+	int digits(0), exp(0);
+	bool any_digit(false);
+	for (; _pos != _end && _isDigit(*_pos); ++_pos, any_digit = true) {
+		if (digits < 19) {
+			mantissa = mantissa * 10 + (*_pos - '0');
+			if (mantissa) ++digits;
+		}
+		else {
+			++exp;
+		}
+	}
+	if (_pos != _end && '.' == *_pos) {
+		for (++_pos; _pos != _end && _isDigit(*_pos); ++_pos, any_digit = true) {
+			if (digits < 19) {
+				mantissa = mantissa * 10 + (*_pos - '0');
+				if (mantissa) ++digits;
+				--exp;
+			}
+		}
+	}
+	if (!any_digit) error("expected floating point number");
+
+	if (_pos != _end && ('e' == *_pos || 'E' == *_pos)) {
+		++_pos;
+		bool negative_exp(_readSign());
+		uint64_t e(_readDigits("expected exponent"));
+		if (e > 1000) e = 1000;
+		exp += negative_exp ? -int(e) : int(e);
+	}
+
+	double value(mantissa);
+	/* exact for mantissas below 2^53 and small exponents, as both operands
+	 * are exactly representable and only one rounding happens */
+	if (exp < 0) value /= _pow10(-exp);
+	else if (exp > 0) value *= _pow10(exp);
+	return negative ? -value : value;
+}
+
+inline std::string TextScanner::readLine()
+{
+	char const* line_end(_pos);
+	while (line_end != _end && '\n' != *line_end) ++line_end;
+	std::string line(_pos, line_end);
+	if (!line.empty() && '\r' == line.back()) line.pop_back();
+	_pos = (line_end == _end ? line_end : line_end + 1);
+	return line;
+}
+
+inline std::vector<char const*> TextScanner::splitLines(char const* begin, char const* end, size_t nr_of_chunks)
+{
+	std::vector<char const*> bounds(1, begin);
+	size_t const size(end - begin);
+	for (size_t i(1); i < nr_of_chunks; i++) {
+		char const* pos(std::max(bounds.back(), begin + size * i / nr_of_chunks));
+		if (pos != begin) {
+			pos = static_cast<char const*>(std::memchr(pos - 1, '\n', end - pos + 1));
+			if (!pos) break;
+			++pos;
+		}
+		if (pos != bounds.back()) bounds.push_back(pos);
+	}
+	if (bounds.back() != end) bounds.push_back(end);
+	return bounds;
+}
+
+inline size_t TextScanner::countRecords(char const* begin, char const* end)
+{
+	size_t records(0);
+	bool in_record(false);
+	for (char const* pos(begin); pos != end; ++pos) {
+		if ('\n' == *pos) {
+			in_record = false;
+		}
+		else if (!in_record && !_isSpace(*pos)) {
+			in_record = true;
+			++records;
+		}
+	}
+	return records;
+}
+
+inline void TextScanner::error(char const* what) const
+{
+	size_t line(1);
+	for (char const* p(_begin); p != _pos; ++p) {
+		if ('\n' == *p) ++line;
+	}
+	std::cerr << "FATAL_ERROR: " << what << " in line " << line << ". Exiting.\n";
+	std::abort();
+}
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "defs.h"
+#include "chgraph.h"
+#include "ch_constructor.h"
+#include "prioritizers.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace chc
+{
+
+/*
+ * Shared by the command line tools, so they check their arguments and
+ * build their CHs the same way.
+ */
+
+/* number argument of an option; exits with an error naming <what> unless
+ * it is a decimal number in [min_value, max uint] */
+inline uint parseUInt(char const* arg, char const* what, uint min_value = 0)
+{
+	bool valid(std::isdigit(static_cast<unsigned char>(arg[0])));
+	unsigned long long value(0);
+	if (valid) {
+		char* end(nullptr);
+		errno = 0;
+		value = std::strtoull(arg, &end, 10);
+		valid = '\0' == *end && ERANGE != errno
+			&& value >= min_value && value <= std::numeric_limits<uint>::max();
+	}
+	if (!valid) {
+		std::cerr << "Invalid " << what << ": '" << arg << "'\n";
+		std::exit(1);
+	}
+	return value;
+}
+
+/* thread counts have to be positive */
+inline uint parseThreads(char const* arg)
+{
+	return parseUInt(arg, "thread count", 1);
+}
+
+template <typename GraphT>
+std::vector<NodeID> allNodes(GraphT const& g)
+{
+	std::vector<NodeID> all_nodes(g.getNrOfNodes());
+	for (NodeID i(0); i<all_nodes.size(); i++) {
+		all_nodes[i] = i;
+	}
+	return all_nodes;
+}
+
+/* contracts all nodes of g; without prioritizer quick contraction first */
+template <typename NodeT, typename EdgeT>
+void contractAll(CHConstructor<NodeT, EdgeT>& chc, CHGraph<NodeT, EdgeT> const& g,
+		PrioritizerType prioritizer_type = PrioritizerType::NONE)
+{
+	auto all_nodes(allNodes(g));
+	if (prioritizer_type == PrioritizerType::NONE) {
+		chc.quickContract(all_nodes, 4, 5);
+		chc.contract(all_nodes);
+	}
+	else {
+		auto prioritizer(createPrioritizer(prioritizer_type, g, chc));
+		chc.contract(all_nodes, *prioritizer);
+	}
+}
+
+/* turns the graph in g into its complete CH */
+template <typename NodeT, typename EdgeT>
+void buildCH(CHGraph<NodeT, EdgeT>& g, uint nr_of_threads,
+		PrioritizerType prioritizer_type = PrioritizerType::NONE)
+{
+	CHConstructor<NodeT, EdgeT> chc(g, nr_of_threads);
+	contractAll(chc, g, prioritizer_type);
+	chc.rebuildCompleteGraph();
+}
+
+}
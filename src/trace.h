@@ -0,0 +1,171 @@
+#pragma once
+
+#include "defs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+#include <vector>
+#include <omp.h>
+
+namespace chc
+{
+
+/*
+ * Timeline of begin/end events per (OpenMP) thread, written in the Chrome
+ * trace-event format (chrome://tracing, Perfetto, ...).
+ * Every thread only writes into its own ring buffer, so recording needs no
+ * locks; if a buffer is full, the oldest events are overwritten. The buffers
+ * must only be read (writeJson) when no thread records anymore.
+ */
+class Tracer
+{
+	private:
+		typedef std::chrono::steady_clock clock;
+
+		struct Event
+		{
+			char const* name;
+			clock::time_point begin;
+			clock::time_point end;
+		};
+
+		struct ThreadBuffer
+		{
+			std::vector<Event> events;
+			size_t nr_of_recorded = 0;
+			/* keeps the buffers of the threads on different cache lines */
+			char padding[64];
+		};
+
+		clock::time_point _start;
+		std::vector<ThreadBuffer> _buffers;
+
+		double _micros(clock::time_point t) const
+		{
+			return std::chrono::duration<double, std::micro>(t - _start).count();
+		}
+
+	public:
+		Tracer(size_t nr_of_threads, size_t capacity = 1 << 16)
+			: _start(clock::now()), _buffers(nr_of_threads)
+		{
+			for (auto& buffer: _buffers) {
+				buffer.events.resize(std::max(capacity, size_t(1)));
+			}
+		}
+
+		/* name has to be a string literal (or live as long as the tracer) */
+		void record(char const* name, clock::time_point begin, clock::time_point end)
+		{
+			size_t thread(omp_get_thread_num());
+			if (thread >= _buffers.size()) return;
+
+			auto& buffer(_buffers[thread]);
+			buffer.events[buffer.nr_of_recorded % buffer.events.size()] = Event { name, begin, end };
+			buffer.nr_of_recorded++;
+		}
+
+		/* events overwritten because a buffer was full */
+		size_t dropped() const
+		{
+			size_t sum(0);
+			for (auto const& buffer: _buffers) {
+				if (buffer.nr_of_recorded > buffer.events.size()) {
+					sum += buffer.nr_of_recorded - buffer.events.size();
+				}
+			}
+			return sum;
+		}
+
+		void writeJson(std::ostream& os) const
+		{
+			os << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+			for (size_t t(0); t < _buffers.size(); t++) {
+				os << (t ? ",\n" : "") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << t
+					<< ", \"args\": {\"name\": \"thread " << t << "\"}}";
+			}
+			for (size_t t(0); t < _buffers.size(); t++) {
+				auto const& buffer(_buffers[t]);
+				size_t const size(std::min(buffer.nr_of_recorded, buffer.events.size()));
+				size_t const first(buffer.nr_of_recorded - size);
+				for (size_t i(first); i < buffer.nr_of_recorded; i++) {
+					Event const& event(buffer.events[i % buffer.events.size()]);
+					os << ",\n{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << t
+						<< ", \"ts\": " << _micros(event.begin)
+						<< ", \"dur\": " << _micros(event.end) - _micros(event.begin) << "}";
+				}
+			}
+			os << "\n]}\n";
+		}
+
+		/* records the time from its construction to its destruction; does
+		 * nothing without tracer */
+		class Span
+		{
+			private:
+				Tracer* _tracer;
+				char const* _name;
+				clock::time_point _begin;
+			public:
+				Span(Tracer* tracer, char const* name) : _tracer(tracer), _name(name)
+				{
+					if (_tracer) _begin = clock::now();
+				}
+				Span(Span const&) = delete;
+				Span& operator=(Span const&) = delete;
+				~Span() { close(); }
+
+				void close()
+				{
+					if (_tracer) _tracer->record(_name, _begin, clock::now());
+					_tracer = nullptr;
+				}
+
+				/* ends this event and begins the next one; for consecutive steps */
+				void next(char const* name)
+				{
+					if (_tracer) {
+						auto now(clock::now());
+						_tracer->record(_name, _begin, now);
+						_begin = now;
+					}
+					_name = name;
+				}
+		};
+
+		/* records one event per batch_size calls of tick() (and one for the
+		 * rest at its destruction); for the nodes of a parallel loop */
+		class Batches
+		{
+			private:
+				Tracer* _tracer;
+				char const* _name;
+				size_t _batch_size;
+				size_t _count = 0;
+				clock::time_point _begin;
+			public:
+				Batches(Tracer* tracer, char const* name, size_t batch_size)
+					: _tracer(tracer), _name(name), _batch_size(batch_size)
+				{
+					if (_tracer) _begin = clock::now();
+				}
+				Batches(Batches const&) = delete;
+				Batches& operator=(Batches const&) = delete;
+				~Batches()
+				{
+					if (_tracer && _count) _tracer->record(_name, _begin, clock::now());
+				}
+
+				void tick()
+				{
+					if (!_tracer || ++_count < _batch_size) return;
+					auto now(clock::now());
+					_tracer->record(_name, _begin, now);
+					_begin = now;
+					_count = 0;
+				}
+		};
+};
+
+}
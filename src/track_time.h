@@ -9,6 +9,17 @@
 #include <string>
 #include <ostream>
 
+#include "perf_counters.h"
+
+/*
+ * Besides the flat list of laps (track()), TrackTime keeps a tree of timed
+ * scopes (e.g. phase -> round -> sub-step). Scopes with the same title and
+ * parent are aggregated into one node, so all rounds of a contraction end up
+ * in one "round" node with their count and total time.
+ * Scopes must only be opened and closed by one thread, and be closed in
+ * reverse order of opening (which RAII does).
+ * With attached PerfCounters, the nodes also sum up the counter values.
+ */
 class TrackTime {
 private:
 	struct entry {
@@ -21,12 +32,198 @@ private:
 	std::ostream* os = nullptr;
 	std::chrono::steady_clock::time_point last;
 
+	/* node of the scope tree; tree[0] is the root */
+	struct node {
+		std::string title;
+		std::chrono::duration<double> span;
+		size_t count;
+		size_t parent;
+		std::vector<size_t> children;
+		std::vector<uint64_t> counts; /* of the PerfCounters */
+		node(std::string title, size_t parent)
+		: title(std::move(title)), span(0), count(0), parent(parent) { }
+	};
+	std::vector<node> tree = { node("total", 0) };
+	size_t current = 0;
+
+	PerfCounters const* perf = nullptr;
+	std::vector<uint64_t> last_counts;
+
 	void log(entry const& e) {
 		if (!os) return;
 		(*os) << "Took " << e.span.count() << " seconds: " << e.title << "\n";
 	}
 
+	size_t child(char const* title)
+	{
+		for (size_t c: tree[current].children) {
+			if (tree[c].title == title) return c;
+		}
+		tree[current].children.push_back(tree.size());
+		tree.emplace_back(title, current);
+		return tree.size() - 1;
+	}
+
+	void add(size_t n, std::chrono::duration<double> span)
+	{
+		tree[n].span += span;
+		tree[n].count++;
+	}
+
+	std::vector<uint64_t> readCounters() const
+	{
+		return perf ? perf->read() : std::vector<uint64_t>();
+	}
+
+	void addCounts(size_t n, std::vector<uint64_t> const& from, std::vector<uint64_t> const& to)
+	{
+		if (to.empty() || from.size() != to.size()) return;
+		auto& counts(tree[n].counts);
+		counts.resize(to.size(), 0);
+		for (size_t i(0); i < to.size(); i++) counts[i] += to[i] - from[i];
+	}
+
+	/* counts of node n; for the root the sum of its children */
+	std::vector<uint64_t> counts(size_t n) const
+	{
+		if (n != 0) return tree[n].counts;
+		std::vector<uint64_t> sum;
+		for (size_t c: tree[0].children) {
+			sum.resize(tree[c].counts.size(), 0);
+			for (size_t i(0); i < tree[c].counts.size(); i++) sum[i] += tree[c].counts[i];
+		}
+		return sum;
+	}
+
+	void closeScope(size_t n, std::chrono::steady_clock::time_point start, std::vector<uint64_t> const& start_counts)
+	{
+		using namespace std::chrono;
+		auto now = steady_clock::now();
+		auto span = duration_cast<duration<double>>(now - start);
+		auto counts(readCounters());
+		add(n, span);
+		addCounts(n, start_counts, counts);
+		current = tree[n].parent;
+		if (current == 0) {
+			last = now;
+			last_counts = std::move(counts);
+			record.emplace_back(std::string(tree[n].title), std::move(span));
+			if (os) {
+				log(record.back());
+				(*os) << "\n";
+			}
+		}
+	}
+
+	void logTree(size_t n, std::string const& indent) const
+	{
+		for (size_t c: tree[n].children) {
+			node const& ch(tree[c]);
+			(*os) << indent << ch.title << ": " << ch.span.count() << " seconds";
+			if (ch.count > 1) (*os) << " (" << ch.count << " times)";
+			for (size_t i(0); i < ch.counts.size(); i++) {
+				(*os) << (i ? ", " : " [") << perf->names()[i] << ": " << ch.counts[i] << (i + 1 < ch.counts.size() ? "" : "]");
+			}
+			(*os) << "\n";
+			logTree(c, indent + "  ");
+		}
+	}
+
+	static void writeJsonString(std::ostream& out, std::string const& str)
+	{
+		out << "\"";
+		for (char c: str) {
+			if (c == '"' || c == '\\') out << "\\";
+			out << c;
+		}
+		out << "\"";
+	}
+
+	void writeJson(std::ostream& out, size_t n, std::string const& indent) const
+	{
+		node const& nd(tree[n]);
+		std::chrono::duration<double> span(nd.span);
+		if (n == 0) {
+			for (size_t c: nd.children) span += tree[c].span;
+		}
+		out << indent << "{\"title\": ";
+		writeJsonString(out, nd.title);
+		out << ", \"seconds\": " << span.count() << ", \"count\": " << (n ? nd.count : 1);
+		auto const nd_counts(counts(n));
+		if (!nd_counts.empty()) {
+			out << ", \"counters\": {";
+			for (size_t i(0); i < nd_counts.size(); i++) {
+				out << (i ? ", " : "");
+				writeJsonString(out, perf->names()[i]);
+				out << ": " << nd_counts[i];
+			}
+			out << "}";
+		}
+		if (!nd.children.empty()) {
+			out << ", \"children\": [\n";
+			for (size_t i(0); i < nd.children.size(); i++) {
+				writeJson(out, nd.children[i], indent + "  ");
+				out << (i + 1 < nd.children.size() ? ",\n" : "\n");
+			}
+			out << indent << "]";
+		}
+		out << "}";
+	}
+
 public:
+	/*
+	 * Times from its construction to its destruction (or close()). A scope
+	 * without TrackTime does nothing and doesn't even read the clock, so
+	 * algorithms can open scopes unconditionally.
+	 */
+	class Scope {
+	private:
+		TrackTime* tt = nullptr;
+		size_t n = 0;
+		std::chrono::steady_clock::time_point start;
+		std::vector<uint64_t> start_counts;
+	public:
+		Scope() { }
+		Scope(TrackTime* tt, char const* title) : tt(tt)
+		{
+			if (!tt) return;
+			n = tt->child(title);
+			tt->current = n;
+			start_counts = tt->readCounters();
+			start = std::chrono::steady_clock::now();
+		}
+		Scope(Scope const&) = delete;
+		Scope& operator=(Scope const&) = delete;
+		Scope(Scope&& other) : tt(other.tt), n(other.n), start(other.start), start_counts(std::move(other.start_counts))
+		{
+			other.tt = nullptr;
+		}
+		Scope& operator=(Scope&& other)
+		{
+			close();
+			tt = other.tt; n = other.n; start = other.start;
+			start_counts = std::move(other.start_counts);
+			other.tt = nullptr;
+			return *this;
+		}
+		~Scope() { close(); }
+
+		void close()
+		{
+			if (!tt) return;
+			tt->closeScope(n, start, start_counts);
+			tt = nullptr;
+		}
+
+		/* closes this scope and opens a sibling; for consecutive steps */
+		void next(char const* title)
+		{
+			TrackTime* t(tt);
+			close();
+			*this = Scope(t, title);
+		}
+	};
+
 	TrackTime(std::ostream& os) : os(&os), last(std::chrono::steady_clock::now()) { }
 	TrackTime() : last(std::chrono::steady_clock::now()) { }
 
@@ -36,6 +233,11 @@ public:
 		auto old = last;
 		last = steady_clock::now();
 		record.emplace_back(std::move(title), duration_cast<duration<double>>(last - old));
+		auto counts(readCounters());
+		size_t const n(child(record.back().title.c_str()));
+		add(n, record.back().span);
+		addCounts(n, last_counts, counts);
+		last_counts = std::move(counts);
 		if (log_entry && os) {
 			log(record.back());
 			(*os) << "\n";
@@ -47,13 +249,42 @@ public:
 		track(std::string(title), log_entry);
 	}
 
+	/* adds the values of counters (which must outlive this) to laps and scopes */
+	void attach(PerfCounters const* counters)
+	{
+		perf = counters;
+		last_counts = readCounters();
+	}
+
+	/*
+	 * Opens a scope below the innermost open one. Top level scopes are also
+	 * tracked like laps (ending at the close of the scope).
+	 */
+	Scope scope(char const* title) { return Scope(this, title); }
+
+	/* scope if tt isn't null, otherwise a scope that does nothing */
+	static Scope scope(TrackTime* tt, char const* title) { return Scope(tt, title); }
+
 	void summary()
 	{
 		if (!os) return;
 		(*os) << "\nTimeTrack summary:\n";
 		for (auto const &entry: record) log(entry);
+		for (auto const &nd: tree) {
+			if (&nd != &tree[0] && !nd.children.empty()) {
+				(*os) << "\nTimeTrack scopes:\n";
+				logTree(0, "  ");
+				break;
+			}
+		}
 	}
 
+	/* the scope tree as nested {"title", "seconds", "count", "counters", "children"} objects */
+	void writeJson(std::ostream& out) const
+	{
+		writeJson(out, 0, "");
+		out << "\n";
+	}
 };
 
 inline TrackTime VerboseTrackTime() {
@@ -8,15 +8,33 @@
 #include "nodes_and_edges.h"
 #include "graph.h"
 #include "file_formats.h"
+#include "text_scanner.h"
+#include "text_buffer.h"
+#include "graph_snapshot.h"
+#include "graph_generator.h"
 #include "chgraph.h"
 #include "ch_constructor.h"
 #include "dijkstra.h"
+#include "shortcut_unpacker.h"
+#include "many_to_many.h"
+#include "phast.h"
+#include "rphast.h"
+#include "batch_query.h"
 #include "prioritizers.h"
+#include "alt.h"
+#include "metrics.h"
+#include "cch.h"
+#include "tool_helpers.h"
 
 #include <map>
+#include <set>
+#include <fstream>
+#include <sstream>
 #include <iostream>
 #include <random>
 #include <chrono>
+#include <future>
+#include <thread>
 
 namespace chc
 {
@@ -24,11 +42,25 @@ namespace chc
 void unit_tests::testAll()
 {
 	unit_tests::testNodesAndEdges();
+	unit_tests::testTextScanner();
+	unit_tests::testTextBuffer();
+	unit_tests::testGraphSnapshot();
+	unit_tests::testGraphGenerator();
 	unit_tests::testGraph();
 	unit_tests::testCHConstructor();
 	unit_tests::testCHDijkstra();
+	unit_tests::testShortcutUnpacker();
+	unit_tests::testManyToMany();
+	unit_tests::testPHAST();
+	unit_tests::testRPHAST();
+	unit_tests::testBatchQuery();
+	unit_tests::testCHGraphFromFile();
+	unit_tests::testBinaryCH();
 	unit_tests::testDijkstra();
+	unit_tests::testALT();
 	unit_tests::testPrioritizers();
+	unit_tests::testMetrics();
+	unit_tests::testCCH();
 }
 
 void unit_tests::testNodesAndEdges()
@@ -56,6 +88,266 @@ void unit_tests::testNodesAndEdges()
 	Print("======================================\n");
 }
 
+void unit_tests::testTextScanner()
+{
+	Print("\n===============================");
+	Print("TEST: Start text scanner test.");
+	Print("===============================\n");
+
+	std::string const text("42 -17 +3 18446744073709551615\n"
+		"  0.5 -12.25e1 48.1234567 1e-3 7 \r\n"
+		"# key : value\n"
+		"\n"
+		"1 2");
+	TextScanner scanner(text.data(), text.data() + text.size());
+	Test(scanner.readUnsigned<uint>() == 42);
+	Test(scanner.readSigned<int>() == -17);
+	Test(scanner.readSigned<int>() == 3);
+	Test(scanner.readUnsigned<uint64_t>() == std::numeric_limits<uint64_t>::max());
+	scanner.expectEndOfLine();
+	Test(scanner.readDouble() == 0.5);
+	Test(scanner.readDouble() == -122.5);
+	Test(scanner.readDouble() == 48.1234567);
+	Test(scanner.readDouble() == 1e-3);
+	Test(scanner.readDouble() == 7);
+	scanner.expectEndOfLine();
+	Test(scanner.readLine() == "# key : value");
+	Test(scanner.readLine() == "");
+	Test(scanner.readUnsigned<uint>() == 1);
+	Test(scanner.readSigned<long long>() == 2);
+	scanner.expectEndOfLine();
+	Test(scanner.eof());
+
+	/* the scanning readers have to produce the same graphs as the stream readers */
+	auto compare = [](GraphInData<OSMNode, OSMEdge> const& data1, GraphInData<OSMNode, OSMEdge> const& data2) {
+		Test(data1.meta_data == data2.meta_data);
+		Test(data1.nodes.size() == data2.nodes.size());
+		for (NodeID i(0); i<data1.nodes.size(); i++) {
+			auto const& node1(data1.nodes[i]);
+			auto const& node2(data2.nodes[i]);
+			Test(node1.id == node2.id && node1.osm_id == node2.osm_id && node1.elev == node2.elev);
+			Test(node1.lat == node2.lat && node1.lon == node2.lon);
+		}
+		Test(data1.edges.size() == data2.edges.size());
+		for (EdgeID i(0); i<data1.edges.size(); i++) {
+			auto const& edge1(data1.edges[i]);
+			auto const& edge2(data2.edges[i]);
+			Test(edge1.id == edge2.id && equalEndpoints(edge1, edge2));
+			Test(edge1.dist == edge2.dist && edge1.type == edge2.type && edge1.speed == edge2.speed);
+		}
+	};
+	compare(FormatSTD::Reader::readGraph<OSMNode, OSMEdge>("../test_data/15kSZHK.txt"),
+		FormatSTD::StreamReader::readGraph<OSMNode, OSMEdge>("../test_data/15kSZHK.txt"));
+	compare(FormatFMI::Reader::readGraph<OSMNode, OSMEdge>("../test_data/15kSZHK_fmi.txt"),
+		FormatFMI::StreamReader::readGraph<OSMNode, OSMEdge>("../test_data/15kSZHK_fmi.txt"));
+
+	/* loops, invalid (negative) and duplicate edges are dropped */
+	std::string const graph("3\n6\n"
+		"0 10 48.1 9.1 0\n1 11 48.2 9.2 0\n\n2 12 48.3 9.3 0\n"
+		"0 1 5 1 -1\n1 1 3 1 -1\n1 2 -1 1 -1\n0 1 4 1 -1\n2 0 7 1 -1\n1 2 6 1 -1\n");
+	std::istringstream stream1(graph), stream2(graph);
+	auto data(FormatSTD::Reader::readGraph<OSMNode, OSMEdge>(stream1));
+	compare(data, FormatSTD::StreamReader::readGraph<OSMNode, OSMEdge>(stream2));
+	Test(data.nodes.size() == 3 && data.edges.size() == 3);
+	Test(data.edges[0].src == 0 && data.edges[0].tgt == 1);
+
+	/* the same spread over many chunks, which are sorted and merged separately */
+	std::ostringstream large_graph;
+	uint const large_nr_of_nodes(1000), large_nr_of_edges(20000);
+	large_graph << large_nr_of_nodes << "\n" << large_nr_of_edges << "\n";
+	for (uint i(0); i < large_nr_of_nodes; i++) {
+		large_graph << i << " " << 10*i << " 48." << i << " 9." << i << " 0\n";
+	}
+	std::mt19937 gen(42);
+	std::uniform_int_distribution<uint> node(0, large_nr_of_nodes/10);
+	std::uniform_int_distribution<int> dist(-1, 20);
+	for (uint i(0); i < large_nr_of_edges; i++) {
+		large_graph << node(gen) << " " << node(gen) << " " << dist(gen) << " 1 -1\n";
+	}
+	std::istringstream stream3(large_graph.str()), stream4(large_graph.str());
+	compare(FormatSTD::Reader::readGraph<OSMNode, OSMEdge>(stream3),
+		FormatSTD::StreamReader::readGraph<OSMNode, OSMEdge>(stream4));
+
+	Print("\n====================================");
+	Print("TEST: Text scanner test successful.");
+	Print("====================================\n");
+}
+
+void unit_tests::testTextBuffer()
+{
+	Print("\n==============================");
+	Print("TEST: Start text buffer test.");
+	Print("==============================\n");
+
+	TextBuffer buffer;
+	buffer.append(0u);
+	buffer.append(' ');
+	buffer.append(std::numeric_limits<uint64_t>::max());
+	buffer.append(' ');
+	buffer.append(std::numeric_limits<int>::min());
+	buffer.append(' ');
+	buffer.append(-1);
+	buffer.append(" x", 2);
+	Test(std::string(buffer.data(), buffer.size()) == "0 18446744073709551615 -2147483648 -1 x");
+
+	/* doubles have to look exactly like std::fixed output */
+	std::vector<double> values{0, -0.0, 0.5, 1.00000005, 2.5e-8, -2.5e-8, 48.1234567, -9.87654321,
+		0.00000015, 1e15, -1e20, 123456789.123456789, std::numeric_limits<double>::infinity()};
+	std::mt19937 gen(42);
+	std::uniform_real_distribution<double> coord(-180, 180);
+	for (uint i(0); i < 10000; i++) {
+		values.push_back(coord(gen));
+		/* numbers with exactly 8 decimal places, i.e. many halfway cases */
+		values.push_back(std::round(coord(gen) * 1e8) / 1e8);
+	}
+	for (double value: values) {
+		buffer.clear();
+		buffer.appendFixed(value);
+		std::ostringstream os;
+		os.precision(7);
+		os << std::fixed << value;
+		Test(std::string(buffer.data(), buffer.size()) == os.str());
+	}
+
+	Print("\n===================================");
+	Print("TEST: Text buffer test successful.");
+	Print("===================================\n");
+}
+
+void unit_tests::testGraphSnapshot()
+{
+	Print("\n=================================");
+	Print("TEST: Start graph snapshot test.");
+	Print("=================================\n");
+
+	typedef CHEdge<OSMEdge> Shortcut;
+
+	std::string const infile("../test_data/15kSZHK_fmi.txt");
+	uint64_t const key(snapshot::key<OSMNode, Shortcut>(infile, to_string(FileFormat::FMI)));
+	std::string const snapshot_file(snapshot::filename("../out", key));
+	std::remove(snapshot_file.c_str());
+
+	/* other readers, inputs or types give other keys */
+	Test((key != snapshot::key<OSMNode, Shortcut>(infile, to_string(FileFormat::FMI_DIST))));
+	Test((key != snapshot::key<OSMNode, Shortcut>("../test_data/15kSZHK.txt", to_string(FileFormat::FMI))));
+	Test((key != snapshot::key<GeoNode, Shortcut>(infile, to_string(FileFormat::FMI))));
+
+	auto data(readGraph<OSMNode, Shortcut>(FileFormat::FMI, infile));
+	data.meta_data["Test"] = "snapshot";
+	snapshot::write(snapshot_file, key, data);
+
+	GraphInData<OSMNode, Shortcut> cached;
+	Test(!snapshot::read(snapshot_file, key + 1, cached));
+	Test(snapshot::read(snapshot_file, key, cached));
+	Test(cached.meta_data == data.meta_data);
+	Test(cached.nodes.size() == data.nodes.size() && cached.edges.size() == data.edges.size());
+	for (NodeID i(0); i<data.nodes.size(); i++) {
+		Test(cached.nodes[i].id == data.nodes[i].id && cached.nodes[i].osm_id == data.nodes[i].osm_id);
+		Test(cached.nodes[i].lat == data.nodes[i].lat && cached.nodes[i].lon == data.nodes[i].lon);
+	}
+	for (EdgeID i(0); i<data.edges.size(); i++) {
+		Test(cached.edges[i].id == data.edges[i].id && equalEndpoints(cached.edges[i], data.edges[i]));
+		Test(cached.edges[i].dist == data.edges[i].dist && cached.edges[i].child_edge1 == data.edges[i].child_edge1);
+	}
+
+	/* concurrent writers of one snapshot each publish a complete file */
+	Test(snapshot::tmpFilename(snapshot_file) != snapshot::tmpFilename(snapshot_file));
+	#pragma omp parallel for num_threads(4)
+	for (int i = 0; i < 4; i++) {
+		snapshot::write(snapshot_file, key, data);
+	}
+	Test(snapshot::read(snapshot_file, key, cached));
+	Test(cached.nodes.size() == data.nodes.size() && cached.edges.size() == data.edges.size());
+
+	/* readGraph with a cache directory uses the stored snapshot */
+	auto read(readGraph<OSMNode, Shortcut>(FileFormat::FMI, infile, "../out"));
+	Test(read.meta_data["Test"] == "snapshot");
+	std::remove(snapshot_file.c_str());
+
+	Print("\n======================================");
+	Print("TEST: Graph snapshot test successful.");
+	Print("======================================\n");
+}
+
+void unit_tests::testGraphGenerator()
+{
+	Print("\n==================================");
+	Print("TEST: Start graph generator test.");
+	Print("==================================\n");
+
+	/* symmetric, no loops or parallel edges, sorted and numbered */
+	auto checkEdges = [](GraphInData<OSMNode, OSMEdge> const& data) {
+		auto const& edges(data.edges);
+		for (EdgeID i(0); i < edges.size(); i++) {
+			Test(edges[i].id == i && edges[i].src != edges[i].tgt && edges[i].dist > 0);
+			Test(edges[i].src < data.nodes.size() && edges[i].tgt < data.nodes.size());
+			Test(i == 0 || EdgeSortSrcTgt<OSMEdge>()(edges[i-1], edges[i]));
+			OSMEdge reverse(c::NO_EID, edges[i].tgt, edges[i].src, 0, 0, 0);
+			auto it(std::lower_bound(edges.begin(), edges.end(), reverse, EdgeSortSrcTgt<OSMEdge>()));
+			Test(it != edges.end() && equalEndpoints(*it, reverse) && it->dist == edges[i].dist);
+		}
+	};
+
+	auto grid(generator::gridGraph(10, 5, 1));
+	Test(grid.nodes.size() == 50 && grid.edges.size() == 2 * (9*5 + 10*4));
+	checkEdges(grid);
+	/* neighbours are about 100m apart, roads up to 1.5 times longer */
+	for (auto const& edge: grid.edges) {
+		Test(edge.dist >= 99 && edge.dist <= 151);
+	}
+
+	auto geometric(generator::randomGeometricGraph(2000, 7));
+	Test(geometric.nodes.size() == 2000);
+	checkEdges(geometric);
+	std::vector<uint> degree(geometric.nodes.size(), 0);
+	for (auto const& edge: geometric.edges) {
+		degree[edge.src]++;
+	}
+	Test(*std::min_element(degree.begin(), degree.end()) >= 1);
+	double const avg_degree(double(geometric.edges.size()) / geometric.nodes.size());
+	Test(avg_degree > 2 && avg_degree < 4);
+
+	/* same seed, same graph - independent of the number of threads */
+	int const max_threads(omp_get_max_threads());
+	omp_set_num_threads(3);
+	auto geometric2(generator::randomGeometricGraph(2000, 7));
+	omp_set_num_threads(max_threads);
+	Test(geometric2.edges.size() == geometric.edges.size());
+	for (EdgeID i(0); i < geometric.edges.size(); i++) {
+		Test(equalEndpoints(geometric.edges[i], geometric2.edges[i]) && geometric.edges[i].dist == geometric2.edges[i].dist);
+	}
+
+	/* nearest neighbours agree with brute force */
+	generator::SpatialGrid spatial_grid(geometric.nodes, 150);
+	for (NodeID node(0); node < 100; node++) {
+		std::vector<std::pair<double, NodeID>> all;
+		for (NodeID other(0); other < geometric.nodes.size(); other++) {
+			if (other == node) continue;
+			all.emplace_back(generator::squaredDist(spatial_grid.point(node), spatial_grid.point(other)), other);
+		}
+		std::sort(all.begin(), all.end());
+		auto const nearest(spatial_grid.nearest(node, 5));
+		Test(nearest.size() == 5);
+		for (uint i(0); i < 5; i++) {
+			Test(nearest[i] == all[i].second);
+		}
+		Test(spatial_grid.nearest(spatial_grid.point(node)) == node);
+	}
+
+	/* highways are added as more important, straighter roads */
+	size_t const nr_of_edges(geometric.edges.size());
+	generator::addHighways(geometric, 2, 7, 1000);
+	Test(geometric.edges.size() > nr_of_edges);
+	checkEdges(geometric);
+	Test(std::any_of(geometric.edges.begin(), geometric.edges.end(), [](OSMEdge const& edge) {
+		return edge.type == generator::ROAD_TYPES[2];
+	}));
+
+	Print("\n=======================================");
+	Print("TEST: Graph generator test successful.");
+	Print("=======================================\n");
+}
+
 void unit_tests::testGraph()
 {
 	Print("\n=======================");
@@ -84,6 +376,12 @@ void unit_tests::testGraph()
 		}
 	}
 
+	/* memory accounting */
+	auto const usage(g.memoryUsage());
+	Test(usage.parts.size() == 6);
+	Test(usage.total() >= 2 * g.getNrOfEdges() * sizeof(Edge) + g.getNrOfNodes() * sizeof(OSMNode));
+	Test(peakRSS() >= usage.total());
+
 	Print("\n============================");
 	Print("TEST: Graph test successful.");
 	Print("============================\n");
@@ -131,7 +429,77 @@ void unit_tests::testCHConstructor()
 	/*
 	 * Test the contraction.
 	 */
-	chc.contract(all_nodes);
+	size_t const nr_of_nodes(all_nodes.size());
+	TrackTime tt;
+	PerfCounters perf; /* might not be allowed to count anything */
+	tt.attach(&perf);
+	chc.setTrackTime(&tt);
+	Tracer tracer(2);
+	chc.setTracer(&tracer);
+	std::stringstream progress;
+	chc.setProgressStream(&progress);
+	{
+		auto scope(tt.scope("contracting graph"));
+		chc.contract(all_nodes);
+	}
+
+	/* every node was removed in exactly one round */
+	size_t nr_of_removed(0);
+	for (auto const& stats: chc.getRoundStats()) {
+		Test(!stats.quick && stats.nr_of_nodes == nr_of_nodes - nr_of_removed);
+		Test(stats.nr_of_removed <= stats.nr_of_candidates);
+		nr_of_removed += stats.nr_of_removed;
+	}
+	Test(nr_of_removed == nr_of_nodes);
+
+	/* the counters of the threads (run_tests is built with CHC_STATS) */
+	auto const total(chc.getStats().total());
+	size_t nr_of_shortcuts(0);
+	for (auto const& stats: chc.getRoundStats()) {
+		Test(stats.threads.size() == 2);
+		Test(stats.graph_memory > 0 && stats.constructor_memory > 0);
+		nr_of_shortcuts += stats.nr_of_shortcuts;
+	}
+	Test(total.contracted_nodes >= nr_of_nodes && total.shortcuts == nr_of_shortcuts);
+	Test(total.searches > 0 && total.settled_nodes >= total.searches && total.pushes >= total.settled_nodes);
+
+	/* the queues of the witness searches keep their heaps, which are counted */
+	size_t pq_memory(0);
+	for (auto const& td: chc._thread_data) pq_memory += td.pq.memoryUsage();
+	Test(pq_memory > 0 && chc.memoryUsage().total() > pq_memory);
+
+	/* the rounds are aggregated in one scope below the phase */
+	std::stringstream json;
+	tt.writeJson(json);
+	std::string const round("{\"title\": \"round\", \"seconds\": ");
+	size_t const pos(json.str().find(round));
+	Test(pos != std::string::npos && json.str().find(round, pos + 1) == std::string::npos);
+	Test(json.str().find("\"count\": " + std::to_string(chc.getRoundStats().size()), pos) != std::string::npos);
+	Test(json.str().find("\"title\": \"contract\"") < pos);
+	Test(json.str().find("\"title\": \"contracting graph\"") < json.str().find("\"title\": \"contract\""));
+	Test((json.str().find("\"counters\": {") != std::string::npos) == !perf.empty());
+
+	/* one traced event per round, and the contracted nodes in batches */
+	std::stringstream trace;
+	tracer.writeJson(trace);
+	Test(tracer.dropped() == 0);
+	auto countEvents = [&](std::string const& name) {
+		size_t count(0);
+		for (size_t pos(0); (pos = trace.str().find("\"name\": \"" + name + "\"", pos)) != std::string::npos; pos++) count++;
+		return count;
+	};
+	Test(countEvents("round") == chc.getRoundStats().size());
+	Test(countEvents("restructure") == chc.getRoundStats().size());
+	Test(countEvents("contract_nodes") >= chc.getRoundStats().size());
+	Test(countEvents("contract") == 1);
+
+	/* one progress line per round, the last one without remaining nodes */
+	std::vector<std::string> lines;
+	for (std::string line; std::getline(progress, line);) lines.push_back(line);
+	Test(lines.size() == chc.getRoundStats().size());
+	Test(lines.front().find("{\"round\": 1, \"quick\": false, \"remaining_nodes\": ") == 0);
+	Test(lines.back().find("\"remaining_nodes\": 0,") != std::string::npos);
+	Test(lines.back().find("\"eta\": 0,") != std::string::npos);
 
 	// Export
 	writeCHGraphFile<FormatSTD::Writer>("../out/ch_test", g.exportData());
@@ -185,6 +553,50 @@ void unit_tests::testCHDijkstra()
 		Test(dij.calcShopa(src,tgt,path) == chdij.calcShopa(src,tgt,path));
 	}
 
+	Print("\nCompare bidirectional Dijkstra and A* with Dijkstra.");
+	BidirectionalDijkstra<OSMNode, OSMEdge> bidij(g);
+	AStar<OSMNode, OSMEdge> astar(g);
+	Test(astar.getScale() > 0);
+	auto pathLength = [&](NodeID src, NodeID tgt, std::vector<EdgeID> const& path) {
+		NodeID node(src);
+		uint length(0);
+		for (auto edge_id: path) {
+			Test(g.getEdge(edge_id).src == node);
+			node = g.getEdge(edge_id).tgt;
+			length += g.getEdge(edge_id).distance();
+		}
+		Test(node == tgt);
+		return length;
+	};
+	size_t astar_settled(0), dij_astar_settled(0);
+	for (uint i(0); i<5*nr_of_dij; i++) {
+		NodeID src = rand_node();
+		NodeID tgt = rand_node();
+		uint const dist(dij.calcShopa(src, tgt, path));
+		Test(bidij.calcShopa(src, tgt, path) == dist);
+		Test(dist == c::NO_DIST || pathLength(src, tgt, path) == dist);
+		Test(astar.calcShopa(src, tgt, path) == dist);
+		Test(dist == c::NO_DIST || pathLength(src, tgt, path) == dist);
+		dij_astar_settled += dij.getStats().settled_nodes;
+		astar_settled += astar.getStats().settled_nodes;
+	}
+	Test(astar_settled < dij_astar_settled);
+	Test(bidij.calcShopa(0, 0, path) == 0 && path.empty());
+
+	Print("\nTest the search statistics.");
+	size_t dij_settled(0), ch_settled(0);
+	for (uint i(0); i<nr_of_dij; i++) {
+		NodeID src = rand_node();
+		NodeID tgt = rand_node();
+		dij.calcShopa(src, tgt, path);
+		chdij.calcShopa(src, tgt, path);
+		Test(dij.getStats().settled_nodes > 0 && chdij.getStats().settled_nodes > 0);
+		Test(dij.getStats().relaxed_edges >= dij.getStats().settled_nodes - 1);
+		dij_settled += dij.getStats().settled_nodes;
+		ch_settled += chdij.getStats().settled_nodes;
+	}
+	Test(ch_settled < dij_settled);
+
 	// Export (destroys graph data)
 	writeCHGraphFile<FormatSTD::Writer>("../out/ch_15kSZHK.txt", chg.exportData());
 
@@ -193,6 +605,431 @@ void unit_tests::testCHDijkstra()
 	Print("=================================\n");
 }
 
+void unit_tests::testShortcutUnpacker()
+{
+	Print("\n===================================");
+	Print("TEST: Start ShortcutUnpacker test.");
+	Print("===================================\n");
+
+	typedef CHEdge<OSMEdge> Shortcut;
+	typedef CHGraph<OSMNode, OSMEdge> CHGraphOSM;
+
+	/* Init normal graph */
+	Graph<OSMNode, OSMEdge> g;
+	g.init(FormatSTD::Reader::readGraph<OSMNode, OSMEdge>("../test_data/15kSZHK.txt"));
+
+	/* Init CH graph */
+	CHGraphOSM chg;
+	chg.init(FormatSTD::Reader::readGraph<OSMNode, Shortcut>("../test_data/15kSZHK.txt"));
+
+	/* Build CH */
+	buildCH(chg, 2);
+
+	Dijkstra<OSMNode, OSMEdge> dij(g);
+	CHDijkstra<OSMNode, OSMEdge> chdij(chg);
+	ShortcutUnpacker<OSMNode, OSMEdge> unpacker(chg);
+	ShortcutUnpacker<OSMNode, OSMEdge> cached_unpacker(chg, 16);
+
+	std::default_random_engine gen(std::chrono::system_clock::now().time_since_epoch().count());
+	std::uniform_int_distribution<uint> dist(0,g.getNrOfNodes()-1);
+	auto rand_node = std::bind (dist, gen);
+	std::vector<EdgeID> path, dij_path;
+	for (uint i(0); i<100; i++) {
+		NodeID src = rand_node();
+		NodeID tgt = rand_node();
+		Debug("From " << src << " to " << tgt << ".");
+		uint ch_dist(chdij.calcShopa(src, tgt, path));
+		Test(dij.calcShopa(src, tgt, dij_path) == ch_dist);
+		if (c::NO_DIST == ch_dist) continue;
+
+		auto unpacked(unpacker.unpackPath(path));
+		Test(unpacked == cached_unpacker.unpackPath(path));
+		Test(unpacked == chg.unpackPath(path));
+
+		/* unpacked path has to consist of connected original edges */
+		uint unpacked_dist(0);
+		NodeID last_node(src);
+		for (EdgeID edge_id: unpacked) {
+			Shortcut const& edge(chg.getEdge(edge_id));
+			Test(c::NO_NID == edge.center_node);
+			Test(edge.src == last_node);
+			last_node = edge.tgt;
+			unpacked_dist += edge.distance();
+		}
+		Test(last_node == tgt);
+		Test(unpacked_dist == ch_dist);
+
+		auto nodes(cached_unpacker.unpackPathNodeIDs(src, path));
+		Test(nodes.size() == unpacked.size() + 1);
+		Test(nodes.front() == src && nodes.back() == tgt);
+	}
+
+	/* a path of length 0 still consists of its node */
+	NodeID const node(rand_node());
+	Test(chdij.calcShopa(node, node, path) == 0 && path.empty());
+	Test(unpacker.unpackPathNodeIDs(node, path) == std::vector<NodeID>(1, node));
+	Test(unpacker.unpackPathNodes(node, path).size() == 1);
+	Print("Cache hits: " << cached_unpacker.getCacheHits() << ", misses: " << cached_unpacker.getCacheMisses());
+
+	Print("\n========================================");
+	Print("TEST: ShortcutUnpacker test successful.");
+	Print("========================================\n");
+}
+
+void unit_tests::testManyToMany()
+{
+	Print("\n=============================");
+	Print("TEST: Start ManyToMany test.");
+	Print("=============================\n");
+
+	typedef CHEdge<OSMEdge> Shortcut;
+	typedef CHGraph<OSMNode, OSMEdge> CHGraphOSM;
+
+	/* Init CH graph */
+	CHGraphOSM chg;
+	chg.init(FormatSTD::Reader::readGraph<OSMNode, Shortcut>("../test_data/15kSZHK.txt"));
+
+	/* Build CH */
+	buildCH(chg, 2);
+
+	std::default_random_engine gen(std::chrono::system_clock::now().time_since_epoch().count());
+	std::uniform_int_distribution<uint> dist(0,chg.getNrOfNodes()-1);
+	auto rand_node = std::bind (dist, gen);
+	std::vector<NodeID> sources(20), targets(30);
+	for (auto& node: sources) node = rand_node();
+	for (auto& node: targets) node = rand_node();
+	targets.push_back(sources.front()); /* distance 0 entry */
+
+	CHManyToMany<OSMNode, OSMEdge> m2m(chg, 2);
+	auto table(m2m.calcTable(sources, targets));
+	Test(table.size() == sources.size() * targets.size());
+
+	CHDijkstra<OSMNode, OSMEdge> chdij(chg);
+	std::vector<EdgeID> path;
+	for (uint i(0); i<sources.size(); i++) {
+		for (uint j(0); j<targets.size(); j++) {
+			Test(table[i * targets.size() + j] == chdij.calcShopa(sources[i], targets[j], path));
+		}
+	}
+	Test(table[targets.size() - 1] == 0);
+
+	Print("\n==================================");
+	Print("TEST: ManyToMany test successful.");
+	Print("==================================\n");
+}
+
+void unit_tests::testPHAST()
+{
+	Print("\n========================");
+	Print("TEST: Start PHAST test.");
+	Print("========================\n");
+
+	typedef CHEdge<OSMEdge> Shortcut;
+	typedef CHGraph<OSMNode, OSMEdge> CHGraphOSM;
+
+	/* Init normal graph */
+	Graph<OSMNode, OSMEdge> g;
+	g.init(FormatSTD::Reader::readGraph<OSMNode, OSMEdge>("../test_data/15kSZHK.txt"));
+
+	/* Init CH graph */
+	CHGraphOSM chg;
+	chg.init(FormatSTD::Reader::readGraph<OSMNode, Shortcut>("../test_data/15kSZHK.txt"));
+
+	/* Build CH */
+	buildCH(chg, 2);
+
+	PHAST<OSMNode, OSMEdge> phast(chg.exportData());
+	Test(phast.getNrOfNodes() == g.getNrOfNodes());
+
+	std::default_random_engine gen(std::chrono::system_clock::now().time_since_epoch().count());
+	std::uniform_int_distribution<uint> dist(0,g.getNrOfNodes()-1);
+	auto rand_node = std::bind (dist, gen);
+
+	/* more sources than lanes to test a partial last sweep */
+	std::vector<NodeID> sources(PHAST<OSMNode, OSMEdge>::LANES + 3);
+	for (auto& node: sources) node = rand_node();
+	auto all_dists(phast.calcDists(sources));
+	Test(all_dists.size() == sources.size());
+
+	Dijkstra<OSMNode, OSMEdge> dij(g);
+	std::vector<EdgeID> path;
+	for (uint i(0); i<sources.size(); i++) {
+		auto dists(phast.calcDists(sources[i]));
+		Test(dists == all_dists[i]);
+		Test(dists[sources[i]] == 0);
+
+		for (uint j(0); j<20; j++) {
+			NodeID tgt = rand_node();
+			Test(dists[tgt] == dij.calcShopa(sources[i], tgt, path));
+		}
+	}
+
+	Print("\n=============================");
+	Print("TEST: PHAST test successful.");
+	Print("=============================\n");
+}
+
+void unit_tests::testRPHAST()
+{
+	Print("\n=========================");
+	Print("TEST: Start RPHAST test.");
+	Print("=========================\n");
+
+	typedef CHEdge<OSMEdge> Shortcut;
+	typedef CHGraph<OSMNode, OSMEdge> CHGraphOSM;
+
+	/* Init CH graph */
+	CHGraphOSM chg;
+	chg.init(FormatSTD::Reader::readGraph<OSMNode, Shortcut>("../test_data/15kSZHK.txt"));
+
+	/* Build CH */
+	buildCH(chg, 2);
+
+	auto data(chg.exportData());
+	PHAST<OSMNode, OSMEdge> phast(data);
+	RPHAST<OSMNode, OSMEdge> rphast(data);
+
+	std::default_random_engine gen(std::chrono::system_clock::now().time_since_epoch().count());
+	std::uniform_int_distribution<uint> dist(0,chg.getNrOfNodes()-1);
+	auto rand_node = std::bind (dist, gen);
+	std::vector<NodeID> sources(10), targets(50);
+	for (auto& node: sources) node = rand_node();
+	for (auto& node: targets) node = rand_node();
+
+	rphast.selectTargets(targets);
+	Test(rphast.getNrOfTargets() == targets.size());
+	Test(rphast.getNrOfSelectedNodes() <= rphast.getNrOfNodes());
+
+	auto table(rphast.calcTable(sources, 2));
+	for (uint i(0); i<sources.size(); i++) {
+		auto phast_dists(phast.calcDists(sources[i]));
+		auto rphast_dists(rphast.calcDists(sources[i]));
+		for (uint j(0); j<targets.size(); j++) {
+			Test(rphast_dists[j] == phast_dists[targets[j]]);
+			Test(table[i * targets.size() + j] == rphast_dists[j]);
+		}
+	}
+
+	Print("\n==============================");
+	Print("TEST: RPHAST test successful.");
+	Print("==============================\n");
+}
+
+void unit_tests::testBatchQuery()
+{
+	Print("\n=============================");
+	Print("TEST: Start BatchQuery test.");
+	Print("=============================\n");
+
+	typedef CHEdge<OSMEdge> Shortcut;
+	typedef CHGraph<OSMNode, OSMEdge> CHGraphOSM;
+
+	/* Init CH graph */
+	CHGraphOSM chg;
+	chg.init(FormatSTD::Reader::readGraph<OSMNode, Shortcut>("../test_data/15kSZHK.txt"));
+
+	/* Build CH */
+	buildCH(chg, 2);
+
+	std::default_random_engine gen(std::chrono::system_clock::now().time_since_epoch().count());
+	std::uniform_int_distribution<uint> dist(0,chg.getNrOfNodes()-1);
+	auto rand_node = std::bind (dist, gen);
+	std::vector<Query> queries(1000);
+	for (auto& query: queries) {
+		query.src = rand_node();
+		query.tgt = rand_node();
+	}
+
+	CHBatchQuery<OSMNode, OSMEdge> batch(chg, 4);
+	auto result(batch.run(queries));
+	Print(result);
+	Test(result.dists.size() == queries.size());
+	Test(result.p50_latency <= result.p99_latency && result.p99_latency <= result.max_latency);
+
+	CHDijkstra<OSMNode, OSMEdge> chdij(chg);
+	std::vector<EdgeID> path;
+	for (uint i(0); i<queries.size(); i++) {
+		Test(result.dists[i] == chdij.calcShopa(queries[i].src, queries[i].tgt, path));
+	}
+
+	Print("\n==================================");
+	Print("TEST: BatchQuery test successful.");
+	Print("==================================\n");
+}
+
+void unit_tests::testCHGraphFromFile()
+{
+	Print("\n======================================");
+	Print("TEST: Start CHGraph from file test.");
+	Print("======================================\n");
+
+	typedef CHEdge<OSMEdge> Shortcut;
+	typedef CHGraph<OSMNode, OSMEdge> CHGraphOSM;
+
+	/* Init normal graph */
+	Graph<OSMNode, OSMEdge> g;
+	g.init(FormatSTD::Reader::readGraph<OSMNode, OSMEdge>("../test_data/15kSZHK.txt"));
+
+	/* Build and export CH */
+	{
+		CHGraphOSM chg;
+		chg.init(FormatSTD::Reader::readGraph<OSMNode, Shortcut>("../test_data/15kSZHK.txt"));
+
+		CHConstructor<OSMNode, OSMEdge> chc(chg, 2);
+		std::vector<NodeID> all_nodes(chg.getNrOfNodes());
+		for (NodeID i(0); i<all_nodes.size(); i++) {
+			all_nodes[i] = i;
+		}
+		chc.quickContract(all_nodes, 4, 5);
+		chc.contract(all_nodes);
+
+		/* the header and nodes are written while another thread exports the edges */
+		auto const data(chg.getExportData());
+		EdgeID const nr_of_edges(chg.getNrOfExportEdges());
+		std::promise<void> edges_exported;
+		std::shared_future<void> edges_ready(edges_exported.get_future());
+		std::thread exporter([&chg, &edges_exported] {
+			chg.exportData();
+			edges_exported.set_value();
+		});
+		writeCHGraphFile<FormatFMI_CH::Writer>("../out/ch_15kSZHK_fmi_ch.txt", data, nr_of_edges,
+				[&edges_ready] { edges_ready.wait(); });
+		exporter.join();
+		Test(data.edges.size() == nr_of_edges && nr_of_edges > g.getNrOfEdges());
+	}
+
+	/* Read it back */
+	CHGraphOSM chg;
+	chg.initCH(readGraph<CHNode<OSMNode>, Shortcut>(FileFormat::FMI_CH, "../out/ch_15kSZHK_fmi_ch.txt"));
+	Test(chg.getNrOfNodes() == g.getNrOfNodes());
+	for (NodeID node(0); node<chg.getNrOfNodes(); node++) {
+		Test(c::NO_LVL != chg.getLevel(node));
+	}
+	for (EdgeID edge_id(0); edge_id<chg.getNrOfEdges(); edge_id++) {
+		Shortcut const& edge(chg.getEdge(edge_id));
+		Test(edge.id == edge_id);
+		if (c::NO_EID != edge.child_edge1) {
+			Test(chg.getEdge(edge.child_edge1).tgt == edge.center_node);
+			Test(chg.getEdge(edge.child_edge2).src == edge.center_node);
+		}
+	}
+
+	Dijkstra<OSMNode, OSMEdge> dij(g);
+	CHDijkstra<OSMNode, OSMEdge> chdij(chg);
+	ShortcutUnpacker<OSMNode, OSMEdge> unpacker(chg);
+
+	std::default_random_engine gen(std::chrono::system_clock::now().time_since_epoch().count());
+	std::uniform_int_distribution<uint> dist(0,g.getNrOfNodes()-1);
+	auto rand_node = std::bind (dist, gen);
+	std::vector<EdgeID> path, dij_path;
+	for (uint i(0); i<100; i++) {
+		NodeID src = rand_node();
+		NodeID tgt = rand_node();
+		uint ch_dist(chdij.calcShopa(src, tgt, path));
+		Test(dij.calcShopa(src, tgt, dij_path) == ch_dist);
+		if (c::NO_DIST == ch_dist) continue;
+
+		auto nodes(unpacker.unpackPathNodeIDs(src, path));
+		Test(nodes.front() == src && nodes.back() == tgt);
+	}
+
+	Print("\n===========================================");
+	Print("TEST: CHGraph from file test successful.");
+	Print("===========================================\n");
+}
+
+void unit_tests::testBinaryCH()
+{
+	Print("\n=============================");
+	Print("TEST: Start binary CH test.");
+	Print("=============================\n");
+
+	typedef CHEdge<OSMEdge> Shortcut;
+	typedef CHGraph<OSMNode, OSMEdge> CHGraphOSM;
+
+	Graph<OSMNode, OSMEdge> g;
+	g.init(FormatSTD::Reader::readGraph<OSMNode, OSMEdge>("../test_data/15kSZHK.txt"));
+
+	/* Build and export CH */
+	CHGraphOSM chg;
+	chg.init(FormatSTD::Reader::readGraph<OSMNode, Shortcut>("../test_data/15kSZHK.txt"));
+	buildCH(chg, 2);
+	auto data(chg.exportData());
+	data.meta_data["Test"] = "binary";
+	writeCHGraphFile(FileFormat::BINARY_CH, "../out/ch_15kSZHK.bin", data);
+
+	/* Compare the mapped sections with the exported data */
+	FormatBINARY_CH::MappedCH mapped("../out/ch_15kSZHK.bin");
+	Test(mapped.getNrOfNodes() == data.nodes.size());
+	Test(mapped.getNrOfEdges() == data.edges.size());
+	Test(mapped.metaData()["Test"] == "binary");
+	for (NodeID node(0); node<mapped.getNrOfNodes(); node++) {
+		auto const& node_data(data.nodes[node]);
+		auto const mapped_node(mapped.getNode(node));
+		Test(mapped_node.id == node && mapped_node.osm_id == node_data.osm_id);
+		Test(mapped_node.lat == node_data.lat && mapped_node.lon == node_data.lon);
+		Test(mapped_node.lvl == data.node_levels[node] && mapped.levels().begin()[node] == data.node_levels[node]);
+	}
+	for (EdgeID edge_id(0); edge_id<mapped.getNrOfEdges(); edge_id++) {
+		auto const& edge(data.edges[edge_id]);
+		auto const mapped_edge(mapped.getEdge(edge_id));
+		Test(mapped.edges().begin()[edge_id].id == edge_id);
+		Test(equalEndpoints(edge, mapped_edge) && edge.dist == mapped_edge.dist);
+		Test(edge.child_edge1 == mapped_edge.child_edge1 && edge.child_edge2 == mapped_edge.child_edge2);
+	}
+	size_t nr_of_in_edges(0);
+	for (NodeID node(0); node<mapped.getNrOfNodes(); node++) {
+		for (auto const& edge: mapped.nodeEdges(node, EdgeType::OUT)) {
+			Test(edge.src == node);
+		}
+		for (auto const& edge: mapped.nodeEdges(node, EdgeType::IN)) {
+			Test(edge.tgt == node);
+			Test(equalEndpoints(edge, mapped.edges().begin()[edge.id]));
+			nr_of_in_edges++;
+		}
+	}
+	Test(nr_of_in_edges == mapped.getNrOfEdges());
+
+	/* Load it as CH and query */
+	CHGraphOSM loaded;
+	loaded.initCH(readGraph<CHNode<OSMNode>, Shortcut>(FileFormat::BINARY_CH, "../out/ch_15kSZHK.bin"));
+	Test(loaded.getNrOfNodes() == g.getNrOfNodes());
+
+	Dijkstra<OSMNode, OSMEdge> dij(g);
+	CHDijkstra<OSMNode, OSMEdge> chdij(loaded);
+
+	/* and query the mapped file directly */
+	CHDijkstra<OSMNode, OSMEdge, FormatBINARY_CH::MappedCH> mapped_chdij(mapped);
+	ShortcutUnpacker<OSMNode, OSMEdge, FormatBINARY_CH::MappedCH> mapped_unpacker(mapped, 16);
+
+	std::default_random_engine gen(std::chrono::system_clock::now().time_since_epoch().count());
+	std::uniform_int_distribution<uint> dist(0,g.getNrOfNodes()-1);
+	auto rand_node = std::bind (dist, gen);
+	std::vector<EdgeID> path;
+	for (uint i(0); i<100; i++) {
+		NodeID src = rand_node();
+		NodeID tgt = rand_node();
+		uint const ch_dist(dij.calcShopa(src, tgt, path));
+		Test(ch_dist == chdij.calcShopa(src, tgt, path));
+		Test(ch_dist == mapped_chdij.calcShopa(src, tgt, path));
+		if (c::NO_DIST == ch_dist) continue;
+
+		uint unpacked_dist(0);
+		auto nodes(mapped_unpacker.unpackPathNodeIDs(src, path));
+		for (EdgeID edge_id: mapped_unpacker.unpackPath(path)) {
+			auto const edge(mapped.getEdge(edge_id));
+			Test(c::NO_EID == edge.child_edge1);
+			unpacked_dist += edge.distance();
+		}
+		Test(unpacked_dist == ch_dist);
+		Test(nodes.front() == src && nodes.back() == tgt);
+	}
+
+	Print("\n==================================");
+	Print("TEST: Binary CH test successful.");
+	Print("==================================\n");
+}
+
 void unit_tests::testDijkstra()
 {
 	Print("\n============================");
@@ -223,11 +1060,106 @@ void unit_tests::testDijkstra()
 		}
 	}
 
+	Print("Test that run() settles the nodes in the order of their distance.");
+	for (NodeID src(0); src<g.getNrOfNodes(); src++) {
+		std::vector<std::pair<NodeID, uint>> settled;
+		dij.run(src, [&](NodeID node, uint node_dist) {
+			Test(settled.empty() || node_dist >= settled.back().second);
+			settled.emplace_back(node, node_dist);
+		});
+		Test(!settled.empty() && settled.front().first == src);
+		for (auto const& node_dist: settled) {
+			Test(node_dist.second == dij.calcShopa(src, node_dist.first, path));
+		}
+	}
+
 	Print("\n=================================");
 	Print("TEST: Dijkstra test successful.");
 	Print("=================================\n");
 }
 
+void unit_tests::testALT()
+{
+	Print("\n=======================");
+	Print("TEST: Start ALT test.");
+	Print("=======================\n");
+
+	Graph<OSMNode, OSMEdge> g;
+	g.init(FormatSTD::Reader::readGraph<OSMNode, OSMEdge>("../test_data/15kSZHK.txt"));
+
+	std::default_random_engine gen(std::chrono::system_clock::now().time_since_epoch().count());
+	std::uniform_int_distribution<uint> dist(0,g.getNrOfNodes()-1);
+	auto rand_node = std::bind (dist, gen);
+
+	Dijkstra<OSMNode, OSMEdge> dij(g);
+	std::vector<EdgeID> path;
+
+	for (uint s(0); s <= static_cast<uint>(LastLandmarkSelection); s++) {
+		LandmarkSelection const selection(static_cast<LandmarkSelection>(s));
+		Print("Test landmark selection " << to_string(selection) << ".");
+		LandmarkTable table(selectLandmarks(g, 8, selection, rand_node()));
+		auto const& landmarks(table.getLandmarks());
+		Test(landmarks.size() == 8);
+		Test(std::set<NodeID>(landmarks.begin(), landmarks.end()).size() == landmarks.size());
+
+		Print("Test the table and the bounds against Dijkstra.");
+		for (size_t l(0); l < landmarks.size(); l++) {
+			NodeID const node(rand_node());
+			Test(table.dist(l, node, EdgeType::OUT) == dij.calcShopa(landmarks[l], node, path));
+			Test(table.dist(l, node, EdgeType::IN) == dij.calcShopa(node, landmarks[l], path));
+		}
+
+		ALT<OSMNode, OSMEdge> alt(g, table);
+		size_t alt_settled(0);
+		size_t dij_settled(0);
+		for (uint i(0); i < 100; i++) {
+			NodeID const src(rand_node());
+			NodeID const tgt(rand_node());
+			uint const dij_dist(dij.calcShopa(src, tgt, path));
+			dij_settled += dij.getStats().settled_nodes;
+			Test(table.lowerBound(src, tgt) <= dij_dist);
+
+			uint const alt_dist(alt.calcShopa(src, tgt, path));
+			alt_settled += alt.getStats().settled_nodes;
+			Test(alt_dist == dij_dist);
+			if (alt_dist != c::NO_DIST) {
+				uint length(0);
+				NodeID node(src);
+				for (auto edge_id: path) {
+					auto const& edge(g.getEdge(edge_id));
+					Test(edge.src == node);
+					length += edge.distance();
+					node = edge.tgt;
+				}
+				Test(node == tgt && length == alt_dist);
+			}
+		}
+		Print("Settled nodes: ALT " << alt_settled << ", Dijkstra " << dij_settled);
+		Test(alt_settled < dij_settled);
+		Test(alt.calcShopa(landmarks[0], landmarks[0], path) == 0);
+
+		Print("Test writing and reading the table.");
+		std::string const filename("../out/alt_test.landmarks");
+		{
+			std::ofstream os(filename, std::ios::binary);
+			table.write(os);
+		}
+		LandmarkTable read_table(LandmarkTable::read(filename));
+		std::remove(filename.c_str());
+		Test(read_table.getNrOfNodes() == table.getNrOfNodes());
+		Test(read_table.getLandmarks() == landmarks);
+		for (uint i(0); i < 100; i++) {
+			NodeID const src(rand_node());
+			NodeID const tgt(rand_node());
+			Test(read_table.lowerBound(src, tgt) == table.lowerBound(src, tgt));
+		}
+	}
+
+	Print("\n============================");
+	Print("TEST: ALT test successful.");
+	Print("============================\n");
+}
+
 void unit_tests::testPrioritizers()
 {
 	Print("\n=============================");
@@ -287,4 +1219,167 @@ void unit_tests::testPrioritizers()
 	Print("==================================\n");
 }
 
+void unit_tests::testMetrics()
+{
+	Print("\n=========================");
+	Print("TEST: Start Metrics test.");
+	Print("=========================\n");
+
+	typedef CHEdge<OSMEdge> Shortcut;
+	typedef CHGraph<OSMNode, OSMEdge> CHGraphOSM;
+
+	std::string const infile("../test_data/15kSZHK_fmi.txt");
+	auto data(calcMetrics(readGraph<OSMNode, OSMEdge>(FileFormat::FMI_DIST, infile)));
+
+	Print("Test that the metrics equal the ones of separate reads.");
+	auto dist_data(readGraph<OSMNode, Shortcut>(FileFormat::FMI_DIST, infile));
+	auto time_data(readGraph<OSMNode, Shortcut>(FileFormat::FMI, infile));
+	auto dist_metric(selectMetric<OSMNode>(data, Metric::DIST));
+	auto time_metric(selectMetric<OSMNode>(data, Metric::TIME));
+	Test(dist_metric.nodes.size() == dist_data.nodes.size());
+	Test(dist_metric.edges.size() == dist_data.edges.size() && time_metric.edges.size() == time_data.edges.size());
+	for (size_t i(0); i < data.edges.size(); i++) {
+		Test(dist_metric.edges[i].src == dist_data.edges[i].src && dist_metric.edges[i].tgt == dist_data.edges[i].tgt);
+		Test(dist_metric.edges[i].dist == dist_data.edges[i].dist);
+		Test(time_metric.edges[i].dist == time_data.edges[i].dist);
+	}
+	Test(toMetrics("DIST,TIME") == std::vector<Metric>({Metric::DIST, Metric::TIME}));
+
+	Print("Test contracting the TIME metric in the order of the DIST CH.");
+	std::vector<NodeID> all_nodes(data.nodes.size());
+	for (NodeID i(0); i<all_nodes.size(); i++) {
+		all_nodes[i] = i;
+	}
+
+	CHGraphOSM dist_chg;
+	dist_chg.init(std::move(dist_metric));
+	{
+		CHConstructor<OSMNode, OSMEdge> chc(dist_chg, 2);
+		std::vector<NodeID> nodes(all_nodes);
+		chc.quickContract(nodes, 4, 5);
+		chc.contract(nodes);
+	}
+	std::vector<uint> dist_levels(dist_chg.exportData().node_levels);
+
+	Graph<OSMNode, OSMEdge> g;
+	g.init(selectMetric<OSMNode, OSMEdge>(data, Metric::TIME));
+	CHGraphOSM chg;
+	chg.init(std::move(time_metric));
+	CHConstructor<OSMNode, OSMEdge> chc(chg, 2);
+	LevelPrioritizer<CHGraphOSM, CHConstructor<OSMNode, OSMEdge>> prioritizer(chg, chc, dist_levels);
+	chc.contract(all_nodes, prioritizer);
+	chc.rebuildCompleteGraph();
+
+	/* nodes only move to later levels when they had to be deferred */
+	for (NodeID node(0); node < g.getNrOfNodes(); node++) {
+		Test(chg.getLevel(node) != c::NO_LVL && chg.getLevel(node) >= dist_levels[node]);
+	}
+
+	Dijkstra<OSMNode, OSMEdge> dij(g);
+	CHDijkstra<OSMNode, OSMEdge> chdij(chg);
+	std::default_random_engine gen(std::chrono::system_clock::now().time_since_epoch().count());
+	std::uniform_int_distribution<uint> dist(0,g.getNrOfNodes()-1);
+	auto rand_node = std::bind (dist, gen);
+	std::vector<EdgeID> path;
+	for (uint i(0); i<1000; i++) {
+		NodeID src = rand_node();
+		NodeID tgt = rand_node();
+		Test(dij.calcShopa(src,tgt,path) == chdij.calcShopa(src,tgt,path));
+	}
+
+	Print("\n==============================");
+	Print("TEST: Metrics test successful.");
+	Print("==============================\n");
+}
+
+void unit_tests::testCCH()
+{
+	Print("\n=======================");
+	Print("TEST: Start CCH test.");
+	Print("=======================\n");
+
+	auto data(FormatSTD::Reader::readGraph<OSMNode, OSMEdge>("../test_data/15kSZHK.txt"));
+	/* a second metric, as after a traffic update */
+	auto changed_data(data);
+	for (auto& edge: changed_data.edges) {
+		edge.dist = edge.dist * (1 + edge.id % 3) + 1;
+	}
+
+	Graph<OSMNode, OSMEdge> g;
+	g.init(std::move(data));
+	Graph<OSMNode, OSMEdge> changed_g;
+	changed_g.init(std::move(changed_data));
+
+	auto order(calcNestedDissectionOrder(g));
+	Test(order.size() == g.getNrOfNodes());
+	Test(std::set<NodeID>(order.begin(), order.end()).size() == order.size());
+
+	CCHTopology topology;
+	topology.init(g, order);
+	Print("Topology: " << topology.getNrOfArcs() << " arcs, " << topology.getNrOfLevels() << " levels.");
+	Test(topology.getNrOfInputEdges() == g.getNrOfEdges());
+
+	/* the upward neighbours of a node are ancestors of it */
+	for (uint rank(0); rank < topology.getNrOfNodes(); rank++) {
+		uint ancestor(topology.parent(rank));
+		for (uint arc(topology._up_offsets[rank]); arc < topology._up_offsets[rank + 1]; arc++) {
+			while (ancestor != c::NO_NID && ancestor < topology._up_heads[arc]) {
+				ancestor = topology.parent(ancestor);
+			}
+			Test(ancestor == topology._up_heads[arc]);
+		}
+	}
+
+	Print("Test writing and reading the topology.");
+	std::string const filename("../out/cch_test.cch");
+	{
+		std::ofstream os(filename, std::ios::binary);
+		topology.write(os);
+	}
+	CCHTopology read_topology(CCHTopology::read(filename));
+	std::remove(filename.c_str());
+	Test(read_topology._node == topology._node);
+	Test(read_topology._up_heads == topology._up_heads);
+	Test(read_topology._down_offsets == topology._down_offsets);
+	Test(read_topology._level_nodes == topology._level_nodes);
+	Test(read_topology._input_arcs == topology._input_arcs);
+
+	std::default_random_engine gen(std::chrono::system_clock::now().time_since_epoch().count());
+	std::uniform_int_distribution<uint> dist(0,g.getNrOfNodes()-1);
+	auto rand_node = std::bind (dist, gen);
+	std::vector<EdgeID> path;
+
+	for (auto const* graph: {&g, &changed_g}) {
+		Print("Test the customized metric against Dijkstra.");
+		CCHMetric metric(read_topology, edgeWeights(*graph));
+		CCHMetric metric2(topology, edgeWeights(*graph));
+		Test(metric._up == metric2._up && metric._down == metric2._down);
+
+		Dijkstra<OSMNode, OSMEdge> dij(*graph);
+		CCHQuery query(read_topology, metric);
+		for (uint i(0); i < 1000; i++) {
+			NodeID const src(rand_node());
+			NodeID const tgt(rand_node());
+			uint const cch_dist(query.calcShopa(src, tgt, path));
+			Test(cch_dist == dij.calcShopa(src, tgt, path));
+			if (cch_dist != c::NO_DIST) {
+				uint length(0);
+				NodeID node(src);
+				for (auto edge_id: path) {
+					auto const& edge(graph->getEdge(edge_id));
+					Test(edge.src == node);
+					length += edge.distance();
+					node = edge.tgt;
+				}
+				Test(node == tgt && length == cch_dist);
+			}
+		}
+		Test(query.calcShopa(0, 0, path) == 0 && path.empty());
+	}
+
+	Print("\n==========================");
+	Print("TEST: CCH test successful.");
+	Print("==========================\n");
+}
+
 }